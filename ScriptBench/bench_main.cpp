@@ -0,0 +1,633 @@
+﻿//!
+//! @file bench_main.cpp
+//!
+//! @brief ベンチマークツールのエントリーポイント
+//!
+//! @details
+//! 使い方: ScriptBench [オプション]
+//!
+//! --scenario ファイル  計測に使用するスクリプト(省略時は自動生成する)
+//! --generate ファイル  自動生成したスクリプトの保存先(既定値 bench_scenario.json)
+//! --lines 数           自動生成するスクリプトの行数
+//! --label-density 値   自動生成するスクリプトの 1 行あたりのラベルの割合
+//! --choices 数         自動生成するスクリプトの選択肢の数
+//! --images 数          自動生成するスクリプトの画像の数
+//! --seed 値            自動生成に使用する乱数の種
+//! --samples 数         1 つのベンチマークの計測回数
+//! --filter 文字列      名前に文字列を含むベンチマークのみ計測する
+//! --json ファイル      計測結果を Json ファイルに保存する
+//! --counters          ハードウェアパフォーマンスカウンタも計測する(perf_counter.cpp 参照)
+//! --baseline ファイル  --json で保存した基準の計測結果と比較する(regression_gate.cpp 参照)
+//! --threshold 値       劣化と判定する処理時間の増加率(既定値 0.05)
+//! --alpha 値           劣化と判定する有意水準(既定値 0.01)
+//! --replay ファイル    記録した入力(input_record.cpp 参照)を再生する Replay も計測する(複数指定可)
+//!
+//! 基準と比較した場合、LoadJson、Parsing、Render、Replay のいずれかが劣化していたら 1 を返します。
+//! 比較結果には全ベンチマークの中央値の比の幾何平均を speedup として出力します。
+//!
+//! Render はヘッドレス用の DxWrapper に対して計測するので
+//! DX ライブラリの描画時間は含まず、エンジン側の処理時間のみになります。
+//! RenderSprites は数百枚の画像を RenderList に記録して描画し
+//! 同じ画像の描画をまとめる処理の時間と描画関数の呼び出し回数を計測します。
+//! RenderSpritesNpot は 2 のべき乗でない大きさ(テクスチャに余白がある)の画像で同じ計測をします。
+//!
+#include "benchmark.h"
+#include "headless_runner.h"
+#include "input_record.h"
+#include "perf_counter.h"
+#include "regression_gate.h"
+#include "scenario_generator.h"
+#include "script_engine_probe.h"
+#include "script_listener.h"
+#include "scripts_data.h"
+#include "dx_wrapper.h"
+#include "dx_headless.h"
+#include "render_list.h"
+#include "amg_string.h"
+#include "picojson.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace {
+    constexpr auto DEFAULT_SCENARIO_PATH = "bench_scenario.json";
+    constexpr auto SCRIPT_DELIMITER = ", ";
+
+    constexpr auto LOOKUP_NAME_MAX = 1024U;
+    constexpr auto MESSAGE_REVEAL_REPEAT = 100U;
+    constexpr auto RENDER_REPEAT = 1000U;
+
+    // RenderSprites の画像の配置(SPRITE_COLUMNS x SPRITE_ROWS 枚を SPRITE_STEP 間隔で並べる)
+    constexpr auto SPRITE_TEXTURE_NUM = 4;
+    constexpr auto SPRITE_COLUMNS = 32;
+    constexpr auto SPRITE_ROWS = 16;
+    constexpr auto SPRITE_STEP = 40;
+    constexpr auto SPRITE_SIZE = 32;
+    constexpr auto SPRITE_NPOT_WIDTH = 36;
+    constexpr auto SPRITE_NPOT_HEIGHT = 20;
+    constexpr auto SPRITE_REPEAT = 100U;
+
+    // 選択肢の移動でループするスクリプトでも終わる様に打ち切る
+    constexpr auto PARSING_WAIT_MAX_RATE = 4U;
+
+    struct Options
+    {
+        std::string scenario_path;
+        std::string generate_path;
+        std::string json_path;
+        std::string filter;
+        std::string baseline_path;
+        std::vector<std::string> replay_paths;
+        amg::ScenarioGenerator::Parameter parameter;
+        int samples;
+        double threshold;
+        double alpha;
+        bool is_counters;
+
+        Options()
+        {
+            generate_path = DEFAULT_SCENARIO_PATH;
+            samples = 0;
+            threshold = 0.0;
+            alpha = 0.0;
+            is_counters = false;
+        }
+    };
+
+    //!
+    //! @brief 処理した行数を数えるリスナー
+    //!
+    class LineCounter final : public amg::ScriptListener
+    {
+    public:
+        LineCounter()
+        {
+            count = 0;
+        }
+
+        void OnParse(unsigned int line, TCHAR command) override
+        {
+            ++count;
+        }
+
+        unsigned long long count;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: ScriptBench [--scenario file] [--generate file] [--lines n] [--label-density r] [--choices n]"
+            << " [--images n] [--seed n] [--samples n] [--filter name] [--json file] [--counters]"
+            << " [--baseline file] [--threshold r] [--alpha r] [--replay file]..." << std::endl;
+    }
+
+    bool ToUnsigned(const std::string& str, unsigned int& value)
+    {
+        auto integer = 0;
+
+        if (!amg::string::ToInt(str, integer) || integer < 0) {
+            return false;
+        }
+
+        value = static_cast<unsigned int>(integer);
+
+        return true;
+    }
+
+    bool ToDouble(const std::string& str, double& value)
+    {
+        std::istringstream stream(str);
+
+        return static_cast<bool>(stream >> value) && stream.eof();
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (auto i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+
+            if (arg == "--counters") {
+                options.is_counters = true;
+                continue;
+            }
+
+            if ((i + 1) >= argc) {
+                return false;
+            }
+
+            const std::string value(argv[++i]);
+            auto is_valid = true;
+
+            if (arg == "--scenario") {
+                options.scenario_path = value;
+            }
+            else if (arg == "--generate") {
+                options.generate_path = value;
+            }
+            else if (arg == "--json") {
+                options.json_path = value;
+            }
+            else if (arg == "--filter") {
+                options.filter = value;
+            }
+            else if (arg == "--baseline") {
+                options.baseline_path = value;
+            }
+            else if (arg == "--replay") {
+                options.replay_paths.emplace_back(value);
+            }
+            else if (arg == "--threshold") {
+                is_valid = ToDouble(value, options.threshold) && options.threshold > 0.0;
+            }
+            else if (arg == "--alpha") {
+                is_valid = ToDouble(value, options.alpha) && options.alpha > 0.0 && options.alpha < 1.0;
+            }
+            else if (arg == "--lines") {
+                is_valid = ToUnsigned(value, options.parameter.lines);
+            }
+            else if (arg == "--label-density") {
+                is_valid = ToDouble(value, options.parameter.label_density);
+            }
+            else if (arg == "--choices") {
+                is_valid = ToUnsigned(value, options.parameter.choice_fan_out);
+            }
+            else if (arg == "--images") {
+                is_valid = ToUnsigned(value, options.parameter.images);
+            }
+            else if (arg == "--seed") {
+                is_valid = ToUnsigned(value, options.parameter.seed);
+            }
+            else if (arg == "--samples") {
+                is_valid = amg::string::ToInt(value, options.samples) && options.samples > 0;
+            }
+            else {
+                is_valid = false;
+            }
+
+            if (!is_valid) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //!
+    //! @brief Json ファイルからスクリプトの各行を分割せずに読み込む
+    //!
+    bool LoadScripts(const std::string& path, std::vector<std::string>& scripts)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return false;
+        }
+
+        picojson::value value;
+
+        ifs >> value;
+
+        if (!picojson::get_last_error().empty() || !value.is<picojson::array>()) {
+            return false;
+        }
+
+        scripts.clear();
+
+        for (auto&& item : value.get<picojson::array>()) {
+            if (!item.is<picojson::object>()) {
+                continue;
+            }
+
+            const auto& object = item.get<picojson::object>();
+            const auto found = object.find("scripts");
+
+            if (found == object.end() || !found->second.is<picojson::array>()) {
+                continue;
+            }
+
+            for (auto&& line : found->second.get<picojson::array>()) {
+                scripts.emplace_back(line.to_str());
+            }
+        }
+
+        return !scripts.empty();
+    }
+
+    //!
+    //! @brief 待ち状態を飛ばしながら条件を満たすまでスクリプトを進める
+    //! @return 条件を満たしたか
+    //!
+    template <typename Condition>
+    bool Advance(amg::ScriptEngine& engine, Condition condition)
+    {
+        const auto wait_max = engine.GetMaxLine() * PARSING_WAIT_MAX_RATE;
+
+        amg::ScriptEngineProbe::Restart(engine);
+
+        for (auto i = 0U; i < wait_max && !engine.IsEnd(); ++i) {
+            amg::ScriptEngineProbe::Parsing(engine);
+
+            if (condition(engine)) {
+                return true;
+            }
+
+            amg::ScriptEngineProbe::SkipWait(engine, i);
+        }
+
+        return false;
+    }
+
+    std::vector<std::string> PickNames(const std::vector<std::string>& names)
+    {
+        std::vector<std::string> picked;
+        const auto step = (names.size() > LOOKUP_NAME_MAX) ? names.size() / LOOKUP_NAME_MAX : 1;
+
+        for (size_t i = 0; i < names.size() && picked.size() < LOOKUP_NAME_MAX; i += step) {
+            picked.emplace_back(names[i]);
+        }
+
+        return picked;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<amg::Benchmark::Result> baseline;
+    std::map<std::string, double> baseline_parameters;
+
+    if (!options.baseline_path.empty() && !amg::Benchmark::LoadJson(options.baseline_path, baseline, baseline_parameters)) {
+        std::cerr << "baseline load error: " << options.baseline_path << std::endl;
+        return 1;
+    }
+
+    std::vector<amg::InputReplayer> replayers(options.replay_paths.size());
+
+    for (size_t i = 0; i < options.replay_paths.size(); ++i) {
+        if (!replayers[i].Load(options.replay_paths[i])) {
+            std::cerr << "replay load error: " << options.replay_paths[i] << std::endl;
+            return 1;
+        }
+    }
+
+    auto scenario_path = options.scenario_path;
+    std::vector<std::string> scripts;
+
+    if (scenario_path.empty()) {
+        amg::ScenarioGenerator generator(options.parameter);
+
+        generator.Generate(scripts);
+
+        if (!amg::ScenarioGenerator::SaveJson(options.generate_path, scripts)) {
+            std::cerr << "scenario save error: " << options.generate_path << std::endl;
+            return 1;
+        }
+
+        scenario_path = options.generate_path;
+    }
+    else if (!LoadScripts(scenario_path, scripts)) {
+        std::cerr << "scenario load error: " << scenario_path << std::endl;
+        return 1;
+    }
+
+    // 自動生成したスクリプトの画像ファイルは存在しないので確認しない
+    amg::DxHeadless::Reset();
+    amg::DxHeadless::SetFileCheck(false);
+    amg::DxWrapper::SetGraphMode(1280, 720, 32);
+
+    amg::ScriptEngine engine;
+    LineCounter counter;
+
+    if (!engine.Initialize(scenario_path.c_str())) {
+        std::cerr << "initialize error: " << scenario_path << std::endl;
+        return 1;
+    }
+
+    engine.SetListener(&counter);
+
+    const auto line_num = engine.GetMaxLine();
+    const auto label_num = amg::ScriptEngineProbe::GetLabelNum(engine);
+
+    std::cout << "scenario: " << scenario_path << std::endl;
+    std::cout << "lines: " << line_num << std::endl;
+    std::cout << "labels: " << label_num << std::endl;
+    std::cout << "images: " << amg::ScriptEngineProbe::GetImageNum(engine) << std::endl;
+
+    std::map<std::string, double> parameters;
+
+    parameters["lines"] = line_num;
+    parameters["labels"] = label_num;
+    parameters["label_density"] = options.parameter.label_density;
+    parameters["choice_fan_out"] = options.parameter.choice_fan_out;
+    parameters["images"] = options.parameter.images;
+    parameters["seed"] = options.parameter.seed;
+    parameters["generated"] = options.scenario_path.empty() ? 1.0 : 0.0;
+    parameters["replays"] = static_cast<double>(replayers.size());
+
+    // 条件の違う計測結果とは比較出来ない
+    for (auto&& parameter : baseline_parameters) {
+        const auto found = parameters.find(parameter.first);
+
+        if (found != parameters.end() && found->second != parameter.second) {
+            std::cerr << "baseline parameter mismatch: " << parameter.first << " " << parameter.second
+                << " != " << found->second << std::endl;
+            return 1;
+        }
+    }
+
+    amg::Benchmark benchmark;
+
+    if (options.samples > 0) {
+        benchmark.SetSamples(static_cast<unsigned int>(options.samples));
+    }
+
+    benchmark.SetFilter(options.filter);
+
+    amg::PerfCounter perf_counter;
+    const auto is_counters = options.is_counters && perf_counter.Open();
+
+    if (is_counters) {
+        benchmark.SetPerfCounter(&perf_counter);
+    }
+    else if (options.is_counters) {
+        std::cout << "counters: unavailable" << std::endl;
+    }
+
+    benchmark.Run("LoadJson", [&]() {
+        amg::ScriptsData data;
+
+        data.LoadJson(scenario_path.c_str());
+
+        return static_cast<unsigned long long>(data.GetScriptNum());
+    });
+
+    benchmark.Run("Split", [&]() {
+        auto items = 0ULL;
+
+        for (auto&& script : scripts) {
+            items += amg::string::Split(script, SCRIPT_DELIMITER).size();
+        }
+
+        return items;
+    });
+
+    benchmark.Run("PreParsing", [&]() {
+        amg::ScriptEngineProbe::PreParsing(engine);
+
+        return static_cast<unsigned long long>(line_num);
+    });
+
+    std::vector<std::string> labels;
+    std::vector<std::string> image_labels;
+
+    for (auto i = 0U; i < amg::ScriptEngineProbe::GetLabelNum(engine); ++i) {
+        labels.emplace_back(amg::ScriptEngineProbe::GetLabel(engine, i));
+    }
+
+    for (auto i = 0U; i < amg::ScriptEngineProbe::GetImageNum(engine); ++i) {
+        image_labels.emplace_back(amg::ScriptEngineProbe::GetImageLabel(engine, i));
+    }
+
+    labels = PickNames(labels);
+    image_labels = PickNames(image_labels);
+
+    benchmark.Run("LabelLookup", [&]() {
+        auto line = 0U;
+
+        for (auto&& label : labels) {
+            amg::ScriptEngineProbe::GetLineNumber(engine, label, line);
+        }
+
+        return static_cast<unsigned long long>(labels.size());
+    });
+
+    benchmark.Run("ImageLookup", [&]() {
+        auto handle = 0;
+
+        for (auto&& label : image_labels) {
+            amg::ScriptEngineProbe::GetImageHandle(engine, label, handle);
+        }
+
+        return static_cast<unsigned long long>(image_labels.size());
+    });
+
+    // 全ての待ちを入力無しで飛ばしてスクリプトの終端まで処理する
+    benchmark.Run("Parsing", [&]() {
+        counter.count = 0;
+        Advance(engine, [](const amg::ScriptEngine&) { return false; });
+
+        return counter.count;
+    });
+
+    engine.SetListener(nullptr);
+
+    const auto has_message = Advance(engine, [](const amg::ScriptEngine& target) {
+        return target.GetState() == amg::ScriptEngine::ScriptState::CLICK_WAIT &&
+            amg::ScriptEngineProbe::GetMessageNum(target) > 0;
+    });
+
+    if (has_message) {
+        benchmark.Run("UpdateMessage", [&]() {
+            auto frames = 0ULL;
+
+            for (auto i = 0U; i < MESSAGE_REVEAL_REPEAT; ++i) {
+                amg::ScriptEngineProbe::ResetMessageReveal(engine);
+
+                while (amg::ScriptEngineProbe::IsMessageOutput(engine)) {
+                    amg::ScriptEngineProbe::UpdateMessage(engine);
+                    ++frames;
+                }
+            }
+
+            return frames;
+        });
+    }
+
+    // 選択肢が表示される画面(無ければ最後の待ち)が最も描画する物が多い
+    Advance(engine, [](const amg::ScriptEngine& target) {
+        return target.GetState() == amg::ScriptEngine::ScriptState::CHOICE_WAIT;
+    });
+
+    benchmark.Run("Render", [&]() {
+        for (auto i = 0U; i < RENDER_REPEAT; ++i) {
+            engine.Render();
+        }
+
+        return static_cast<unsigned long long>(RENDER_REPEAT);
+    });
+
+    engine.Destroy();
+
+    // 数百枚の画像(数種類の画像を交互に並べる)を描画する
+    // (2 のべき乗でない大きさの画像も DrawGraphs() でまとめて描画出来るか確認する)
+    {
+        struct SpriteCase
+        {
+            const char* name;
+            int width;
+            int height;
+        };
+
+        const SpriteCase sprite_cases[] = {
+            { "RenderSprites", SPRITE_SIZE, SPRITE_SIZE },
+            { "RenderSpritesNpot", SPRITE_NPOT_WIDTH, SPRITE_NPOT_HEIGHT },
+        };
+
+        auto screen_width = 0;
+        auto screen_height = 0;
+        auto screen_depth = 0;
+
+        amg::DxWrapper::GetScreenState(&screen_width, &screen_height, &screen_depth);
+
+        for (auto&& sprite_case : sprite_cases) {
+            amg::RenderList render_list;
+            std::vector<int> textures;
+
+            render_list.Initialize(screen_width, screen_height);
+
+            for (auto i = 0; i < SPRITE_TEXTURE_NUM; ++i) {
+                textures.emplace_back(amg::DxWrapper::MakeScreen(sprite_case.width, sprite_case.height, amg::DxWrapper::TRUE));
+            }
+
+            benchmark.Run(sprite_case.name, [&]() {
+                auto sprites = 0ULL;
+
+                for (auto i = 0U; i < SPRITE_REPEAT; ++i) {
+                    render_list.Begin(amg::RenderList::Layer::IMAGE);
+
+                    for (auto y = 0; y < SPRITE_ROWS; ++y) {
+                        for (auto x = 0; x < SPRITE_COLUMNS; ++x) {
+                            const auto texture = textures[(x + y) % SPRITE_TEXTURE_NUM];
+
+                            render_list.DrawGraph(x * SPRITE_STEP, y * SPRITE_STEP, texture);
+                            ++sprites;
+                        }
+                    }
+
+                    render_list.Flush();
+                }
+
+                return sprites;
+            });
+
+            std::cout << "sprites: " << sprite_case.width << "x" << sprite_case.height << " " << SPRITE_COLUMNS * SPRITE_ROWS
+                << " draw_calls=" << render_list.GetStats().draw_calls
+                << " batched=" << render_list.GetStats().batched_graphs << std::endl;
+
+            for (auto&& texture : textures) {
+                amg::DxWrapper::DeleteGraph(texture);
+            }
+        }
+    }
+
+    // 記録した実際のプレイの入力を画面無しで再生する(毎回エンジンの初期化と Render() も含む)
+    if (!replayers.empty()) {
+        amg::HeadlessRunner runner;
+        amg::InputScript input;
+        amg::HeadlessRunner::Result result;
+        auto is_initialized = true;
+
+        benchmark.Run("Replay", [&]() {
+            auto frames = 0ULL;
+
+            for (auto&& replayer : replayers) {
+                runner.SetReplayer(&replayer);
+                runner.Run(scenario_path.c_str(), input, result);
+
+                is_initialized &= (result.reason != amg::HeadlessRunner::StopReason::INITIALIZE_ERROR);
+                frames += result.frames;
+            }
+
+            return frames;
+        });
+
+        if (!is_initialized) {
+            std::cerr << "replay error: " << scenario_path << " can not be initialized" << std::endl;
+            return 1;
+        }
+    }
+
+    benchmark.Print(std::cout);
+
+    if (is_counters) {
+        std::cout << std::endl;
+        benchmark.PrintCounters(std::cout);
+    }
+
+    if (!options.json_path.empty() && !benchmark.SaveJson(options.json_path, parameters)) {
+        std::cerr << "json save error: " << options.json_path << std::endl;
+        return 1;
+    }
+
+    if (options.baseline_path.empty()) {
+        return 0;
+    }
+
+    amg::RegressionGate gate;
+    std::vector<amg::RegressionGate::Comparison> comparisons;
+
+    if (options.threshold > 0.0) {
+        gate.SetThreshold(options.threshold);
+    }
+
+    if (options.alpha > 0.0) {
+        gate.SetAlpha(options.alpha);
+    }
+
+    const auto is_pass = gate.Compare(baseline, benchmark.GetResults(), comparisons);
+
+    std::cout << std::endl;
+    amg::RegressionGate::Print(std::cout, comparisons);
+    std::cout << "speedup: " << amg::RegressionGate::Speedup(comparisons) << "x" << std::endl;
+    std::cout << "regression: " << (is_pass ? "no" : "yes") << std::endl;
+
+    return is_pass ? 0 : 1;
+}
@@ -0,0 +1,437 @@
+﻿//!
+//! @file benchmark.cpp
+//!
+//! @brief ベンチマークの計測と集計を行うクラス実装
+//!
+#include "benchmark.h"
+#include "memory_counter.h"
+#include "picojson.h"
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    constexpr auto DEFAULT_SAMPLES = 30U;
+    constexpr auto WARMUP_RUNS = 1U;
+
+    using Clock = std::chrono::steady_clock;
+
+    double Percentile(const std::vector<double>& sorted, const double percent)
+    {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        // 線形補間した百分位数
+        const auto position = (sorted.size() - 1) * percent / 100.0;
+        const auto index = static_cast<size_t>(position);
+        const auto fraction = position - index;
+
+        if (index + 1 >= sorted.size()) {
+            return sorted.back();
+        }
+
+        return sorted[index] + (sorted[index + 1] - sorted[index]) * fraction;
+    }
+}
+
+namespace amg
+{
+    Benchmark::Benchmark()
+    {
+        samples = DEFAULT_SAMPLES;
+        perf_counter = nullptr;
+    }
+
+    //!
+    //! @fn bool Benchmark::Run(const std::string& name, const Body& body)
+    //! @brief ベンチマークを計測する
+    //! @param[in] name ベンチマーク名
+    //! @param[in] body 計測する処理(処理した要素数を返す)
+    //! @return 計測したか(フィルタで除外された場合は false)
+    //!
+    bool Benchmark::Run(const std::string& name, const Body& body)
+    {
+        return Run(name, nullptr, body);
+    }
+
+    //!
+    //! @fn bool Benchmark::Run(const std::string& name, const Setup& setup, const Body& body)
+    //! @brief 計測毎に準備処理を行うベンチマークを計測する
+    //! @param[in] name ベンチマーク名
+    //! @param[in] setup 計測毎の準備処理(計測時間に含まない)
+    //! @param[in] body 計測する処理(処理した要素数を返す)
+    //! @return 計測したか(フィルタで除外された場合は false)
+    //!
+    bool Benchmark::Run(const std::string& name, const Setup& setup, const Body& body)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return false;
+        }
+
+        Result result;
+        PerfCounter::Values values;
+        std::vector<double> counter_samples[PerfCounter::TYPE_NUM];
+        std::vector<double> alloc_samples;
+
+        result.name = name;
+        result.samples_ns.reserve(samples);
+
+        // 前のベンチマークの使用量を含めない様に、計測前の使用量からの増加を記録する
+        const auto resident_start = MemoryCounter::GetResident();
+        const auto is_peak_reset = MemoryCounter::ResetPeakResident();
+        auto resident_max = resident_start;
+
+        for (auto i = 0U; i < WARMUP_RUNS + samples; ++i) {
+            if (setup) {
+                setup();
+            }
+
+            // カウンタの読み取りは計測時間に含めない
+            if (perf_counter != nullptr) {
+                perf_counter->Start();
+            }
+
+            const auto alloc_start = MemoryCounter::GetAllocCount();
+            const auto start = Clock::now();
+            const auto items = body();
+            const auto end = Clock::now();
+            const auto alloc_end = MemoryCounter::GetAllocCount();
+
+            if (perf_counter != nullptr) {
+                perf_counter->Stop(values);
+            }
+
+            resident_max = std::max(resident_max, MemoryCounter::GetResident());
+
+            // 最初の数回はキャッシュなどが温まっていないので捨てる
+            if (i < WARMUP_RUNS) {
+                continue;
+            }
+
+            result.items = items;
+            result.samples_ns.emplace_back(std::chrono::duration<double, std::nano>(end - start).count());
+            alloc_samples.emplace_back(static_cast<double>(alloc_end - alloc_start));
+
+            for (auto type = 0U; type < PerfCounter::TYPE_NUM; ++type) {
+                if (perf_counter != nullptr && values.is_available[type]) {
+                    counter_samples[type].emplace_back(values.value[type]);
+                }
+            }
+        }
+
+        result.statistics = Calculate(result.samples_ns);
+
+        // 時間と同じく外れ値に強い中央値を使用する
+        for (auto type = 0U; type < PerfCounter::TYPE_NUM; ++type) {
+            result.counters.is_available[type] = !counter_samples[type].empty();
+            result.counters.value[type] = Calculate(counter_samples[type]).median;
+        }
+
+        if (result.statistics.median > 0.0) {
+            result.items_per_second = result.items * 1.0e9 / result.statistics.median;
+        }
+
+        if (result.items > 0) {
+            result.allocs_per_item = Calculate(alloc_samples).median / result.items;
+        }
+
+        // 最大値を戻せない環境(Windows)は計測毎の使用量の最大値で代用する(計測中の一時的な増加は含まない)
+        if (is_peak_reset) {
+            resident_max = std::max(resident_max, MemoryCounter::GetPeakResident());
+        }
+
+        result.resident_growth = (resident_max > resident_start) ? static_cast<double>(resident_max - resident_start) : 0.0;
+
+        results.emplace_back(std::move(result));
+
+        return true;
+    }
+
+    //!
+    //! @fn void Benchmark::Print(std::ostream& stream) const
+    //! @brief 計測結果を表形式で出力する
+    //! @param[in] stream 出力先
+    //!
+    void Benchmark::Print(std::ostream& stream) const
+    {
+        stream << std::left << std::setw(24) << "benchmark" << std::right
+            << std::setw(12) << "items"
+            << std::setw(14) << "median(us)"
+            << std::setw(14) << "p90(us)"
+            << std::setw(14) << "p99(us)"
+            << std::setw(14) << "stddev(us)"
+            << std::setw(16) << "items/s" << std::endl;
+
+        for (auto&& result : results) {
+            const auto& statistics = result.statistics;
+
+            stream << std::left << std::setw(24) << result.name << std::right << std::fixed << std::setprecision(2)
+                << std::setw(12) << result.items
+                << std::setw(14) << statistics.median / 1000.0
+                << std::setw(14) << statistics.p90 / 1000.0
+                << std::setw(14) << statistics.p99 / 1000.0
+                << std::setw(14) << statistics.stddev / 1000.0
+                << std::setw(16) << std::setprecision(0) << result.items_per_second << std::endl;
+        }
+
+        stream.unsetf(std::ios::floatfield);
+        stream << std::setprecision(6);
+    }
+
+    //!
+    //! @fn void Benchmark::PrintCounters(std::ostream& stream) const
+    //! @brief パフォーマンスカウンタを 1 要素あたりの値で表形式で出力する
+    //! @param[in] stream 出力先
+    //! @details ページフォルトのみ 1 回の計測あたりの値です。
+    //! 読み取れなかったカウンタは '-' を出力します。
+    //!
+    void Benchmark::PrintCounters(std::ostream& stream) const
+    {
+        stream << std::left << std::setw(24) << "benchmark" << std::right
+            << std::setw(14) << "cycles/item"
+            << std::setw(14) << "instr/item"
+            << std::setw(8) << "IPC"
+            << std::setw(14) << "cache-miss"
+            << std::setw(14) << "branch-miss"
+            << std::setw(14) << "faults/run" << std::endl;
+
+        stream << std::fixed << std::setprecision(2);
+
+        for (auto&& result : results) {
+            const auto& counters = result.counters;
+            const auto items = (result.items > 0) ? static_cast<double>(result.items) : 1.0;
+            const auto print = [&](const PerfCounter::Type type, const double divisor) {
+                const auto index = static_cast<unsigned int>(type);
+
+                if (counters.is_available[index]) {
+                    stream << std::setw(14) << counters.value[index] / divisor;
+                }
+                else {
+                    stream << std::setw(14) << "-";
+                }
+            };
+            const auto cycles = static_cast<unsigned int>(PerfCounter::Type::CYCLES);
+            const auto instructions = static_cast<unsigned int>(PerfCounter::Type::INSTRUCTIONS);
+
+            stream << std::left << std::setw(24) << result.name << std::right;
+
+            print(PerfCounter::Type::CYCLES, items);
+            print(PerfCounter::Type::INSTRUCTIONS, items);
+
+            if (counters.is_available[cycles] && counters.is_available[instructions] && counters.value[cycles] > 0.0) {
+                stream << std::setw(8) << counters.value[instructions] / counters.value[cycles];
+            }
+            else {
+                stream << std::setw(8) << "-";
+            }
+
+            print(PerfCounter::Type::CACHE_MISSES, items);
+            print(PerfCounter::Type::BRANCH_MISSES, items);
+            print(PerfCounter::Type::PAGE_FAULTS, 1.0);
+
+            stream << std::endl;
+        }
+
+        stream.unsetf(std::ios::floatfield);
+        stream << std::setprecision(6);
+    }
+
+    //!
+    //! @fn bool Benchmark::SaveJson(const std::string& path, const std::map<std::string, double>& parameters) const
+    //! @brief 計測結果を Json ファイルに保存する
+    //! @param[in] path パス付の保存ファイル名
+    //! @param[in] parameters 計測条件(スクリプトの行数など)
+    //! @return 処理の成否
+    //! @details 統計値に加えて全サンプルも保存するので
+    //! 後から別の計測結果と統計的に比較出来ます。
+    //!
+    bool Benchmark::SaveJson(const std::string& path, const std::map<std::string, double>& parameters) const
+    {
+        picojson::object parameter_object;
+
+        for (auto&& parameter : parameters) {
+            parameter_object[parameter.first] = picojson::value(parameter.second);
+        }
+
+        picojson::array benchmark_array;
+
+        for (auto&& result : results) {
+            picojson::object object;
+            picojson::array samples_array;
+
+            for (auto&& sample : result.samples_ns) {
+                samples_array.emplace_back(picojson::value(sample));
+            }
+
+            object["name"] = picojson::value(result.name);
+            object["items"] = picojson::value(static_cast<double>(result.items));
+            object["items_per_second"] = picojson::value(result.items_per_second);
+            object["min_ns"] = picojson::value(result.statistics.min);
+            object["max_ns"] = picojson::value(result.statistics.max);
+            object["mean_ns"] = picojson::value(result.statistics.mean);
+            object["median_ns"] = picojson::value(result.statistics.median);
+            object["p90_ns"] = picojson::value(result.statistics.p90);
+            object["p99_ns"] = picojson::value(result.statistics.p99);
+            object["stddev_ns"] = picojson::value(result.statistics.stddev);
+            object["samples_ns"] = picojson::value(samples_array);
+            object["allocs_per_item"] = picojson::value(result.allocs_per_item);
+            object["resident_growth"] = picojson::value(result.resident_growth);
+
+            picojson::object counter_object;
+
+            for (auto type = 0U; type < PerfCounter::TYPE_NUM; ++type) {
+                if (result.counters.is_available[type]) {
+                    counter_object[PerfCounter::GetName(static_cast<PerfCounter::Type>(type))] = picojson::value(result.counters.value[type]);
+                }
+            }
+
+            if (!counter_object.empty()) {
+                object["counters"] = picojson::value(counter_object);
+            }
+
+            benchmark_array.emplace_back(picojson::value(object));
+        }
+
+        picojson::object root;
+
+        root["parameters"] = picojson::value(parameter_object);
+        root["benchmarks"] = picojson::value(benchmark_array);
+
+        std::ofstream ofs(path);
+
+        if (!ofs) {
+            return false;
+        }
+
+        ofs << picojson::value(root).serialize(true);
+
+        return ofs.good();
+    }
+
+    //!
+    //! @fn bool Benchmark::LoadJson(const std::string& path, std::vector<Result>& results, std::map<std::string, double>& parameters)
+    //! @brief SaveJson() で保存した計測結果を読み込む
+    //! @param[in] path パス付の Json ファイル名
+    //! @param[out] results 計測結果(統計値はサンプルから計算し直す)
+    //! @param[out] parameters 計測条件
+    //! @return 処理の成否
+    //!
+    bool Benchmark::LoadJson(const std::string& path, std::vector<Result>& results, std::map<std::string, double>& parameters)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return false;
+        }
+
+        picojson::value value;
+
+        ifs >> value;
+
+        if (!picojson::get_last_error().empty() || !value.is<picojson::object>()) {
+            return false;
+        }
+
+        const auto& root = value.get<picojson::object>();
+        const auto get_number = [](const picojson::object& object, const std::string& key) -> double {
+            const auto found = object.find(key);
+
+            return (found != object.end() && found->second.is<double>()) ? found->second.get<double>() : 0.0;
+        };
+
+        results.clear();
+        parameters.clear();
+
+        const auto found_parameters = root.find("parameters");
+
+        if (found_parameters != root.end() && found_parameters->second.is<picojson::object>()) {
+            for (auto&& parameter : found_parameters->second.get<picojson::object>()) {
+                if (parameter.second.is<double>()) {
+                    parameters[parameter.first] = parameter.second.get<double>();
+                }
+            }
+        }
+
+        const auto found_benchmarks = root.find("benchmarks");
+
+        if (found_benchmarks == root.end() || !found_benchmarks->second.is<picojson::array>()) {
+            return false;
+        }
+
+        for (auto&& item : found_benchmarks->second.get<picojson::array>()) {
+            if (!item.is<picojson::object>()) {
+                return false;
+            }
+
+            const auto& object = item.get<picojson::object>();
+            const auto found_name = object.find("name");
+            const auto found_samples = object.find("samples_ns");
+
+            if (found_name == object.end() || found_samples == object.end() || !found_samples->second.is<picojson::array>()) {
+                return false;
+            }
+
+            Result result;
+
+            result.name = found_name->second.to_str();
+            result.items = static_cast<unsigned long long>(get_number(object, "items"));
+            result.items_per_second = get_number(object, "items_per_second");
+            result.allocs_per_item = get_number(object, "allocs_per_item");
+            // 以前の形式(peak_resident)の結果は比較出来ないので負の値にする
+            result.resident_growth = (object.find("resident_growth") != object.end()) ? get_number(object, "resident_growth") : -1.0;
+
+            for (auto&& sample : found_samples->second.get<picojson::array>()) {
+                if (sample.is<double>()) {
+                    result.samples_ns.emplace_back(sample.get<double>());
+                }
+            }
+
+            result.statistics = Calculate(result.samples_ns);
+            results.emplace_back(std::move(result));
+        }
+
+        return true;
+    }
+
+    //!
+    //! @fn Benchmark::Statistics Benchmark::Calculate(const std::vector<double>& samples)
+    //! @brief サンプルの統計値を計算する
+    //! @param[in] samples サンプル
+    //! @return 統計値
+    //!
+    Benchmark::Statistics Benchmark::Calculate(const std::vector<double>& samples)
+    {
+        Statistics statistics;
+
+        if (samples.empty()) {
+            return statistics;
+        }
+
+        auto sorted = samples;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto size = static_cast<double>(sorted.size());
+        const auto sum = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        const auto mean = sum / size;
+        auto variance = 0.0;
+
+        for (auto&& sample : sorted) {
+            variance += (sample - mean) * (sample - mean);
+        }
+
+        statistics.min = sorted.front();
+        statistics.max = sorted.back();
+        statistics.mean = mean;
+        statistics.median = Percentile(sorted, 50.0);
+        statistics.p90 = Percentile(sorted, 90.0);
+        statistics.p99 = Percentile(sorted, 99.0);
+        statistics.stddev = (sorted.size() > 1) ? std::sqrt(variance / (size - 1.0)) : 0.0;
+
+        return statistics;
+    }
+}
@@ -0,0 +1,97 @@
+﻿//!
+//! @file benchmark.h
+//!
+//! @brief ベンチマークの計測と集計を行うクラス定義
+//!
+#pragma once
+
+#include "perf_counter.h"
+#include <vector>
+#include <string>
+#include <functional>
+#include <ostream>
+#include <map>
+
+namespace amg
+{
+    class Benchmark
+    {
+    public:
+        struct Statistics
+        {
+            double min;
+            double max;
+            double mean;
+            double median;
+            double p90;
+            double p99;
+            double stddev;
+
+            Statistics()
+            {
+                min = 0.0;
+                max = 0.0;
+                mean = 0.0;
+                median = 0.0;
+                p90 = 0.0;
+                p99 = 0.0;
+                stddev = 0.0;
+            }
+        };
+
+        struct Result
+        {
+            std::string name;
+            unsigned long long items;
+            std::vector<double> samples_ns;
+            Statistics statistics;
+            double items_per_second;
+            double allocs_per_item;
+            double resident_growth;     // 計測前からの物理メモリ使用量の増加の最大値(バイト)
+            PerfCounter::Values counters;
+
+            Result()
+            {
+                items = 0;
+                items_per_second = 0.0;
+                allocs_per_item = 0.0;
+                resident_growth = 0.0;
+            }
+        };
+
+        using Setup = std::function<void()>;
+        using Body = std::function<unsigned long long()>;
+
+        Benchmark();
+        Benchmark(const Benchmark&) = default;
+        Benchmark(Benchmark&&) noexcept = default;
+
+        virtual ~Benchmark() = default;
+
+        Benchmark& operator=(const Benchmark& right) = default;
+        Benchmark& operator=(Benchmark&& right) noexcept = default;
+
+        inline void SetSamples(const unsigned int samples) { this->samples = samples; }
+        inline void SetFilter(const std::string& filter) { this->filter = filter; }
+        inline void SetPerfCounter(PerfCounter* perf_counter) { this->perf_counter = perf_counter; }
+
+        bool Run(const std::string& name, const Body& body);
+        bool Run(const std::string& name, const Setup& setup, const Body& body);
+
+        void Print(std::ostream& stream) const;
+        void PrintCounters(std::ostream& stream) const;
+        bool SaveJson(const std::string& path, const std::map<std::string, double>& parameters) const;
+
+        static bool LoadJson(const std::string& path, std::vector<Result>& results, std::map<std::string, double>& parameters);
+
+        inline const std::vector<Result>& GetResults() const { return results; }
+
+        static Statistics Calculate(const std::vector<double>& samples);
+
+    private:
+        std::vector<Result> results;
+        std::string filter;
+        unsigned int samples;
+        PerfCounter* perf_counter;
+    };
+}
@@ -0,0 +1,129 @@
+﻿//!
+//! @file memory_counter.cpp
+//!
+//! @brief メモリの確保回数とプロセスの使用メモリを取得するクラス実装
+//!
+//! @details
+//! 確保回数と確保サイズは operator new を置き換えている AllocTracker の全ての処理単位の合計です。
+//!
+#include "memory_counter.h"
+#include "alloc_tracker.h"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace amg
+{
+    //!
+    //! @fn unsigned long long MemoryCounter::GetAllocCount()
+    //! @brief 起動してからの operator new の呼び出し回数を取得
+    //! @return 呼び出し回数
+    //!
+    unsigned long long MemoryCounter::GetAllocCount()
+    {
+        AllocTracker::Stats stats;
+
+        AllocTracker::GetTotalStats(stats);
+
+        return stats.count;
+    }
+
+    //!
+    //! @fn unsigned long long MemoryCounter::GetAllocBytes()
+    //! @brief 起動してから operator new で確保したサイズの合計を取得
+    //! @return 確保したサイズ(バイト)
+    //!
+    unsigned long long MemoryCounter::GetAllocBytes()
+    {
+        AllocTracker::Stats stats;
+
+        AllocTracker::GetTotalStats(stats);
+
+        return stats.bytes;
+    }
+
+    //!
+    //! @fn std::size_t MemoryCounter::GetResident()
+    //! @brief プロセスの現在の物理メモリ使用量を取得
+    //! @return 使用量(バイト、取得出来ない環境では 0)
+    //!
+    std::size_t MemoryCounter::GetResident()
+    {
+#if defined(__linux__)
+        std::ifstream file("/proc/self/statm");
+        std::size_t size = 0;
+        std::size_t resident = 0;
+
+        if (!(file >> size >> resident)) {
+            return 0;
+        }
+
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return 0;
+        }
+
+        return counters.WorkingSetSize;
+#else
+        return 0;
+#endif
+    }
+
+    //!
+    //! @fn std::size_t MemoryCounter::GetPeakResident()
+    //! @brief プロセスの物理メモリ使用量の最大値を取得
+    //! @return 最大値(バイト、取得出来ない環境では 0)
+    //!
+    std::size_t MemoryCounter::GetPeakResident()
+    {
+#if defined(__linux__)
+        rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return 0;
+        }
+
+        return counters.PeakWorkingSetSize;
+#else
+        return 0;
+#endif
+    }
+
+    //!
+    //! @fn bool MemoryCounter::ResetPeakResident()
+    //! @brief プロセスの物理メモリ使用量の最大値を現在の使用量に戻す
+    //! @return 戻せたか(Linux の /proc/self/clear_refs のみ対応)
+    //! @details 戻せない環境の GetPeakResident() は起動してからの最大値のままです。
+    //!
+    bool MemoryCounter::ResetPeakResident()
+    {
+#if defined(__linux__)
+        std::ofstream file("/proc/self/clear_refs");
+
+        // 5 : VmHWM(ru_maxrss と同じ最大値)を現在の使用量に戻す
+        file << "5";
+        file.flush();
+
+        return static_cast<bool>(file);
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,31 @@
+﻿//!
+//! @file memory_counter.h
+//!
+//! @brief メモリの確保回数とプロセスの使用メモリを取得するクラス定義
+//!
+#pragma once
+
+#include <cstddef>
+
+namespace amg
+{
+    class MemoryCounter
+    {
+    private:
+        MemoryCounter() = default;
+        MemoryCounter(const MemoryCounter&) = default;
+        MemoryCounter(MemoryCounter&&) noexcept = default;
+
+        virtual ~MemoryCounter() = default;
+
+        MemoryCounter& operator=(const MemoryCounter& right) = default;
+        MemoryCounter& operator=(MemoryCounter&& right) noexcept = default;
+
+    public:
+        static unsigned long long GetAllocCount();
+        static unsigned long long GetAllocBytes();
+        static std::size_t GetResident();
+        static std::size_t GetPeakResident();
+        static bool ResetPeakResident();
+    };
+}
@@ -0,0 +1,241 @@
+﻿//!
+//! @file perf_counter.cpp
+//!
+//! @brief ハードウェアパフォーマンスカウンタを読み取るクラス実装
+//!
+//! @details
+//! Linux では perf_event_open で全てのカウンタを読み取ります。
+//! (カーネルの設定や仮想環境で使用出来ないカウンタは無効になります)
+//! Windows ではスレッドのサイクル数(QueryThreadCycleTime)と
+//! プロセスのページフォルト数(GetProcessMemoryInfo)のみ読み取ります。
+//! それ以外の環境では全てのカウンタが無効です。
+//!
+#include "perf_counter.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace {
+    constexpr auto INVALID_HANDLE = -1;
+
+#if defined(__linux__)
+    struct EventConfig
+    {
+        unsigned int type;
+        unsigned long long config;
+    };
+
+    // PerfCounter::Type と同じ順番
+    constexpr EventConfig EVENT_CONFIGS[] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+    };
+
+    int OpenEvent(const EventConfig& event_config)
+    {
+        perf_event_attr attribute;
+
+        std::memset(&attribute, 0, sizeof(attribute));
+        attribute.size = sizeof(attribute);
+        attribute.type = event_config.type;
+        attribute.config = event_config.config;
+        attribute.disabled = 1;
+        attribute.exclude_kernel = 1;
+        attribute.exclude_hv = 1;
+        attribute.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(syscall(__NR_perf_event_open, &attribute, 0, -1, -1, 0));
+    }
+#endif
+}
+
+namespace amg
+{
+    PerfCounter::PerfCounter()
+    {
+        for (auto i = 0U; i < TYPE_NUM; ++i) {
+            handle[i] = INVALID_HANDLE;
+            start_value[i] = 0;
+            start_enabled[i] = 0;
+            start_running[i] = 0;
+        }
+    }
+
+    PerfCounter::~PerfCounter()
+    {
+        Close();
+    }
+
+    //!
+    //! @fn bool PerfCounter::Open()
+    //! @brief 使用出来るカウンタを全て開く
+    //! @return 1 つでも使用出来るカウンタが有るか
+    //!
+    bool PerfCounter::Open()
+    {
+        Close();
+
+        auto is_open = false;
+
+#if defined(__linux__)
+        for (auto i = 0U; i < TYPE_NUM; ++i) {
+            handle[i] = OpenEvent(EVENT_CONFIGS[i]);
+            is_open |= (handle[i] != INVALID_HANDLE);
+        }
+#elif defined(_WIN32)
+        handle[static_cast<unsigned int>(Type::CYCLES)] = 0;
+        handle[static_cast<unsigned int>(Type::PAGE_FAULTS)] = 0;
+        is_open = true;
+#endif
+
+        return is_open;
+    }
+
+    void PerfCounter::Close()
+    {
+        for (auto i = 0U; i < TYPE_NUM; ++i) {
+#if defined(__linux__)
+            if (handle[i] != INVALID_HANDLE) {
+                close(handle[i]);
+            }
+#endif
+            handle[i] = INVALID_HANDLE;
+        }
+    }
+
+    //!
+    //! @fn void PerfCounter::Start()
+    //! @brief 計測を開始する
+    //!
+    void PerfCounter::Start()
+    {
+        for (auto i = 0U; i < TYPE_NUM; ++i) {
+            if (handle[i] == INVALID_HANDLE) {
+                continue;
+            }
+
+#if defined(__linux__)
+            ioctl(handle[i], PERF_EVENT_IOC_ENABLE, 0);
+#endif
+            Read(i, start_value[i], start_enabled[i], start_running[i]);
+        }
+    }
+
+    //!
+    //! @fn void PerfCounter::Stop(Values& values)
+    //! @brief 計測を終了して Start() からの増分を取得する
+    //! @param[out] values カウンタの増分(使用出来ないカウンタは is_available が false)
+    //! @details 他のカウンタと時分割で計測された場合は計測時間の割合で補正します。
+    //!
+    void PerfCounter::Stop(Values& values)
+    {
+        for (auto i = 0U; i < TYPE_NUM; ++i) {
+            auto value = 0ULL;
+            auto enabled = 0ULL;
+            auto running = 0ULL;
+
+#if defined(__linux__)
+            if (handle[i] != INVALID_HANDLE) {
+                ioctl(handle[i], PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+
+            values.value[i] = 0.0;
+            values.is_available[i] = (handle[i] != INVALID_HANDLE) && Read(i, value, enabled, running);
+
+            if (!values.is_available[i]) {
+                continue;
+            }
+
+            const auto delta = static_cast<double>(value - start_value[i]);
+            const auto delta_enabled = enabled - start_enabled[i];
+            const auto delta_running = running - start_running[i];
+
+            if (delta_running > 0 && delta_running < delta_enabled) {
+                values.value[i] = delta * delta_enabled / delta_running;
+            }
+            else {
+                values.value[i] = delta;
+            }
+        }
+    }
+
+    bool PerfCounter::IsAvailable(Type type) const
+    {
+        return handle[static_cast<unsigned int>(type)] != INVALID_HANDLE;
+    }
+
+    const char* PerfCounter::GetName(Type type)
+    {
+        switch (type) {
+        case Type::CYCLES: return "cycles";
+        case Type::INSTRUCTIONS: return "instructions";
+        case Type::CACHE_MISSES: return "cache_misses";
+        case Type::BRANCH_MISSES: return "branch_misses";
+        case Type::PAGE_FAULTS: return "page_faults";
+        }
+
+        return "unknown";
+    }
+
+    bool PerfCounter::Read(unsigned int index, unsigned long long& value, unsigned long long& enabled, unsigned long long& running) const
+    {
+        value = 0;
+        enabled = 0;
+        running = 0;
+
+#if defined(__linux__)
+        unsigned long long buffer[3] = { 0, 0, 0 };
+
+        if (read(handle[index], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer))) {
+            return false;
+        }
+
+        value = buffer[0];
+        enabled = buffer[1];
+        running = buffer[2];
+
+        return true;
+#elif defined(_WIN32)
+        switch (static_cast<Type>(index)) {
+        case Type::CYCLES: {
+            ULONG64 cycles = 0;
+
+            if (!QueryThreadCycleTime(GetCurrentThread(), &cycles)) {
+                return false;
+            }
+
+            value = cycles;
+            return true;
+        }
+
+        case Type::PAGE_FAULTS: {
+            PROCESS_MEMORY_COUNTERS counters;
+
+            if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+                return false;
+            }
+
+            value = counters.PageFaultCount;
+            return true;
+        }
+
+        default:
+            return false;
+        }
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,64 @@
+﻿//!
+//! @file perf_counter.h
+//!
+//! @brief ハードウェアパフォーマンスカウンタを読み取るクラス定義
+//!
+#pragma once
+
+namespace amg
+{
+    class PerfCounter
+    {
+    public:
+        enum class Type {
+            CYCLES,
+            INSTRUCTIONS,
+            CACHE_MISSES,
+            BRANCH_MISSES,
+            PAGE_FAULTS
+        };
+
+        static constexpr auto TYPE_NUM = 5U;
+
+        struct Values
+        {
+            double value[TYPE_NUM];
+            bool is_available[TYPE_NUM];
+
+            Values()
+            {
+                for (auto i = 0U; i < TYPE_NUM; ++i) {
+                    value[i] = 0.0;
+                    is_available[i] = false;
+                }
+            }
+        };
+
+        PerfCounter();
+        PerfCounter(const PerfCounter&) = delete;
+        PerfCounter(PerfCounter&&) = delete;
+
+        virtual ~PerfCounter();
+
+        PerfCounter& operator=(const PerfCounter& right) = delete;
+        PerfCounter& operator=(PerfCounter&& right) = delete;
+
+        bool Open();
+        void Close();
+
+        void Start();
+        void Stop(Values& values);
+
+        bool IsAvailable(Type type) const;
+
+        static const char* GetName(Type type);
+
+    private:
+        bool Read(unsigned int index, unsigned long long& value, unsigned long long& enabled, unsigned long long& running) const;
+
+        int handle[TYPE_NUM];
+        unsigned long long start_value[TYPE_NUM];
+        unsigned long long start_enabled[TYPE_NUM];
+        unsigned long long start_running[TYPE_NUM];
+    };
+}
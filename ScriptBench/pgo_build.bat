@@ -0,0 +1,64 @@
+@echo off
+rem
+rem ScriptBench  PGO(Profile Guided Optimization)rh
+rem
+rem g: pgo_build.bat [Win32 | x64]  (l x64)
+rem msbuild  pgomgr gp̂ Visual Studio  Native Tools Command Prompt ŎsĉB
+rem
+rem 1. ʏ Release rh(PGOBaseline)ŌvĊɂ
+rem 2. vp̃R[h𖄂ߍ񂾃rh(PGOInstrumentA/GENPROFILE)
+rem 3. ScriptEngine\replays ̋L^͂ʖōĐĎspxW߂
+rem 4. W߂spxōœKrh(PGOOptimizeA/USEPROFILE)
+rem 5. œKrhŌvĊƔr(speedup x㗦)
+rem
+rem vViI͎ł͂Ȃ escape_from_amg.json ŁAĐ͂ replays ̑SĂ .rec łB
+rem Q[{̂ -record t@C tŋNċL^ .rec  replays ɒǉƊwKɎgp܂B
+rem
+setlocal enabledelayedexpansion
+
+set PLATFORM=%~1
+if "%PLATFORM%"=="" set PLATFORM=x64
+
+set ROOT=%~dp0..\
+set PROJECT=%~dp0ScriptBench.vcxproj
+set SCENARIO=%ROOT%ScriptEngine\escape_from_amg.json
+set REPLAY_DIR=%ROOT%ScriptEngine\replays
+set PGO_DIR=%ROOT%%PLATFORM%\PGO
+set BASELINE=%PGO_DIR%Baseline\pgo_baseline.json
+set TRAINING_SAMPLES=10
+set MSBUILD_OPTIONS=/nologo /m /t:Rebuild /p:Configuration=Release /p:Platform=%PLATFORM%
+
+set REPLAYS=
+set REPLAY_NUM=0
+
+for %%f in ("%REPLAY_DIR%\*.rec") do (
+    set REPLAYS=!REPLAYS! --replay "%%~ff"
+    set /a REPLAY_NUM+=1
+)
+
+if %REPLAY_NUM%==0 (
+    echo [PGO] replay file not found: %REPLAY_DIR%\*.rec
+    exit /b 1
+)
+
+echo [PGO] 1/5 baseline build
+msbuild "%PROJECT%" %MSBUILD_OPTIONS% /p:PgoPhase=Baseline || exit /b 1
+"%PGO_DIR%Baseline\ScriptBench.exe" --scenario "%SCENARIO%" %REPLAYS% --json "%BASELINE%" || exit /b 1
+
+echo [PGO] 2/5 instrumented build
+msbuild "%PROJECT%" %MSBUILD_OPTIONS% /p:PgoPhase=Instrument || exit /b 1
+del /q "%PGO_DIR%Instrument\*.pgc" 2>nul
+
+rem wK Replay ̂ݎs(x`}[N̎spxȂ)
+echo [PGO] 3/5 training with %REPLAY_NUM% replays
+"%PGO_DIR%Instrument\ScriptBench.exe" --scenario "%SCENARIO%" %REPLAYS% --filter Replay --samples %TRAINING_SAMPLES% || exit /b 1
+pgomgr /merge "%PGO_DIR%Instrument\ScriptBench.pgd" || exit /b 1
+
+echo [PGO] 4/5 optimized build
+msbuild "%PROJECT%" %MSBUILD_OPTIONS% /p:PgoPhase=Optimize || exit /b 1
+
+rem 򉻂̔(IR[h 1)͌ʂ̕\݂̂Ńrh̎sɂ͂Ȃ
+echo [PGO] 5/5 benchmark against baseline
+"%PGO_DIR%Optimize\ScriptBench.exe" --scenario "%SCENARIO%" %REPLAYS% --baseline "%BASELINE%"
+
+exit /b 0
@@ -0,0 +1,274 @@
+﻿//!
+//! @file regression_gate.cpp
+//!
+//! @brief ベンチマークの計測結果を基準と比較して性能の劣化を判定するクラス実装
+//!
+//! @details
+//! 処理時間は 1 回の計測値ではなく全サンプルで Mann-Whitney の U 検定(片側)を行い
+//! 有意に遅くなっていて、かつ中央値の増加が閾値を超えた場合に劣化と判定します。
+//! p90 は閾値の 2 倍を超えて、かつ有意な場合に劣化と判定します。
+//! 1 要素あたりのメモリ確保回数はほぼ決まった値になるので 1% の増加で劣化と判定します。
+//! 物理メモリ使用量はベンチマーク毎の計測前からの増加を比較し
+//! resident_threshold を超えて、かつ RESIDENT_MIN_BYTES 以上増えた場合に劣化と判定します。
+//! (以前の形式の peak_resident のみの基準は比較しません)
+//!
+#include "regression_gate.h"
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    constexpr auto DEFAULT_THRESHOLD = 0.05;
+    constexpr auto DEFAULT_ALPHA = 0.01;
+    constexpr auto DEFAULT_RESIDENT_THRESHOLD = 0.10;
+    constexpr auto ALLOC_TOLERANCE = 0.01;
+    constexpr auto TAIL_THRESHOLD_RATE = 2.0;
+    constexpr auto RESIDENT_MIN_BYTES = 1024.0 * 1024.0;   // ページ単位の揺らぎを劣化としない
+
+    const char* const DEFAULT_GATED_NAMES[] = { "LoadJson", "Parsing", "Render", "Replay" };
+
+    double Change(const double baseline, const double current)
+    {
+        return (baseline > 0.0) ? (current - baseline) / baseline : 0.0;
+    }
+}
+
+namespace amg
+{
+    RegressionGate::RegressionGate()
+    {
+        gated_names.assign(std::begin(DEFAULT_GATED_NAMES), std::end(DEFAULT_GATED_NAMES));
+        threshold = DEFAULT_THRESHOLD;
+        alpha = DEFAULT_ALPHA;
+        resident_threshold = DEFAULT_RESIDENT_THRESHOLD;
+    }
+
+    //!
+    //! @fn bool RegressionGate::Compare(const std::vector<Benchmark::Result>& baseline, const std::vector<Benchmark::Result>& current, std::vector<Comparison>& comparisons) const
+    //! @brief 計測結果を基準と比較する
+    //! @param[in] baseline 基準の計測結果
+    //! @param[in] current 今回の計測結果
+    //! @param[out] comparisons 両方に存在するベンチマーク毎の比較結果
+    //! @return 判定対象のベンチマークに劣化が無いか
+    //!
+    bool RegressionGate::Compare(const std::vector<Benchmark::Result>& baseline, const std::vector<Benchmark::Result>& current,
+        std::vector<Comparison>& comparisons) const
+    {
+        auto is_pass = true;
+
+        comparisons.clear();
+
+        for (auto&& result : current) {
+            const auto check = [&result](const Benchmark::Result& element) -> bool {
+                return element.name == result.name;
+            };
+            const auto found = std::find_if(baseline.begin(), baseline.end(), check);
+
+            if (found == baseline.end()) {
+                continue;
+            }
+
+            Comparison comparison;
+
+            comparison.name = result.name;
+            comparison.baseline_median = found->statistics.median;
+            comparison.current_median = result.statistics.median;
+            comparison.median_change = Change(found->statistics.median, result.statistics.median);
+            comparison.p90_change = Change(found->statistics.p90, result.statistics.p90);
+            comparison.p99_change = Change(found->statistics.p99, result.statistics.p99);
+            comparison.p_value = MannWhitney(found->samples_ns, result.samples_ns);
+            comparison.baseline_allocs = found->allocs_per_item;
+            comparison.current_allocs = result.allocs_per_item;
+            comparison.baseline_resident = found->resident_growth;
+            comparison.current_resident = result.resident_growth;
+            comparison.is_gated = std::find(gated_names.begin(), gated_names.end(), result.name) != gated_names.end();
+
+            const auto is_significant = (comparison.p_value < alpha);
+
+            comparison.is_time_regression = is_significant && comparison.median_change > threshold;
+            comparison.is_tail_regression = is_significant && comparison.p90_change > threshold * TAIL_THRESHOLD_RATE;
+            comparison.is_alloc_regression = comparison.current_allocs > comparison.baseline_allocs * (1.0 + ALLOC_TOLERANCE) &&
+                comparison.current_allocs - comparison.baseline_allocs > 1.0e-6;
+            comparison.is_resident_regression = comparison.baseline_resident >= 0.0 &&
+                comparison.current_resident - comparison.baseline_resident >=
+                std::max(comparison.baseline_resident * resident_threshold, RESIDENT_MIN_BYTES);
+
+            if (comparison.is_gated && comparison.IsRegression()) {
+                is_pass = false;
+            }
+
+            comparisons.emplace_back(std::move(comparison));
+        }
+
+        return is_pass;
+    }
+
+    //!
+    //! @fn void RegressionGate::Print(std::ostream& stream, const std::vector<Comparison>& comparisons)
+    //! @brief 比較結果を表形式で出力する
+    //! @param[in] stream 出力先
+    //! @param[in] comparisons 比較結果
+    //! @details 判定対象外のベンチマークは名前の後に '*' を付けて
+    //! 劣化していても REGRESSED ではなく slower などと出力します。
+    //!
+    void RegressionGate::Print(std::ostream& stream, const std::vector<Comparison>& comparisons)
+    {
+        stream << std::left << std::setw(24) << "benchmark" << std::right
+            << std::setw(14) << "base(us)"
+            << std::setw(14) << "current(us)"
+            << std::setw(10) << "change"
+            << std::setw(10) << "p90"
+            << std::setw(10) << "p-value"
+            << std::setw(20) << "allocs/item"
+            << std::setw(16) << "growth(MB)"
+            << "  result" << std::endl;
+
+        for (auto&& comparison : comparisons) {
+            std::string verdict;
+
+            if (comparison.is_time_regression) {
+                verdict += " time";
+            }
+
+            if (comparison.is_tail_regression) {
+                verdict += " tail";
+            }
+
+            if (comparison.is_alloc_regression) {
+                verdict += " alloc";
+            }
+
+            if (comparison.is_resident_regression) {
+                verdict += " memory";
+            }
+
+            if (!verdict.empty()) {
+                verdict = (comparison.is_gated ? "REGRESSED:" : "slower:") + verdict;
+            }
+            else {
+                verdict = "ok";
+            }
+
+            std::ostringstream allocs;
+            std::ostringstream resident;
+
+            allocs << std::fixed << std::setprecision(2) << comparison.baseline_allocs << "->" << comparison.current_allocs;
+            resident << std::fixed << std::setprecision(1);
+
+            if (comparison.baseline_resident >= 0.0) {
+                resident << comparison.baseline_resident / (1024.0 * 1024.0);
+            }
+            else {
+                resident << "-";
+            }
+
+            resident << "->" << comparison.current_resident / (1024.0 * 1024.0);
+
+            stream << std::left << std::setw(24) << (comparison.is_gated ? comparison.name : comparison.name + "*") << std::right
+                << std::fixed << std::setprecision(2)
+                << std::setw(14) << comparison.baseline_median / 1000.0
+                << std::setw(14) << comparison.current_median / 1000.0
+                << std::setw(9) << std::showpos << comparison.median_change * 100.0 << "%"
+                << std::setw(9) << comparison.p90_change * 100.0 << "%" << std::noshowpos
+                << std::setw(10) << std::setprecision(4) << comparison.p_value
+                << std::setw(20) << allocs.str()
+                << std::setw(16) << resident.str()
+                << "  " << verdict << std::endl;
+        }
+
+        stream.unsetf(std::ios::floatfield);
+        stream << std::setprecision(6);
+    }
+
+    //!
+    //! @fn double RegressionGate::Speedup(const std::vector<Comparison>& comparisons)
+    //! @brief 基準に対しての速度向上率を求める
+    //! @param[in] comparisons 比較結果
+    //! @return 中央値の比(基準 / 今回)の幾何平均(1 より大きければ速くなっている)
+    //!
+    double RegressionGate::Speedup(const std::vector<Comparison>& comparisons)
+    {
+        auto log_sum = 0.0;
+        auto count = 0U;
+
+        for (auto&& comparison : comparisons) {
+            if (comparison.baseline_median > 0.0 && comparison.current_median > 0.0) {
+                log_sum += std::log(comparison.baseline_median / comparison.current_median);
+                ++count;
+            }
+        }
+
+        return (count > 0) ? std::exp(log_sum / count) : 1.0;
+    }
+
+    //!
+    //! @fn double RegressionGate::MannWhitney(const std::vector<double>& baseline, const std::vector<double>& current)
+    //! @brief Mann-Whitney の U 検定(片側、正規近似)
+    //! @param[in] baseline 基準のサンプル
+    //! @param[in] current 今回のサンプル
+    //! @return 今回のサンプルが基準より大きくない(遅くない)とした場合の p 値
+    //! @details 同じ値のサンプルには平均順位を付け、分散を補正します。
+    //!
+    double RegressionGate::MannWhitney(const std::vector<double>& baseline, const std::vector<double>& current)
+    {
+        const auto n1 = static_cast<double>(current.size());
+        const auto n2 = static_cast<double>(baseline.size());
+
+        if (current.empty() || baseline.empty()) {
+            return 1.0;
+        }
+
+        // 値と今回のサンプルかどうかの組
+        std::vector<std::pair<double, bool>> samples;
+
+        for (auto&& sample : current) {
+            samples.emplace_back(sample, true);
+        }
+
+        for (auto&& sample : baseline) {
+            samples.emplace_back(sample, false);
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        const auto n = n1 + n2;
+        auto rank_sum = 0.0;
+        auto tie_sum = 0.0;
+
+        for (size_t i = 0; i < samples.size();) {
+            auto last = i;
+
+            while (last + 1 < samples.size() && samples[last + 1].first == samples[i].first) {
+                ++last;
+            }
+
+            // 順位は 1 から数える
+            const auto rank = (i + last) / 2.0 + 1.0;
+            const auto ties = static_cast<double>(last - i + 1);
+
+            for (auto j = i; j <= last; ++j) {
+                if (samples[j].second) {
+                    rank_sum += rank;
+                }
+            }
+
+            tie_sum += ties * ties * ties - ties;
+            i = last + 1;
+        }
+
+        const auto u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+        const auto mean = n1 * n2 / 2.0;
+        const auto variance = n1 * n2 / 12.0 * ((n + 1.0) - tie_sum / (n * (n - 1.0)));
+
+        if (variance <= 0.0) {
+            return 1.0;
+        }
+
+        // 連続性の補正をした z 値の上側確率
+        const auto z = (u - mean - 0.5) / std::sqrt(variance);
+
+        return 0.5 * std::erfc(z / std::sqrt(2.0));
+    }
+}
@@ -0,0 +1,88 @@
+﻿//!
+//! @file regression_gate.h
+//!
+//! @brief ベンチマークの計測結果を基準と比較して性能の劣化を判定するクラス定義
+//!
+#pragma once
+
+#include "benchmark.h"
+#include <vector>
+#include <string>
+#include <ostream>
+
+namespace amg
+{
+    class RegressionGate
+    {
+    public:
+        struct Comparison
+        {
+            std::string name;
+            double baseline_median;
+            double current_median;
+            double median_change;
+            double p90_change;
+            double p99_change;
+            double p_value;
+            double baseline_allocs;
+            double current_allocs;
+            double baseline_resident;
+            double current_resident;
+            bool is_gated;
+            bool is_time_regression;
+            bool is_tail_regression;
+            bool is_alloc_regression;
+            bool is_resident_regression;
+
+            Comparison()
+            {
+                baseline_median = 0.0;
+                current_median = 0.0;
+                median_change = 0.0;
+                p90_change = 0.0;
+                p99_change = 0.0;
+                p_value = 1.0;
+                baseline_allocs = 0.0;
+                current_allocs = 0.0;
+                baseline_resident = 0.0;
+                current_resident = 0.0;
+                is_gated = false;
+                is_time_regression = false;
+                is_tail_regression = false;
+                is_alloc_regression = false;
+                is_resident_regression = false;
+            }
+
+            inline bool IsRegression() const {
+                return is_time_regression || is_tail_regression || is_alloc_regression || is_resident_regression;
+            }
+        };
+
+        RegressionGate();
+        RegressionGate(const RegressionGate&) = default;
+        RegressionGate(RegressionGate&&) noexcept = default;
+
+        virtual ~RegressionGate() = default;
+
+        RegressionGate& operator=(const RegressionGate& right) = default;
+        RegressionGate& operator=(RegressionGate&& right) noexcept = default;
+
+        inline void SetThreshold(const double threshold) { this->threshold = threshold; }
+        inline void SetAlpha(const double alpha) { this->alpha = alpha; }
+        inline void SetResidentThreshold(const double resident_threshold) { this->resident_threshold = resident_threshold; }
+        inline void SetGatedNames(const std::vector<std::string>& gated_names) { this->gated_names = gated_names; }
+
+        bool Compare(const std::vector<Benchmark::Result>& baseline, const std::vector<Benchmark::Result>& current,
+            std::vector<Comparison>& comparisons) const;
+
+        static void Print(std::ostream& stream, const std::vector<Comparison>& comparisons);
+        static double Speedup(const std::vector<Comparison>& comparisons);
+        static double MannWhitney(const std::vector<double>& baseline, const std::vector<double>& current);
+
+    private:
+        std::vector<std::string> gated_names;
+        double threshold;
+        double alpha;
+        double resident_threshold;
+    };
+}
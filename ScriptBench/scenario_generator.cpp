@@ -0,0 +1,184 @@
+﻿//!
+//! @file scenario_generator.cpp
+//!
+//! @brief ベンチマーク用のスクリプトを自動生成するクラス実装
+//!
+//! @details
+//! 生成するスクリプトは escape_from_amg.json と同じ形式(UTF-8 の Json)です。
+//! 全てのコマンドを含み、ラベルへの移動は必ず前方向なので
+//! どの選択肢を選んでも 'e' コマンドで終了します。
+//!
+//! lines          : おおよその総行数
+//! label_density  : 1 行あたりに 'l' コマンドが現れる確率
+//! choice_fan_out : 1 回の選択待ちで表示する 'c' コマンドの数(0 なら選択肢無し)
+//! images         : 'd' コマンドで使用する 'i' コマンドの数
+//! seed           : 乱数の種(同じ値なら同じスクリプトを生成する)
+//!
+#include "scenario_generator.h"
+#include "picojson.h"
+#include <random>
+#include <fstream>
+#include <algorithm>
+
+namespace {
+    // 生成するスクリプトは UTF-8 なので日本語は u8 リテラルで記述する
+    constexpr auto CURSOR_IMAGE = u8"i, カーソル, png/arrow_cursor.png";
+    constexpr auto CLICK_WAIT_IMAGE = u8"i, クリック待ち, png/click_wait.png";
+    constexpr auto IMAGE_LABEL = u8"画像";
+    constexpr auto IMAGE_FILE = "png/amg502.png";
+    constexpr auto CHOICE_MESSAGE = u8"選択肢";
+    constexpr auto START_LABEL = "l, Start";
+    constexpr auto LABEL_PREFIX = "L";
+
+    const char* const MESSAGE_WORDS[] = {
+        u8"あ", u8"い", u8"う", u8"え", u8"お", u8"学", u8"院", u8"。", u8"、", u8"猪"
+    };
+    constexpr auto MESSAGE_WORD_NUM = sizeof(MESSAGE_WORDS) / sizeof(MESSAGE_WORDS[0]);
+
+    constexpr auto MESSAGE_WORD_MIN = 4;
+    constexpr auto MESSAGE_WORD_MAX = 40;
+    constexpr auto MESSAGE_PER_CLICK = 3;
+
+    constexpr auto DRAW_INDEX_MAX = 8;
+    constexpr auto WAIT_FRAME_MAX = 60;
+
+    // ラベル以外のコマンドが現れる確率
+    constexpr auto CHOICE_RATE = 0.03;
+    constexpr auto DRAW_RATE = 0.05;
+    constexpr auto WAIT_RATE = 0.03;
+    constexpr auto JUMP_RATE = 0.01;
+
+    std::string MakeLabel(const unsigned int index)
+    {
+        return LABEL_PREFIX + std::to_string(index);
+    }
+}
+
+namespace amg
+{
+    ScenarioGenerator::ScenarioGenerator(const Parameter& parameter)
+    {
+        this->parameter = parameter;
+    }
+
+    //!
+    //! @fn void ScenarioGenerator::Generate(std::vector<std::string>& scripts) const
+    //! @brief スクリプトを生成する
+    //! @param[out] scripts 生成したスクリプト(UTF-8)
+    //!
+    void ScenarioGenerator::Generate(std::vector<std::string>& scripts) const
+    {
+        std::mt19937 engine(parameter.seed);
+        std::uniform_real_distribution<double> rate(0.0, 1.0);
+        std::uniform_int_distribution<unsigned int> word_num(MESSAGE_WORD_MIN, MESSAGE_WORD_MAX);
+        std::uniform_int_distribution<unsigned int> word(0, MESSAGE_WORD_NUM - 1);
+        std::uniform_int_distribution<unsigned int> draw_index(0, DRAW_INDEX_MAX - 1);
+        std::uniform_int_distribution<unsigned int> wait_frame(1, WAIT_FRAME_MAX);
+
+        scripts.clear();
+        scripts.reserve(parameter.lines + parameter.images + parameter.choice_fan_out + 8);
+
+        scripts.emplace_back(CURSOR_IMAGE);
+        scripts.emplace_back(CLICK_WAIT_IMAGE);
+
+        for (auto i = 0U; i < parameter.images; ++i) {
+            scripts.emplace_back(std::string("i, ") + IMAGE_LABEL + std::to_string(i) + ", " + IMAGE_FILE);
+        }
+
+        scripts.emplace_back(START_LABEL);
+
+        auto next_label = 0U;
+        auto referenced_label = 0U;
+        auto message_num = 0;
+
+        const auto choice_rate = parameter.label_density + ((parameter.choice_fan_out > 0) ? CHOICE_RATE : 0.0);
+        const auto draw_rate = choice_rate + ((parameter.images > 0) ? DRAW_RATE : 0.0);
+        const auto wait_rate = draw_rate + WAIT_RATE;
+        const auto jump_rate = wait_rate + JUMP_RATE;
+
+        while (scripts.size() < parameter.lines) {
+            const auto value = rate(engine);
+
+            if (value < parameter.label_density) {
+                scripts.emplace_back("l, " + MakeLabel(next_label++));
+            }
+            else if (value < choice_rate) {
+                for (auto i = 0U; i < parameter.choice_fan_out; ++i) {
+                    const auto target = next_label + i;
+
+                    scripts.emplace_back("c, " + MakeLabel(target) + ", " + CHOICE_MESSAGE + std::to_string(i));
+                    referenced_label = std::max(referenced_label, target + 1);
+                }
+
+                scripts.emplace_back("@");
+                message_num = 0;
+            }
+            else if (value < draw_rate) {
+                scripts.emplace_back("d, " + std::to_string(draw_index(engine)) + ", 0, 0, " +
+                    IMAGE_LABEL + std::to_string(engine() % parameter.images));
+            }
+            else if (value < wait_rate) {
+                scripts.emplace_back("w, " + std::to_string(wait_frame(engine)));
+            }
+            else if (value < jump_rate) {
+                scripts.emplace_back("j, " + MakeLabel(next_label));
+                referenced_label = std::max(referenced_label, next_label + 1);
+            }
+            else {
+                std::string message("m, ");
+                const auto num = word_num(engine);
+
+                for (auto i = 0U; i < num; ++i) {
+                    message += MESSAGE_WORDS[word(engine)];
+                }
+
+                scripts.emplace_back(message);
+
+                if (++message_num >= MESSAGE_PER_CLICK) {
+                    scripts.emplace_back("@");
+                    message_num = 0;
+                }
+            }
+        }
+
+        // 参照されたのにまだ置いていないラベルを全て置いてから終了する
+        while (next_label < referenced_label) {
+            scripts.emplace_back("l, " + MakeLabel(next_label++));
+        }
+
+        scripts.emplace_back("e");
+    }
+
+    //!
+    //! @fn bool ScenarioGenerator::SaveJson(const std::string& path, const std::vector<std::string>& scripts)
+    //! @brief スクリプトを Json ファイルに保存する
+    //! @param[in] path パス付の保存ファイル名
+    //! @param[in] scripts UTF-8 のスクリプト
+    //! @return 処理の成否
+    //! @details 数百万行でもメモリを消費しない様に 1 行づつ書き出します。
+    //!
+    bool ScenarioGenerator::SaveJson(const std::string& path, const std::vector<std::string>& scripts)
+    {
+        std::ofstream ofs(path, std::ios::binary);
+
+        if (!ofs) {
+            return false;
+        }
+
+        ofs << "[\n\t{\n\t\t\"scripts\": [\n";
+
+        for (size_t i = 0; i < scripts.size(); ++i) {
+            ofs << "\t\t\t" << picojson::value(scripts[i]).serialize();
+
+            if (i + 1 < scripts.size()) {
+                ofs << ",";
+            }
+
+            ofs << "\n";
+        }
+
+        ofs << "\t\t]\n\t}\n]\n";
+
+        return ofs.good();
+    }
+}
@@ -0,0 +1,52 @@
+﻿//!
+//! @file scenario_generator.h
+//!
+//! @brief ベンチマーク用のスクリプトを自動生成するクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class ScenarioGenerator
+    {
+    public:
+        struct Parameter
+        {
+            unsigned int lines;
+            double label_density;
+            unsigned int choice_fan_out;
+            unsigned int images;
+            unsigned int seed;
+
+            Parameter()
+            {
+                lines = 10000;
+                label_density = 0.02;
+                choice_fan_out = 2;
+                images = 8;
+                seed = 1;
+            }
+        };
+
+        explicit ScenarioGenerator(const Parameter& parameter);
+        ScenarioGenerator(const ScenarioGenerator&) = default;
+        ScenarioGenerator(ScenarioGenerator&&) noexcept = default;
+
+        virtual ~ScenarioGenerator() = default;
+
+        ScenarioGenerator& operator=(const ScenarioGenerator& right) = default;
+        ScenarioGenerator& operator=(ScenarioGenerator&& right) noexcept = default;
+
+        void Generate(std::vector<std::string>& scripts) const;
+
+        static bool SaveJson(const std::string& path, const std::vector<std::string>& scripts);
+
+        inline const Parameter& GetParameter() const { return parameter; }
+
+    private:
+        Parameter parameter;
+    };
+}
@@ -0,0 +1,351 @@
+﻿//!
+//! @file headless_runner.cpp
+//!
+//! @brief スクリプトエンジンを画面無しで最速実行するクラス実装
+//!
+//! @details
+//! dx_wrapper_headless.cpp をリンクした環境で使用します。
+//! WinMain のメインループと同じ順番で Update() と Render() を呼び出しますが
+//! ProcessMessage() や ScreenFlip() による待ちが無い為
+//! CPU の処理速度でフレームを進めます。
+//!
+#include "dx_wrapper.h"
+#include "dx_headless.h"
+#include "headless_runner.h"
+#include "input_record.h"
+#include "frame_profiler.h"
+#include "alloc_tracker.h"
+#include "metrics_exporter.h"
+#include "latency_tracker.h"
+#include "memory_footprint.h"
+#include <chrono>
+
+namespace {
+    constexpr auto SCREEN_WIDTH = 1280;
+    constexpr auto SCREEN_HEIGHT = 720;
+    constexpr auto SCREEN_DEPTH = 32;
+
+    constexpr auto DEFAULT_MAX_FRAMES = 1000000U;
+
+    // FNV-1a 64bit
+    constexpr auto DIGEST_OFFSET = 14695981039346656037ULL;
+    constexpr auto DIGEST_PRIME = 1099511628211ULL;
+
+    using Clock = std::chrono::steady_clock;
+
+    double ToMilliseconds(const Clock::duration& duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+namespace amg
+{
+    HeadlessRunner::HeadlessRunner()
+    {
+        running_result = nullptr;
+        recorder = nullptr;
+        replayer = nullptr;
+        profiler = nullptr;
+        execution_trace = nullptr;
+        metrics = nullptr;
+        latency_tracker = nullptr;
+        memory_footprint = nullptr;
+        listener = nullptr;
+        max_frames = DEFAULT_MAX_FRAMES;
+        is_auto_click = false;
+        is_render = true;
+        is_full_redraw = false;
+        is_trace = false;
+    }
+
+    //!
+    //! @fn bool HeadlessRunner::Run(const TCHAR* path, const InputScript& input, Result& result)
+    //! @brief スクリプトを最初から実行する
+    //! @param[in] path パス付のスクリプト用 Json ファイル名
+    //! @param[in] input 入力スクリプト
+    //! @param[out] result 実行結果
+    //! @return スクリプトの終端('e' コマンドか最終行)まで実行出来たか
+    //! @details 実行毎にスクリプトエンジンを初期化するので
+    //! 同じ入力スクリプトなら必ず同じ結果になります。
+    //! InputReplayer が設定されている場合は入力スクリプトの代わりに
+    //! 記録された入力を先頭から再生し、再生し終わったら終了します。
+    //!
+    bool HeadlessRunner::Run(const TCHAR* path, const InputScript& input, Result& result)
+    {
+        result = Result();
+        result.digest = DIGEST_OFFSET;
+        running_result = &result;
+
+        DxHeadless::Reset();
+        DxWrapper::SetGraphMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_DEPTH);
+
+        ScriptEngine script_engine;
+
+        script_engine.SetListener(this);
+
+        if (recorder != nullptr) {
+            recorder->Clear();
+            script_engine.SetInputRecorder(recorder);
+        }
+
+        if (replayer != nullptr) {
+            replayer->Rewind();
+            script_engine.SetInputReplayer(replayer);
+        }
+
+        script_engine.SetProfiler(profiler);
+        script_engine.SetExecutionTrace(execution_trace);
+        script_engine.SetLatencyTracker(latency_tracker);
+
+        const auto initialize_start = Clock::now();
+
+        if (!script_engine.Initialize(path)) {
+            result.reason = StopReason::INITIALIZE_ERROR;
+            running_result = nullptr;
+            return false;
+        }
+
+        const auto run_start = Clock::now();
+
+        if (metrics != nullptr) {
+            metrics->AddLoad(ToMilliseconds(run_start - initialize_start) / 1000.0);
+        }
+
+        const auto& events = input.GetEvents();
+        auto event_index = static_cast<size_t>(0);
+        auto is_pressed = false;
+
+        while (true) {
+            if (script_engine.IsEnd()) {
+                result.reason = StopReason::END;
+                break;
+            }
+
+            if (result.frames >= max_frames) {
+                result.reason = StopReason::FRAME_LIMIT;
+                break;
+            }
+
+            if (replayer != nullptr && replayer->IsFinished()) {
+                result.reason = StopReason::INPUT_EXHAUSTED;
+                break;
+            }
+
+            auto mouse_input = 0;
+            auto is_escape = false;
+
+            // 入力は押された瞬間で判定されるので、押した次のフレームは必ず離す
+            if (replayer == nullptr && !is_pressed) {
+                if (event_index < events.size()) {
+                    const auto& event = events[event_index];
+                    const auto is_ready = event.is_wait ? script_engine.IsInputWait() : (result.frames >= event.frame);
+
+                    if (is_ready) {
+                        if (!ApplyEvent(script_engine, event, mouse_input, is_escape)) {
+                            result.reason = StopReason::INPUT_ERROR;
+                            break;
+                        }
+
+                        ++event_index;
+                    }
+                }
+                else if (script_engine.IsInputWait()) {
+                    if (!is_auto_click || script_engine.GetState() != ScriptEngine::ScriptState::CLICK_WAIT) {
+                        result.reason = StopReason::INPUT_EXHAUSTED;
+                        break;
+                    }
+
+                    mouse_input = DxWrapper::MOUSE_INPUT_LEFT;
+                    ++result.clicks;
+                }
+            }
+
+            DxHeadless::SetMouseInput(mouse_input);
+            DxHeadless::SetHitKey(DxWrapper::KEY_INPUT_ESCAPE, is_escape);
+
+            is_pressed = (mouse_input != 0) || is_escape;
+
+            if (profiler != nullptr) {
+                profiler->BeginFrame();
+            }
+
+            {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::UPDATE);
+
+                script_engine.Update();
+            }
+
+            // WinMain と同じく描画内容が変化したフレームのみ描画する
+            const auto is_redraw = is_render && (is_full_redraw || script_engine.IsRedrawNeeded());
+
+            if (is_redraw) {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::RENDER);
+
+                script_engine.Render();
+
+                ++result.redraw_frames;
+
+                result.draw_calls += script_engine.GetRenderStats().draw_calls;
+                result.state_changes += script_engine.GetRenderStats().state_changes;
+                result.text_cache_hits = script_engine.GetTextCacheStats().hits;
+                result.text_cache_misses = script_engine.GetTextCacheStats().misses;
+            }
+
+            // ScreenFlip() の代わりに Render() を終えた時点で画面に反映したとする
+            if (latency_tracker != nullptr) {
+                latency_tracker->OnPresent(is_redraw);
+            }
+
+            if (profiler != nullptr) {
+                profiler->EndFrame();
+            }
+
+            AllocTracker::EndFrame();
+
+            if (metrics != nullptr) {
+                metrics->Update(script_engine);
+            }
+
+            if (memory_footprint != nullptr) {
+                memory_footprint->Update(script_engine);
+            }
+
+            ++result.frames;
+
+            if (script_engine.IsExit()) {
+                result.reason = StopReason::EXIT;
+                break;
+            }
+        }
+
+        const auto run_end = Clock::now();
+
+        result.state = script_engine.GetState();
+        result.line = script_engine.GetNowLine();
+        result.initialize_ms = ToMilliseconds(run_start - initialize_start);
+        result.run_ms = ToMilliseconds(run_end - run_start);
+
+        UpdateDigest(static_cast<unsigned long long>(result.state));
+        UpdateDigest(result.line);
+        UpdateDigest(result.frames);
+
+        script_engine.SetListener(nullptr);
+        script_engine.SetInputRecorder(nullptr);
+        script_engine.SetInputReplayer(nullptr);
+        script_engine.SetProfiler(nullptr);
+        script_engine.SetLatencyTracker(nullptr);
+        running_result = nullptr;
+
+        return result.reason == StopReason::END;
+    }
+
+    //!
+    //! @fn void HeadlessRunner::OnParse(unsigned int line, TCHAR command)
+    //! @brief 処理したスクリプトの行数を記録する
+    //! @param[in] line スクリプトの行数
+    //! @param[in] command コマンド文字
+    //! @details SetListener() で設定したリスナーにも通知します。
+    //!
+    void HeadlessRunner::OnParse(unsigned int line, TCHAR command)
+    {
+        if (running_result == nullptr) {
+            return;
+        }
+
+        ++running_result->executed_lines;
+
+        UpdateDigest(running_result->frames);
+        UpdateDigest(line);
+
+        if (is_trace) {
+            running_result->trace.push_back({ running_result->frames, line, command });
+        }
+
+        if (listener != nullptr) {
+            listener->OnParse(line, command);
+        }
+    }
+
+    //!
+    //! @fn void HeadlessRunner::OnParseEnd()
+    //! @brief SetListener() で設定したリスナーに通知する
+    //!
+    void HeadlessRunner::OnParseEnd()
+    {
+        if (listener != nullptr) {
+            listener->OnParseEnd();
+        }
+    }
+
+    //!
+    //! @fn void HeadlessRunner::OnUpdate(ScriptEngine::ScriptState state)
+    //! @brief SetListener() で設定したリスナーに通知する
+    //! @param[in] state このフレームの処理を終えた時のスクリプトエンジンの状態
+    //!
+    void HeadlessRunner::OnUpdate(ScriptEngine::ScriptState state)
+    {
+        if (listener != nullptr) {
+            listener->OnUpdate(state);
+        }
+    }
+
+    //!
+    //! @fn void HeadlessRunner::UpdateDigest(unsigned long long value)
+    //! @brief 実行結果のダイジェストに値を加える
+    //! @param[in] value 加える値
+    //! @details 処理した行とフレームの並びが 1 つでも違えばダイジェストも変わるので
+    //! 記録の再生が完全に再現出来ているかの確認に使用します。
+    //!
+    void HeadlessRunner::UpdateDigest(unsigned long long value)
+    {
+        for (auto i = 0; i < 8; ++i) {
+            running_result->digest ^= (value & 0xff);
+            running_result->digest *= DIGEST_PRIME;
+            value >>= 8;
+        }
+    }
+
+    //!
+    //! @fn bool HeadlessRunner::ApplyEvent(const ScriptEngine& engine, const InputScript::Event& event, int& mouse_input, bool& is_escape)
+    //! @brief 入力イベントを DxHeadless の入力状態に変換する
+    //! @param[in] engine 実行中のスクリプトエンジン
+    //! @param[in] event 入力イベント
+    //! @param[out] mouse_input このフレームのマウスボタンの状態
+    //! @param[out] is_escape このフレームで ESC キーを押すか
+    //! @return 処理の成否(存在しない選択肢を指定した場合など)
+    //!
+    bool HeadlessRunner::ApplyEvent(const ScriptEngine& engine, const InputScript::Event& event, int& mouse_input, bool& is_escape)
+    {
+        switch (event.type) {
+        case InputScript::EventType::CLICK:
+            mouse_input = DxWrapper::MOUSE_INPUT_LEFT;
+            ++running_result->clicks;
+            break;
+
+        case InputScript::EventType::CHOICE:
+        {
+            Rect area;
+
+            if (!engine.GetChoiceArea(event.choice, area)) {
+                return false;
+            }
+
+            DxHeadless::SetMousePoint((area.left + area.right) / 2, (area.top + area.bottom) / 2);
+            mouse_input = DxWrapper::MOUSE_INPUT_LEFT;
+            ++running_result->choices;
+            break;
+        }
+
+        case InputScript::EventType::MOVE:
+            DxHeadless::SetMousePoint(event.x, event.y);
+            break;
+
+        case InputScript::EventType::EXIT:
+            is_escape = true;
+            break;
+        }
+
+        return true;
+    }
+}
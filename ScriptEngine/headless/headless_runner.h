@@ -0,0 +1,132 @@
+﻿//!
+//! @file headless_runner.h
+//!
+//! @brief スクリプトエンジンを画面無しで最速実行するクラス定義
+//!
+#pragma once
+
+#include "script_engine.h"
+#include "script_listener.h"
+#include "input_script.h"
+#include <tchar.h>
+#include <vector>
+
+namespace amg
+{
+    class InputRecorder;
+    class InputReplayer;
+    class FrameProfiler;
+    class ExecutionTrace;
+    class MetricsExporter;
+    class LatencyTracker;
+    class MemoryFootprint;
+
+    class HeadlessRunner final : public ScriptListener
+    {
+    public:
+        enum class StopReason {
+            END,
+            EXIT,
+            INPUT_EXHAUSTED,
+            FRAME_LIMIT,
+            INPUT_ERROR,
+            INITIALIZE_ERROR
+        };
+
+        struct TraceEntry
+        {
+            unsigned int frame;
+            unsigned int line;
+            TCHAR command;
+        };
+
+        struct Result
+        {
+            StopReason reason;
+            ScriptEngine::ScriptState state;
+            unsigned int line;
+            unsigned int frames;
+            unsigned int clicks;
+            unsigned int choices;
+            unsigned long long executed_lines;
+            unsigned long long draw_calls;      // Render() の描画関数の呼び出し回数の合計
+            unsigned long long state_changes;   // Render() の描画ステートの切り替え回数の合計
+            unsigned int redraw_frames;         // 描画内容が変化して Render() を呼び出したフレーム数
+            unsigned long long text_cache_hits;     // 描画済みの文字列の画像を使用した回数
+            unsigned long long text_cache_misses;   // 文字列の画像を作成した回数
+            unsigned long long digest;
+            double initialize_ms;
+            double run_ms;
+            std::vector<TraceEntry> trace;
+
+            Result()
+            {
+                reason = StopReason::END;
+                state = ScriptEngine::ScriptState::PARSING;
+                line = 0;
+                frames = 0;
+                clicks = 0;
+                choices = 0;
+                executed_lines = 0;
+                draw_calls = 0;
+                state_changes = 0;
+                redraw_frames = 0;
+                text_cache_hits = 0;
+                text_cache_misses = 0;
+                digest = 0;
+                initialize_ms = 0.0;
+                run_ms = 0.0;
+            }
+        };
+
+        HeadlessRunner();
+        HeadlessRunner(const HeadlessRunner&) = default;
+        HeadlessRunner(HeadlessRunner&&) noexcept = default;
+
+        virtual ~HeadlessRunner() = default;
+
+        HeadlessRunner& operator=(const HeadlessRunner& right) = default;
+        HeadlessRunner& operator=(HeadlessRunner&& right) noexcept = default;
+
+        inline void SetMaxFrames(const unsigned int frames) { max_frames = frames; }
+        inline void SetAutoClick(const bool auto_click) { is_auto_click = auto_click; }
+        inline void SetRender(const bool render) { is_render = render; }
+        inline void SetFullRedraw(const bool full_redraw) { is_full_redraw = full_redraw; }
+        inline void SetTrace(const bool trace) { is_trace = trace; }
+        inline void SetRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+        inline void SetReplayer(InputReplayer* replayer) { this->replayer = replayer; }
+        inline void SetProfiler(FrameProfiler* profiler) { this->profiler = profiler; }
+        inline void SetListener(ScriptListener* listener) { this->listener = listener; }
+        inline void SetExecutionTrace(ExecutionTrace* execution_trace) { this->execution_trace = execution_trace; }
+        inline void SetMetrics(MetricsExporter* metrics) { this->metrics = metrics; }
+        inline void SetLatencyTracker(LatencyTracker* latency_tracker) { this->latency_tracker = latency_tracker; }
+        inline void SetMemoryFootprint(MemoryFootprint* memory_footprint) { this->memory_footprint = memory_footprint; }
+
+        bool Run(const TCHAR* path, const InputScript& input, Result& result);
+
+        void OnParse(unsigned int line, TCHAR command) override;
+        void OnParseEnd() override;
+        void OnUpdate(ScriptEngine::ScriptState state) override;
+
+    private:
+        bool ApplyEvent(const ScriptEngine& engine, const InputScript::Event& event, int& mouse_input, bool& is_escape);
+
+        void UpdateDigest(unsigned long long value);
+
+        Result* running_result;
+        InputRecorder* recorder;
+        InputReplayer* replayer;
+        FrameProfiler* profiler;
+        ScriptListener* listener;
+        ExecutionTrace* execution_trace;
+        MetricsExporter* metrics;
+        LatencyTracker* latency_tracker;
+        MemoryFootprint* memory_footprint;
+
+        unsigned int max_frames;
+        bool is_auto_click;
+        bool is_render;
+        bool is_full_redraw;
+        bool is_trace;
+    };
+}
@@ -0,0 +1,180 @@
+﻿//!
+//! @file input_script.cpp
+//!
+//! @brief ヘッドレス実行で使用する入力スクリプトの実装
+//!
+//! @details 入力スクリプトの解説
+//!
+//! テキストファイルで 1 行に 1 つの入力イベントを記述します。
+//! '#' から始まる行と空行は無視されます。
+//!
+//! 構文: "フレーム コマンド [パラメータ]"
+//! フレームに数値を指定すると、そのフレーム数に達した時点で入力します。
+//! フレームに '*' を指定すると、スクリプトエンジンがクリック待ちか
+//! 選択待ちになった時点で入力します。
+//!
+//! コマンド: click
+//! 構文: "120 click"
+//! 現在のマウス座標で左クリックします。
+//!
+//! コマンド: choice
+//! 構文: "* choice 1"
+//! 表示中の選択肢(上から 0 番目)の中心を左クリックします。
+//!
+//! コマンド: move
+//! 構文: "300 move 640 360"
+//! マウス座標を移動します。
+//!
+//! コマンド: exit
+//! 構文: "* exit"
+//! ESC キーを押します。
+//!
+#include "input_script.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+    constexpr auto COMMENT = '#';
+    constexpr auto WAIT_FRAME = "*";
+
+    constexpr auto EVENT_CLICK = "click";
+    constexpr auto EVENT_CHOICE = "choice";
+    constexpr auto EVENT_MOVE = "move";
+    constexpr auto EVENT_EXIT = "exit";
+}
+
+namespace amg
+{
+    InputScript::InputScript()
+    {
+        error_line = 0;
+    }
+
+    //!
+    //! @fn bool InputScript::Load(const std::string& path)
+    //! @brief 入力スクリプトファイルの読込
+    //! @param[in] path パス付の入力スクリプトファイル名
+    //! @return 処理の成否
+    //!
+    bool InputScript::Load(const std::string& path)
+    {
+        std::ifstream ifs(path);
+
+        if (!ifs) {
+            return false;
+        }
+
+        return Parse(ifs);
+    }
+
+    //!
+    //! @fn bool InputScript::Parse(std::istream& stream)
+    //! @brief 入力スクリプトの解析
+    //! @param[in] stream 入力スクリプトのストリーム
+    //! @return 処理の成否
+    //! @details 解析に失敗した場合は GetErrorLine() で行数(1 始まり)を取得出来ます。
+    //!
+    bool InputScript::Parse(std::istream& stream)
+    {
+        std::string line;
+        auto line_count = 0U;
+
+        while (std::getline(stream, line)) {
+            ++line_count;
+
+            const auto first = line.find_first_not_of(" \t\r");
+
+            if (first == std::string::npos || line[first] == COMMENT) {
+                continue;
+            }
+
+            Event event;
+
+            if (!ParseLine(line, event)) {
+                error_line = line_count;
+                return false;
+            }
+
+            events.emplace_back(event);
+        }
+
+        error_line = 0;
+
+        return true;
+    }
+
+    //!
+    //! @fn void InputScript::AddEvent(const Event& event)
+    //! @brief 入力イベントを末尾に追加
+    //! @param[in] event 入力イベント
+    //!
+    void InputScript::AddEvent(const Event& event)
+    {
+        events.emplace_back(event);
+    }
+
+    //!
+    //! @fn void InputScript::Clear()
+    //! @brief 全ての入力イベントを削除
+    //!
+    void InputScript::Clear()
+    {
+        events.clear();
+        error_line = 0;
+    }
+
+    //!
+    //! @fn bool InputScript::ParseLine(const std::string& line, Event& event) const
+    //! @brief 入力スクリプトを 1 行解析
+    //! @param[in] line 入力スクリプトの 1 行
+    //! @param[out] event 入力イベント
+    //! @return 処理の成否
+    //!
+    bool InputScript::ParseLine(const std::string& line, Event& event) const
+    {
+        std::istringstream iss(line);
+        std::string frame;
+        std::string command;
+
+        if (!(iss >> frame >> command)) {
+            return false;
+        }
+
+        if (frame == WAIT_FRAME) {
+            event.is_wait = true;
+        }
+        else {
+            std::istringstream frame_iss(frame);
+
+            if (!(frame_iss >> event.frame)) {
+                return false;
+            }
+        }
+
+        if (command == EVENT_CLICK) {
+            event.type = EventType::CLICK;
+        }
+        else if (command == EVENT_CHOICE) {
+            event.type = EventType::CHOICE;
+
+            if (!(iss >> event.choice)) {
+                return false;
+            }
+        }
+        else if (command == EVENT_MOVE) {
+            event.type = EventType::MOVE;
+
+            if (!(iss >> event.x >> event.y)) {
+                return false;
+            }
+        }
+        else if (command == EVENT_EXIT) {
+            event.type = EventType::EXIT;
+        }
+        else {
+            return false;
+        }
+
+        return true;
+    }
+}
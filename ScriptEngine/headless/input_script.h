@@ -0,0 +1,68 @@
+﻿//!
+//! @file input_script.h
+//!
+//! @brief ヘッドレス実行で使用する入力スクリプトの定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+#include <istream>
+
+namespace amg
+{
+    class InputScript
+    {
+    public:
+        enum class EventType {
+            CLICK,
+            CHOICE,
+            MOVE,
+            EXIT
+        };
+
+        struct Event
+        {
+            bool is_wait;
+            unsigned int frame;
+            EventType type;
+            int x;
+            int y;
+            unsigned int choice;
+
+            Event()
+            {
+                is_wait = false;
+                frame = 0;
+                type = EventType::CLICK;
+                x = 0;
+                y = 0;
+                choice = 0;
+            }
+        };
+
+        InputScript();
+        InputScript(const InputScript&) = default;
+        InputScript(InputScript&&) noexcept = default;
+
+        virtual ~InputScript() = default;
+
+        InputScript& operator=(const InputScript& right) = default;
+        InputScript& operator=(InputScript&& right) noexcept = default;
+
+        bool Load(const std::string& path);
+        bool Parse(std::istream& stream);
+
+        void AddEvent(const Event& event);
+        void Clear();
+
+        inline const std::vector<Event>& GetEvents() const { return events; }
+        inline unsigned int GetErrorLine() const { return error_line; }
+
+    private:
+        bool ParseLine(const std::string& line, Event& event) const;
+
+        std::vector<Event> events;
+        unsigned int error_line;
+    };
+}
@@ -0,0 +1,225 @@
+﻿//!
+//! @file script_engine_probe.cpp
+//!
+//! @brief ツールから ScriptEngine の内部処理を直接呼び出すクラス実装
+//!
+#include "script_engine_probe.h"
+#include "command_label.h"
+#include "command_image.h"
+#include "command_choice.h"
+#include "command_message.h"
+#include "command_draw.h"
+#include "scripts_data.h"
+
+namespace amg
+{
+    //!
+    //! @fn void ScriptEngineProbe::PreParsing(ScriptEngine& engine)
+    //! @brief ラベルと画像のリストを作り直す
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //!
+    void ScriptEngineProbe::PreParsing(ScriptEngine& engine)
+    {
+        engine.label_list.clear();
+        engine.image_list.clear();
+        engine.now_line = 0;
+
+        engine.PreParsing();
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::Parsing(ScriptEngine& engine)
+    //! @brief 次の待ち状態まで(又は終端まで)スクリプトを処理する
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //!
+    void ScriptEngineProbe::Parsing(ScriptEngine& engine)
+    {
+        engine.Parsing();
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::UpdateMessage(ScriptEngine& engine)
+    //! @brief メッセージの表示を 1 フレーム分(ScriptEngine::FRAME_US)進める
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //!
+    void ScriptEngineProbe::UpdateMessage(ScriptEngine& engine)
+    {
+        engine.UpdateMessage(ScriptEngine::FRAME_US);
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::Restart(ScriptEngine& engine)
+    //! @brief スクリプトを先頭から処理し直せる状態にする
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //! @details PreParsing() の結果(ラベルと画像)はそのまま残します。
+    //!
+    void ScriptEngineProbe::Restart(ScriptEngine& engine)
+    {
+        engine.state = ScriptEngine::ScriptState::PARSING;
+        engine.now_line = 0;
+        engine.wait_us = 0;
+        engine.reveal_us = 0;
+        engine.message_page_row = -1;
+        engine.is_click_wait_visible = false;
+        engine.is_message_output = false;
+
+        engine.choice_list.clear();
+        engine.message_list.clear();
+        engine.draw_list.clear();
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::SkipWait(ScriptEngine& engine, unsigned int choice)
+    //! @brief 入力無しで現在の待ち状態を終わらせる
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //! @param[in] choice 選択待ちの場合に選ぶ選択肢(選択肢の数で剰余を取る)
+    //! @details クリック待ちと時間待ちはクリックされた時と同じ状態に
+    //! 選択待ちは選択肢をクリックされた時と同じ状態にします。
+    //!
+    void ScriptEngineProbe::SkipWait(ScriptEngine& engine, unsigned int choice)
+    {
+        switch (engine.state) {
+        case ScriptEngine::ScriptState::CHOICE_WAIT:
+            if (!engine.choice_list.empty()) {
+                const auto index = choice % engine.choice_list.size();
+
+                engine.now_line = engine.choice_list[index]->GetLineNumber();
+            }
+
+            engine.choice_list.clear();
+            engine.message_list.clear();
+            break;
+
+        case ScriptEngine::ScriptState::CLICK_WAIT:
+            engine.message_list.clear();
+            break;
+
+        case ScriptEngine::ScriptState::TIME_WAIT:
+            // 時間待ちの後もメッセージは表示されたまま
+            engine.wait_us = 0;
+            break;
+
+        default:
+            return;
+        }
+
+        engine.is_message_output = false;
+        engine.reveal_us = 0;
+        engine.state = ScriptEngine::ScriptState::PARSING;
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::ResetMessageReveal(ScriptEngine& engine)
+    //! @brief 表示中のメッセージを 1 文字も表示していない状態に戻す
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //!
+    void ScriptEngineProbe::ResetMessageReveal(ScriptEngine& engine)
+    {
+        for (auto&& message : engine.message_list) {
+            message->ResetReveal();
+        }
+
+        engine.is_message_output = !engine.message_list.empty();
+        engine.reveal_us = 0;
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::Restore(ScriptEngine& engine, unsigned int line, const std::vector<unsigned int>& draw_lines)
+    //! @brief 選択肢を選んだ直後の状態を復元する
+    //! @param[in,out] engine 初期化済みのスクリプトエンジン
+    //! @param[in] line 処理を再開する行
+    //! @param[in] draw_lines 表示中の画像を描画した 'd' コマンドの行(GetDrawLines() で取得)
+    //! @details 選択肢を選ぶとメッセージと選択肢は消えるので
+    //! 画面に残るのは 'd' コマンドの画像のみです。
+    //!
+    void ScriptEngineProbe::Restore(ScriptEngine& engine, unsigned int line, const std::vector<unsigned int>& draw_lines)
+    {
+        Restart(engine);
+
+        for (auto&& draw_line : draw_lines) {
+            engine.OnCommandDraw(draw_line, engine.scripts_data->GetScript(draw_line));
+        }
+
+        engine.now_line = line;
+    }
+
+    bool ScriptEngineProbe::IsMessageOutput(const ScriptEngine& engine)
+    {
+        return engine.is_message_output;
+    }
+
+    unsigned int ScriptEngineProbe::GetMessageNum(const ScriptEngine& engine)
+    {
+        return static_cast<unsigned int>(engine.message_list.size());
+    }
+
+    unsigned int ScriptEngineProbe::GetLabelNum(const ScriptEngine& engine)
+    {
+        return static_cast<unsigned int>(engine.label_list.size());
+    }
+
+    unsigned int ScriptEngineProbe::GetImageNum(const ScriptEngine& engine)
+    {
+        return static_cast<unsigned int>(engine.image_list.size());
+    }
+
+    unsigned int ScriptEngineProbe::GetDrawNum(const ScriptEngine& engine)
+    {
+        return static_cast<unsigned int>(engine.draw_list.size());
+    }
+
+    unsigned int ScriptEngineProbe::GetWaitCount(const ScriptEngine& engine)
+    {
+        // 固定ステップの Update() の回数に切り上げる
+        return static_cast<unsigned int>((engine.wait_us + ScriptEngine::FRAME_US - 1) / ScriptEngine::FRAME_US);
+    }
+
+    void ScriptEngineProbe::GetDrawLines(const ScriptEngine& engine, std::vector<unsigned int>& draw_lines)
+    {
+        draw_lines.clear();
+
+        for (auto&& draw : engine.draw_list) {
+            draw_lines.emplace_back(draw->GetLineNumber());
+        }
+    }
+
+    //!
+    //! @fn void ScriptEngineProbe::GetChoiceLines(const ScriptEngine& engine, std::vector<unsigned int>& choice_lines)
+    //! @brief 表示中の選択肢の移動先の行を取得する
+    //! @param[in] engine 初期化済みのスクリプトエンジン
+    //! @param[out] choice_lines 移動先の行(上の選択肢から順に)
+    //!
+    void ScriptEngineProbe::GetChoiceLines(const ScriptEngine& engine, std::vector<unsigned int>& choice_lines)
+    {
+        choice_lines.clear();
+
+        for (auto&& choice : engine.choice_list) {
+            choice_lines.emplace_back(choice->GetLineNumber());
+        }
+    }
+
+    std::vector<std::string> ScriptEngineProbe::GetScript(const ScriptEngine& engine, unsigned int line)
+    {
+        return engine.scripts_data->GetScript(line);
+    }
+
+    std::string ScriptEngineProbe::GetLabel(const ScriptEngine& engine, unsigned int index)
+    {
+        return engine.label_list[index]->GetLabel();
+    }
+
+    std::string ScriptEngineProbe::GetImageLabel(const ScriptEngine& engine, unsigned int index)
+    {
+        return engine.image_list[index]->GetLabel();
+    }
+
+    bool ScriptEngineProbe::GetLineNumber(const ScriptEngine& engine, const std::string& str, unsigned int& line)
+    {
+        return engine.GetLineNumber(str, line);
+    }
+
+    bool ScriptEngineProbe::GetImageHandle(const ScriptEngine& engine, const std::string& str, int& handle)
+    {
+        return engine.GetImageHandle(str, handle);
+    }
+}
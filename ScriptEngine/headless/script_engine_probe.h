@@ -0,0 +1,57 @@
+﻿//!
+//! @file script_engine_probe.h
+//!
+//! @brief ツールから ScriptEngine の内部処理を直接呼び出すクラス定義
+//!
+//! @details
+//! ScriptEngine の friend クラスです。
+//! ベンチマークや検証ツールで Parsing() などの処理単位を
+//! 入力やフレームの進行と切り離して呼び出す為に使用します。
+//! ゲーム本体からは使用しません。
+//!
+#pragma once
+
+#include "script_engine.h"
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class ScriptEngineProbe
+    {
+    private:
+        ScriptEngineProbe() = default;
+        ScriptEngineProbe(const ScriptEngineProbe&) = default;
+        ScriptEngineProbe(ScriptEngineProbe&&) noexcept = default;
+
+        virtual ~ScriptEngineProbe() = default;
+
+        ScriptEngineProbe& operator=(const ScriptEngineProbe& right) = default;
+        ScriptEngineProbe& operator=(ScriptEngineProbe&& right) noexcept = default;
+
+    public:
+        static void PreParsing(ScriptEngine& engine);
+        static void Parsing(ScriptEngine& engine);
+        static void UpdateMessage(ScriptEngine& engine);
+
+        static void Restart(ScriptEngine& engine);
+        static void SkipWait(ScriptEngine& engine, unsigned int choice);
+        static void ResetMessageReveal(ScriptEngine& engine);
+        static void Restore(ScriptEngine& engine, unsigned int line, const std::vector<unsigned int>& draw_lines);
+
+        static bool IsMessageOutput(const ScriptEngine& engine);
+        static unsigned int GetMessageNum(const ScriptEngine& engine);
+        static unsigned int GetLabelNum(const ScriptEngine& engine);
+        static unsigned int GetImageNum(const ScriptEngine& engine);
+        static unsigned int GetDrawNum(const ScriptEngine& engine);
+        static unsigned int GetWaitCount(const ScriptEngine& engine);
+        static void GetDrawLines(const ScriptEngine& engine, std::vector<unsigned int>& draw_lines);
+        static void GetChoiceLines(const ScriptEngine& engine, std::vector<unsigned int>& choice_lines);
+        static std::vector<std::string> GetScript(const ScriptEngine& engine, unsigned int line);
+        static std::string GetLabel(const ScriptEngine& engine, unsigned int index);
+        static std::string GetImageLabel(const ScriptEngine& engine, unsigned int index);
+
+        static bool GetLineNumber(const ScriptEngine& engine, const std::string& str, unsigned int& line);
+        static bool GetImageHandle(const ScriptEngine& engine, const std::string& str, int& handle);
+    };
+}
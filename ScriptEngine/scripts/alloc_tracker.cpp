@@ -0,0 +1,353 @@
+﻿//!
+//! @file alloc_tracker.cpp
+//!
+//! @brief メモリ確保を処理単位毎に集計するクラス実装
+//!
+//! @details
+//! アプリ全体の operator new / delete を置き換えて、確保したメモリの前に
+//! サイズと確保した時の処理単位を記録したヘッダーを付けます。
+//! 解放時はヘッダーの処理単位から差し引くので、処理単位毎に確保回数、確保サイズの他に
+//! 解放されずに残っているサイズ(長時間のプレイでメモリが増え続ける原因)とその最大値が分かります。
+//!
+//! 処理単位は AllocTracker::Scope でスレッド毎に切り替えます。
+//! 集計は atomic の加算のみでロックは使用しません。
+//! フレーム毎の値はメインループから EndFrame() を呼び出すと前回からの差分として更新されます。
+//!
+//! operator new を置き換えるので、このファイルはアプリ毎に 1 回だけリンクして下さい。
+//! (DX ライブラリ内部の malloc による確保は含みません)
+//!
+//! 置き換えは AMG_ALLOC_TRACKING を定義したビルド(ゲームの Debug とツール)のみ行います。
+//! 全ての new / delete にヘッダーと共有カウンタの atomic 操作が加わり
+//! 複数スレッドの確保が同じキャッシュラインで競合するので、ゲームの Release では行いません。
+//! 定義していないビルドの集計は全て 0 になり、SaveReport() は失敗します。
+//!
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+
+namespace {
+    constexpr auto SUBSYSTEM_NUM = static_cast<unsigned int>(amg::AllocTracker::Subsystem::NUM);
+
+    // operator new の戻り値のアライメントを保つ為にヘッダーは 16 バイトにする
+    constexpr auto HEADER_SIZE = static_cast<std::size_t>(16);
+
+    struct Header
+    {
+        std::size_t size;
+        unsigned int subsystem;
+    };
+
+    static_assert(sizeof(Header) <= HEADER_SIZE, "alloc header is too large");
+
+    struct Counter
+    {
+        std::atomic<unsigned long long> count;
+        std::atomic<unsigned long long> bytes;
+        std::atomic<long long> live_bytes;
+        std::atomic<long long> peak_live_bytes;
+    };
+
+    // operator new は静的変数の初期化中にも呼ばれるので全て定数で初期化される変数にする
+    Counter counters[SUBSYSTEM_NUM];
+    std::atomic<long long> total_live_bytes(0);
+    std::atomic<long long> total_peak_live_bytes(0);
+    thread_local unsigned int current_subsystem = 0;
+
+    // フレーム毎の差分(メインループのスレッドのみで使用する)
+    amg::AllocTracker::Stats frame_base[SUBSYSTEM_NUM];
+    amg::AllocTracker::Stats frame_stats[SUBSYSTEM_NUM];
+
+#if defined(AMG_ALLOC_TRACKING)
+    void UpdatePeak(std::atomic<long long>& peak, const long long value)
+    {
+        auto current = peak.load(std::memory_order_relaxed);
+
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void* Allocate(std::size_t size)
+    {
+        auto* header = static_cast<Header*>(std::malloc(HEADER_SIZE + size));
+
+        if (header == nullptr) {
+            return nullptr;
+        }
+
+        const auto subsystem = current_subsystem;
+        auto& counter = counters[subsystem];
+        const auto live_bytes = static_cast<long long>(size);
+
+        header->size = size;
+        header->subsystem = subsystem;
+
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+        counter.bytes.fetch_add(size, std::memory_order_relaxed);
+        UpdatePeak(counter.peak_live_bytes, counter.live_bytes.fetch_add(live_bytes, std::memory_order_relaxed) + live_bytes);
+        UpdatePeak(total_peak_live_bytes, total_live_bytes.fetch_add(live_bytes, std::memory_order_relaxed) + live_bytes);
+
+        return reinterpret_cast<unsigned char*>(header) + HEADER_SIZE;
+    }
+
+    void Release(void* memory)
+    {
+        if (memory == nullptr) {
+            return;
+        }
+
+        auto* header = reinterpret_cast<Header*>(static_cast<unsigned char*>(memory) - HEADER_SIZE);
+        const auto live_bytes = static_cast<long long>(header->size);
+
+        counters[header->subsystem].live_bytes.fetch_sub(live_bytes, std::memory_order_relaxed);
+        total_live_bytes.fetch_sub(live_bytes, std::memory_order_relaxed);
+
+        std::free(header);
+    }
+#endif
+
+    void LoadStats(const unsigned int subsystem, amg::AllocTracker::Stats& stats)
+    {
+        const auto& counter = counters[subsystem];
+
+        stats.count = counter.count.load(std::memory_order_relaxed);
+        stats.bytes = counter.bytes.load(std::memory_order_relaxed);
+        stats.live_bytes = counter.live_bytes.load(std::memory_order_relaxed);
+        stats.peak_live_bytes = counter.peak_live_bytes.load(std::memory_order_relaxed);
+    }
+
+    void WriteStats(std::ofstream& file, const char* name, const amg::AllocTracker::Stats& stats)
+    {
+        file << name << "\t" << stats.count << "\t" << stats.bytes << "\t"
+            << stats.live_bytes << "\t" << stats.peak_live_bytes << "\n";
+    }
+}
+
+#if defined(AMG_ALLOC_TRACKING)
+void* operator new(std::size_t size)
+{
+    auto memory = Allocate(size);
+
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    Release(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    Release(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    Release(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    Release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    Release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    Release(memory);
+}
+#endif
+
+namespace amg
+{
+    //!
+    //! @fn AllocTracker::Scope::Scope(Subsystem subsystem)
+    //! @brief このスレッドのメモリ確保の集計先を切り替える
+    //! @param[in] subsystem 処理単位
+    //!
+    AllocTracker::Scope::Scope(Subsystem subsystem)
+    {
+        previous = static_cast<Subsystem>(current_subsystem);
+        current_subsystem = static_cast<unsigned int>(subsystem);
+    }
+
+    AllocTracker::Scope::~Scope()
+    {
+        current_subsystem = static_cast<unsigned int>(previous);
+    }
+
+    //!
+    //! @fn bool AllocTracker::IsEnabled()
+    //! @brief メモリ確保を集計するビルドか
+    //! @return AMG_ALLOC_TRACKING を定義してビルドしたか
+    //!
+    bool AllocTracker::IsEnabled()
+    {
+#if defined(AMG_ALLOC_TRACKING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //!
+    //! @fn void AllocTracker::EndFrame()
+    //! @brief フレーム毎の値を前回の呼び出しからの差分で更新する
+    //! @details メインループのスレッドから毎フレーム 1 回呼び出して下さい。
+    //!
+    void AllocTracker::EndFrame()
+    {
+        for (auto i = 0U; i < SUBSYSTEM_NUM; ++i) {
+            Stats now;
+
+            LoadStats(i, now);
+
+            frame_stats[i].count = now.count - frame_base[i].count;
+            frame_stats[i].bytes = now.bytes - frame_base[i].bytes;
+            frame_stats[i].live_bytes = now.live_bytes - frame_base[i].live_bytes;
+            frame_stats[i].peak_live_bytes = 0;
+
+            frame_base[i] = now;
+        }
+    }
+
+    //!
+    //! @fn void AllocTracker::GetStats(Subsystem subsystem, Stats& stats)
+    //! @brief 起動してからの処理単位毎の集計を取得する
+    //! @param[in] subsystem 処理単位
+    //! @param[out] stats 集計
+    //!
+    void AllocTracker::GetStats(Subsystem subsystem, Stats& stats)
+    {
+        stats = Stats();
+
+        if (subsystem < Subsystem::NUM) {
+            LoadStats(static_cast<unsigned int>(subsystem), stats);
+        }
+    }
+
+    //!
+    //! @fn void AllocTracker::GetFrameStats(Subsystem subsystem, Stats& stats)
+    //! @brief 直前のフレームの処理単位毎の集計を取得する
+    //! @param[in] subsystem 処理単位
+    //! @param[out] stats 集計(live_bytes はフレーム中の増減)
+    //!
+    void AllocTracker::GetFrameStats(Subsystem subsystem, Stats& stats)
+    {
+        stats = Stats();
+
+        if (subsystem < Subsystem::NUM) {
+            stats = frame_stats[static_cast<unsigned int>(subsystem)];
+        }
+    }
+
+    //!
+    //! @fn void AllocTracker::GetTotalStats(Stats& stats)
+    //! @brief 起動してからの全ての処理単位の合計を取得する
+    //! @param[out] stats 集計(peak_live_bytes はアプリ全体で解放されていないサイズの最大値)
+    //!
+    void AllocTracker::GetTotalStats(Stats& stats)
+    {
+        stats = Stats();
+
+        for (auto i = 0U; i < SUBSYSTEM_NUM; ++i) {
+            stats.count += counters[i].count.load(std::memory_order_relaxed);
+            stats.bytes += counters[i].bytes.load(std::memory_order_relaxed);
+        }
+
+        stats.live_bytes = total_live_bytes.load(std::memory_order_relaxed);
+        stats.peak_live_bytes = total_peak_live_bytes.load(std::memory_order_relaxed);
+    }
+
+    //!
+    //! @fn bool AllocTracker::SaveReport(const std::string& path)
+    //! @brief 集計をタブ区切りのテキストファイルに保存する
+    //! @param[in] path 保存するファイル名
+    //! @return 処理の成否
+    //! @details 起動してからの集計と直前のフレームの集計を出力します。
+    //!
+    bool AllocTracker::SaveReport(const std::string& path)
+    {
+        if (!IsEnabled()) {
+            return false;
+        }
+
+        std::ofstream file(path);
+
+        if (!file) {
+            return false;
+        }
+
+        Stats stats;
+
+        file << "[total]\n";
+        file << "subsystem\tcount\tbytes\tlive_bytes\tpeak_live_bytes\n";
+
+        for (auto i = 0U; i < SUBSYSTEM_NUM; ++i) {
+            const auto subsystem = static_cast<Subsystem>(i);
+
+            GetStats(subsystem, stats);
+            WriteStats(file, GetName(subsystem), stats);
+        }
+
+        GetTotalStats(stats);
+        WriteStats(file, "Total", stats);
+
+        file << "\n[frame]\n";
+        file << "subsystem\tcount\tbytes\tlive_bytes\tpeak_live_bytes\n";
+
+        for (auto i = 0U; i < SUBSYSTEM_NUM; ++i) {
+            const auto subsystem = static_cast<Subsystem>(i);
+
+            GetFrameStats(subsystem, stats);
+            WriteStats(file, GetName(subsystem), stats);
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    //!
+    //! @fn const char* AllocTracker::GetName(Subsystem subsystem)
+    //! @brief 処理単位の名前を取得する
+    //! @param[in] subsystem 処理単位
+    //! @return 名前
+    //!
+    const char* AllocTracker::GetName(Subsystem subsystem)
+    {
+        switch (subsystem) {
+        case Subsystem::OTHER: return "Other";
+        case Subsystem::SCRIPTS_DATA: return "ScriptsData";
+        case Subsystem::PICOJSON: return "picojson";
+        case Subsystem::SPLIT: return "Split";
+        case Subsystem::COMMAND: return "Command";
+        case Subsystem::RENDER: return "Render";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+}
@@ -0,0 +1,81 @@
+﻿//!
+//! @file alloc_tracker.h
+//!
+//! @brief メモリ確保を処理単位毎に集計するクラス定義
+//!
+#pragma once
+
+#include <string>
+
+namespace amg
+{
+    class AllocTracker
+    {
+    private:
+        AllocTracker() = default;
+        AllocTracker(const AllocTracker&) = default;
+        AllocTracker(AllocTracker&&) noexcept = default;
+
+        virtual ~AllocTracker() = default;
+
+        AllocTracker& operator=(const AllocTracker& right) = default;
+        AllocTracker& operator=(AllocTracker&& right) noexcept = default;
+
+    public:
+        enum class Subsystem {
+            OTHER,          // 以下のどれにも含まれない確保
+            SCRIPTS_DATA,   // ScriptsData::LoadJson() の文字コード変換と格納
+            PICOJSON,       // picojson の解析と値のコピー
+            SPLIT,          // amg::string::Split()
+            COMMAND,        // ScriptEngine::OnCommand*() のコマンド生成
+            RENDER,         // ScriptEngine::Render() 中の文字列のコピー
+            NUM
+        };
+
+        struct Stats
+        {
+            unsigned long long count;   // 確保回数
+            unsigned long long bytes;   // 確保したサイズの合計
+            long long live_bytes;       // 解放されていないサイズ(フレーム毎の場合はフレーム中の増減)
+            long long peak_live_bytes;  // live_bytes の最大値(フレーム毎の場合は 0)
+
+            Stats()
+            {
+                count = 0;
+                bytes = 0;
+                live_bytes = 0;
+                peak_live_bytes = 0;
+            }
+        };
+
+        //!
+        //! @brief スコープ内のメモリ確保を指定の処理単位に集計する
+        //! @details 入れ子にした場合は内側の処理単位になります。(スレッド毎)
+        //!
+        class Scope
+        {
+        public:
+            explicit Scope(Subsystem subsystem);
+            Scope(const Scope&) = delete;
+            Scope(Scope&&) = delete;
+
+            virtual ~Scope();
+
+            Scope& operator=(const Scope& right) = delete;
+            Scope& operator=(Scope&& right) = delete;
+
+        private:
+            Subsystem previous;
+        };
+
+        static bool IsEnabled();
+        static void EndFrame();
+
+        static void GetStats(Subsystem subsystem, Stats& stats);
+        static void GetFrameStats(Subsystem subsystem, Stats& stats);
+        static void GetTotalStats(Stats& stats);
+        static bool SaveReport(const std::string& path);
+
+        static const char* GetName(Subsystem subsystem);
+    };
+}
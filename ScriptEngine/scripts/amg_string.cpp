@@ -4,6 +4,7 @@
 //! @brief std::string に対してのユーティリティ処理実装
 //!
 #include "amg_string.h"
+#include "alloc_tracker.h"
 
 namespace amg
 {
@@ -25,6 +26,7 @@ namespace amg
 
         std::vector<std::string> Split(const std::string& str, const std::string& delimiter)
         {
+            AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::SPLIT);
             size_t first = 0;
             auto last = str.find_first_of(delimiter);
             std::vector<std::string> split;
@@ -44,5 +46,36 @@ namespace amg
 
             return split;
         }
+
+        //!
+        //! @brief 文字列がヒープに確保しているサイズを取得する
+        //! @details 短い文字列は std::string の中に格納される(SSO)のでヒープには確保しません。
+        //! アロケーターの管理領域は含みません。
+        //!
+        size_t GetHeapBytes(const std::string& str)
+        {
+            static const auto local_capacity = std::string().capacity();
+
+            if (str.capacity() <= local_capacity) {
+                return 0;
+            }
+
+            return (str.capacity() + 1) * sizeof(std::string::value_type);
+        }
+
+        //!
+        //! @brief 文字列の配列がヒープに確保しているサイズを取得する
+        //! @details 配列自身の確保(capacity 分)と各文字列の確保の合計です。
+        //!
+        size_t GetHeapBytes(const std::vector<std::string>& strings)
+        {
+            auto bytes = strings.capacity() * sizeof(std::string);
+
+            for (auto&& str : strings) {
+                bytes += GetHeapBytes(str);
+            }
+
+            return bytes;
+        }
     }
 }
@@ -14,5 +14,7 @@ namespace amg
     {
         bool ToInt(const std::string& str, int& integer);
         std::vector<std::string> Split(const std::string& str, const std::string& delimiter);
+        size_t GetHeapBytes(const std::string& str);
+        size_t GetHeapBytes(const std::vector<std::string>& strings);
     }
 }
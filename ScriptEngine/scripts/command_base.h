@@ -5,6 +5,7 @@
 //!
 #pragma once
 
+#include "amg_string.h"
 #include <vector>
 #include <string>
 
@@ -28,6 +29,7 @@ namespace amg
 
         inline unsigned int GetLineNumber() const { return line; }
         inline std::vector<std::string> GetScript() const { return script; }
+        inline size_t GetScriptBytes() const { return string::GetHeapBytes(script); } // コマンドが持つスクリプトのコピーのサイズ
 
     protected:
         unsigned int line;
@@ -31,6 +31,7 @@ namespace amg
 
         inline std::string GetLabel() const { return script[1]; }
         inline std::string GetMessage() const { return script[2]; }
+        inline const std::string& GetMessageRef() const { return script[2]; } // 毎フレームの描画用(コピーしない)
         inline const Rect& GetArea() const { return area; }
         inline unsigned int GetLineNumber() const { return line; }
 
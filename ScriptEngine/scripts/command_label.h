@@ -25,5 +25,6 @@ namespace amg
         bool Check() override;
 
         inline std::string GetLabel() const { return script[1]; }
+        inline const std::string& GetLabelRef() const { return script[1]; } // 毎フレームの表示用(コピーしない)
     };
 }
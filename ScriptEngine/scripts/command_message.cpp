@@ -14,6 +14,9 @@ namespace amg
     CommandMessage::CommandMessage(unsigned int line, const std::vector<std::string>& script)
         : CommandBase(line, script) {
         right_goal = 0;
+        reveal_glyphs = nullptr;
+        reveal_glyph_num = 0;
+        reveal_index = 0;
     }
 
     bool CommandMessage::Check()
@@ -26,4 +29,58 @@ namespace amg
 
         return true;
     }
+
+    //!
+    //! @fn void CommandMessage::SetRevealGlyphs(const TextLayout::Glyph* glyphs, unsigned int glyph_num)
+    //! @brief 1 文字づつ表示する為の文字の配置を設定する
+    //! @param[in] glyphs 事前に配置した行の先頭の文字
+    //! @param[in] glyph_num 行の文字数
+    //! @details 配置は参照するだけなので、表示中は配置を破棄しないで下さい。
+    //!
+    void CommandMessage::SetRevealGlyphs(const TextLayout::Glyph* glyphs, unsigned int glyph_num)
+    {
+        reveal_glyphs = glyphs;
+        reveal_glyph_num = glyph_num;
+        reveal_index = 0;
+    }
+
+    //!
+    //! @fn bool CommandMessage::RevealGlyph()
+    //! @brief 表示範囲を次の文字の右端まで広げる
+    //! @return 広げた場合は true、全文字列を表示していた場合は false
+    //! @details 幅の無い文字は次の文字と一緒に表示します。
+    //!
+    bool CommandMessage::RevealGlyph()
+    {
+        const auto width = area.right - area.left;
+
+        while (reveal_index < reveal_glyph_num) {
+            const auto right = reveal_glyphs[reveal_index].reveal_right;
+
+            ++reveal_index;
+
+            if (right > width) {
+                area.right = area.left + right;
+                return true;
+            }
+        }
+
+        // 配置が無い場合は一度に全て表示する
+        if (area.right < right_goal) {
+            area.right = right_goal;
+            return true;
+        }
+
+        return false;
+    }
+
+    //!
+    //! @fn void CommandMessage::ResetReveal()
+    //! @brief 表示範囲を先頭の文字の前に戻す
+    //!
+    void CommandMessage::ResetReveal()
+    {
+        area.right = area.left;
+        reveal_index = 0;
+    }
 }
@@ -7,6 +7,7 @@
 
 #include "command_base.h"
 #include "amg_rect.h"
+#include "text_layout.h"
 #include <string>
 
 namespace amg
@@ -29,7 +30,12 @@ namespace amg
             this->area = area; right_goal = goal;
         }
 
+        void SetRevealGlyphs(const TextLayout::Glyph* glyphs, unsigned int glyph_num);
+        bool RevealGlyph();
+        void ResetReveal();
+
         inline std::string GetMessage() const { return script[1]; }
+        inline const std::string& GetMessageRef() const { return script[1]; } // 毎フレームの描画用(コピーしない)
         inline const Rect& GetArea() const { return area; }
         inline int GetRightGoal() const { return right_goal; }
 
@@ -38,5 +44,9 @@ namespace amg
     private:
         Rect area;
         int right_goal;
+
+        const TextLayout::Glyph* reveal_glyphs; // 事前に配置した行の文字(ScriptEngine の配置が保持する)
+        unsigned int reveal_glyph_num;
+        unsigned int reveal_index;
     };
 }
@@ -0,0 +1,41 @@
+﻿//!
+//! @file dx_headless.h
+//!
+//! @brief ヘッドレス(画面無し)実行用の DxWrapper を操作するクラス
+//!
+//! @details
+//! dx_wrapper.cpp の代わりに dx_wrapper_headless.cpp をリンクすると
+//! DX ライブラリを使用せずに DxWrapper の関数が動作します。
+//! (描画は行わず、入力は DxHeadless より設定した値を返します)
+//! ScriptEngine 側はヘッドレスかどうかを意識する必要はありません。
+//!
+#pragma once
+
+#include <tchar.h>
+#include <string>
+
+namespace amg
+{
+    class DxHeadless
+    {
+    private:
+        DxHeadless() = default;
+        DxHeadless(const DxHeadless&) = default;
+        DxHeadless(DxHeadless&&) noexcept = default;
+
+        virtual ~DxHeadless() = default;
+
+        DxHeadless& operator=(const DxHeadless& right) = default;
+        DxHeadless& operator=(DxHeadless&& right) noexcept = default;
+
+    public:
+        static void Reset();
+
+        static void SetBaseDirectory(const std::string& directory);
+        static void SetFileCheck(bool is_check);
+
+        static void SetMousePoint(int x, int y);
+        static void SetMouseInput(int mouse_input);
+        static void SetHitKey(int key_code, bool is_hit);
+    };
+}
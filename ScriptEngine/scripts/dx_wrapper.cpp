@@ -5,6 +5,16 @@
 //!
 #include "dx_wrapper.h"
 #include "DxLib.h"
+#include <vector>
+
+namespace {
+    constexpr int QUAD_VERTEX_NUM = 6;
+
+    unsigned int draw_call_count = 0;
+
+    // Reused between calls so that batched draws do not allocate every frame.
+    std::vector<DxLib::VERTEX2D> batch_vertices;
+}
 
 namespace amg
 {
@@ -33,11 +43,26 @@ namespace amg
         return DxLib::DxLib_End();
     }
 
+    int DxWrapper::SetGraphicsDeviceRestoreCallbackFunction(void (*callback)(void* data), void* callback_data)
+    {
+        return DxLib::SetGraphicsDeviceRestoreCallbackFunction(callback, callback_data);
+    }
+
     int DxWrapper::ProcessMessage()
     {
         return DxLib::ProcessMessage();
     }
 
+    int DxWrapper::GetWindowActiveFlag()
+    {
+        return DxLib::GetWindowActiveFlag();
+    }
+
+    int DxWrapper::GetWindowMinSizeFlag()
+    {
+        return DxLib::GetWindowMinSizeFlag();
+    }
+
     int DxWrapper::SetDrawScreen(int draw_screen)
     {
         return DxLib::SetDrawScreen(draw_screen);
@@ -45,6 +70,8 @@ namespace amg
 
     int DxWrapper::ClearDrawScreen(const tagRECT* clear_rect)
     {
+        draw_call_count = 0;
+
         return DxLib::ClearDrawScreen(clear_rect);
     }
 
@@ -53,6 +80,11 @@ namespace amg
         return DxLib::ScreenFlip();
     }
 
+    int DxWrapper::WaitVSync(int sync_num)
+    {
+        return DxLib::WaitVSync(sync_num);
+    }
+
     int DxWrapper::GetColor(int red, int green, int blue)
     {
         return DxLib::GetColor(red, green, blue);
@@ -68,6 +100,11 @@ namespace amg
         return DxLib::SetFontSize(font_size);
     }
 
+    int DxWrapper::GetDrawStringWidth(const TCHAR* string, int str_len)
+    {
+        return DxLib::GetDrawStringWidth(string, str_len);
+    }
+
     int DxWrapper::GetScreenState(int* size_x, int* size_y, int* color_bit_depth)
     {
         return DxLib::GetScreenState(size_x, size_y, color_bit_depth);
@@ -93,21 +130,130 @@ namespace amg
         return DxLib::LoadGraph(file_name, not_use_3d_flag);
     }
 
+    int DxWrapper::GetGraphSize(int gr_handle, int* size_x_buf, int* size_y_buf)
+    {
+        return DxLib::GetGraphSize(gr_handle, size_x_buf, size_y_buf);
+    }
+
+    int DxWrapper::MakeScreen(int size_x, int size_y, int use_alpha_channel)
+    {
+        return DxLib::MakeScreen(size_x, size_y, use_alpha_channel);
+    }
+
+    int DxWrapper::FillGraph(int gr_handle, int red, int green, int blue, int alpha)
+    {
+        return DxLib::FillGraph(gr_handle, red, green, blue, alpha);
+    }
+
+    int DxWrapper::DeleteGraph(int gr_handle)
+    {
+        return DxLib::DeleteGraph(gr_handle);
+    }
+
+    int DxWrapper::CreateFontToHandle(const TCHAR* font_name, int size, int thick)
+    {
+        return DxLib::CreateFontToHandle(font_name, size, thick);
+    }
+
+    int DxWrapper::DeleteFontToHandle(int font_handle)
+    {
+        return DxLib::DeleteFontToHandle(font_handle);
+    }
+
     int DxWrapper::DrawBox(int x1, int y1, int x2, int y2, unsigned int color, int fill_flag)
     {
+        ++draw_call_count;
+
         return DxLib::DrawBox(x1, y1, x2, y2, color, fill_flag);
     }
 
     int DxWrapper::DrawString(int x, int y, const TCHAR* string, unsigned int color, unsigned int edge_color)
     {
+        ++draw_call_count;
+
         return DxLib::DrawString(x, y, string, color, edge_color);
     }
 
     int DxWrapper::DrawGraph(int x, int y, int gr_handle, int trans_flag)
     {
+        ++draw_call_count;
+
         return DxLib::DrawGraph(x, y, gr_handle, trans_flag);
     }
 
+    int DxWrapper::DrawGraphs(const int* positions, int num, int gr_handle, int trans_flag)
+    {
+        auto size_x = 0;
+        auto size_y = 0;
+        auto texture_x = 0;
+        auto texture_y = 0;
+
+        if (positions == nullptr || num <= 0 || DxLib::GetGraphSize(gr_handle, &size_x, &size_y) != 0
+            || DxLib::GetGraphTextureSize(gr_handle, &texture_x, &texture_y) != 0) {
+            return -1;
+        }
+
+        // A graph larger than its texture is split into several textures and cannot be one quad, so draw it one by one.
+        if (texture_x < size_x || texture_y < size_y) {
+            auto result = 0;
+
+            for (auto i = 0; i < num; ++i) {
+                if (DrawGraph(positions[i * 2], positions[i * 2 + 1], gr_handle, trans_flag) != 0) {
+                    result = -1;
+                }
+            }
+
+            return result;
+        }
+
+        // Non power of two graphs are padded at the right and bottom of the texture, so map only the graph area.
+        const auto u = static_cast<float>(size_x) / static_cast<float>(texture_x);
+        const auto v = static_cast<float>(size_y) / static_cast<float>(texture_y);
+
+        // Two triangles per graph, all sharing the same texture, submitted as one triangle list.
+        batch_vertices.resize(static_cast<size_t>(num) * QUAD_VERTEX_NUM);
+
+        const auto color = DxLib::GetColorU8(255, 255, 255, 255);
+        auto* vertex = batch_vertices.data();
+
+        for (auto i = 0; i < num; ++i) {
+            const auto left = static_cast<float>(positions[i * 2]);
+            const auto top = static_cast<float>(positions[i * 2 + 1]);
+            const auto right = left + static_cast<float>(size_x);
+            const auto bottom = top + static_cast<float>(size_y);
+
+            const float corners[QUAD_VERTEX_NUM][4] = {
+                { left, top, 0.0f, 0.0f }, { right, top, u, 0.0f }, { left, bottom, 0.0f, v },
+                { right, top, u, 0.0f }, { right, bottom, u, v }, { left, bottom, 0.0f, v }
+            };
+
+            for (auto&& corner : corners) {
+                vertex->pos = DxLib::VGet(corner[0], corner[1], 0.0f);
+                vertex->rhw = 1.0f;
+                vertex->dif = color;
+                vertex->u = corner[2];
+                vertex->v = corner[3];
+                ++vertex;
+            }
+        }
+
+        ++draw_call_count;
+
+        return DxLib::DrawPrimitive2D(batch_vertices.data(), num * QUAD_VERTEX_NUM, DX_PRIMTYPE_TRIANGLELIST, gr_handle, trans_flag);
+    }
+
+    int DxWrapper::DrawStringToHandle(int x, int y, const TCHAR* string, unsigned int color, int font_handle)
+    {
+        ++draw_call_count;
+
+        return DxLib::DrawStringToHandle(x, y, string, color, font_handle);
+    }
+
+    unsigned int DxWrapper::GetDrawCallCount()
+    {
+        return draw_call_count;
+    }
+
     int DxWrapper::SetDrawArea(int x1, int y1, int x2, int y2)
     {
         return DxLib::SetDrawArea(x1, y1, x2, y2);
@@ -37,6 +37,8 @@ namespace amg
         static constexpr int FALSE = 0;
 
         static constexpr int KEY_INPUT_ESCAPE = 0x01;
+        static constexpr int KEY_INPUT_F11 = 0x57;
+        static constexpr int KEY_INPUT_F12 = 0x58;
 
         static constexpr int MOUSE_INPUT_LEFT = 0x0001;
         static constexpr int MOUSE_INPUT_RIGHT = 0x0002;
@@ -53,15 +55,22 @@ namespace amg
         static int DxLib_Init();
         static int DxLib_End();
 
+        // デバイスロストから復帰した時に呼び出す関数(MakeScreen の画像は内容が失われている)
+        static int SetGraphicsDeviceRestoreCallbackFunction(void (*callback)(void* data), void* callback_data);
+
         static int ProcessMessage();
+        static int GetWindowActiveFlag();
+        static int GetWindowMinSizeFlag();
 
         static int SetDrawScreen(int draw_screen);
         static int ClearDrawScreen(const tagRECT* clear_rect = nullptr);
         static int ScreenFlip();
+        static int WaitVSync(int sync_num);
 
         static int GetColor(int red, int green, int blue);
 
         static int SetFontSize(int font_size);
+        static int GetDrawStringWidth(const TCHAR* string, int str_len);
 
         static int GetScreenState(int* size_x, int* size_y, int* color_bit_depth);
 
@@ -72,6 +81,13 @@ namespace amg
         static int GetMouseInput();
 
         static int LoadGraph(const TCHAR* file_name, int not_use_3d_flag = FALSE);
+        static int GetGraphSize(int gr_handle, int* size_x_buf, int* size_y_buf);
+        static int MakeScreen(int size_x, int size_y, int use_alpha_channel = FALSE);
+        static int FillGraph(int gr_handle, int red, int green, int blue, int alpha = 255);
+        static int DeleteGraph(int gr_handle);
+
+        static int CreateFontToHandle(const TCHAR* font_name, int size, int thick);
+        static int DeleteFontToHandle(int font_handle);
 
         static int SetDrawArea(int x1, int y1, int x2, int y2);
         static int SetDrawBlendMode(int blend_mode, int blend_param);
@@ -79,5 +95,10 @@ namespace amg
         static int DrawBox(int x1, int y1, int x2, int y2, unsigned int color, int fill_flag);
         static int DrawString(int x, int y, const TCHAR* string, unsigned int color, unsigned int edge_color = 0U);
         static int DrawGraph(int x, int y, int gr_handle, int trans_flag);
+        static int DrawGraphs(const int* positions, int num, int gr_handle, int trans_flag); // 同じ画像を複数の位置(x, y の組)に 1 回の呼び出しで描画(分割された画像は 1 つづつ)
+        static int DrawStringToHandle(int x, int y, const TCHAR* string, unsigned int color, int font_handle);
+
+        // ClearDrawScreen() からの描画関数の呼び出し回数(パフォーマンス表示用)
+        static unsigned int GetDrawCallCount();
     };
 }
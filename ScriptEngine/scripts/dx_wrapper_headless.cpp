@@ -0,0 +1,435 @@
+﻿//!
+//! @file dx_wrapper_headless.cpp
+//!
+//! @brief DX ライブラリを使用しない DxWrapper の実装(ヘッドレス実行用)
+//!
+//! @details
+//! dx_wrapper.cpp と差し替えてリンクします。
+//! 描画系の関数は何も行わず、入力系の関数は DxHeadless で設定された値を返します。
+//!
+#include "dx_wrapper.h"
+#include "dx_headless.h"
+#include <fstream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace {
+    constexpr auto DEFAULT_SCREEN_WIDTH = 640;
+    constexpr auto DEFAULT_SCREEN_HEIGHT = 480;
+    constexpr auto DEFAULT_SCREEN_DEPTH = 32;
+    constexpr auto DEFAULT_FONT_SIZE = 16;
+
+    int screen_width = DEFAULT_SCREEN_WIDTH;
+    int screen_height = DEFAULT_SCREEN_HEIGHT;
+    int screen_depth = DEFAULT_SCREEN_DEPTH;
+    int current_font_size = DEFAULT_FONT_SIZE;
+
+    int mouse_x = 0;
+    int mouse_y = 0;
+    int mouse_input = 0;
+    int hit_key_escape = 0;
+
+    int graph_handle_count = 0;
+    int font_handle_count = 0;
+    unsigned int draw_call_count = 0;
+
+    std::vector<std::pair<int, int>> graph_sizes;   // [ハンドル - 1] = 画像の幅と高さ(分からなければ 0)
+
+    std::string base_directory;
+    bool is_file_check = true;
+
+    // PNG のシグネチャーと先頭の IHDR チャンク
+    constexpr unsigned char PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    constexpr auto PNG_SIGNATURE_SIZE = sizeof(PNG_SIGNATURE);
+    constexpr auto PNG_IHDR_TYPE_OFFSET = 12;
+    constexpr auto PNG_IHDR_WIDTH_OFFSET = 16;
+    constexpr auto PNG_IHDR_HEIGHT_OFFSET = 20;
+    constexpr auto PNG_HEADER_SIZE = 24;
+
+    unsigned int ReadBigEndian(const unsigned char* bytes)
+    {
+        return (static_cast<unsigned int>(bytes[0]) << 24) | (static_cast<unsigned int>(bytes[1]) << 16)
+            | (static_cast<unsigned int>(bytes[2]) << 8) | static_cast<unsigned int>(bytes[3]);
+    }
+
+    //!
+    //! @brief PNG ファイルのヘッダーから画像の幅と高さを取得する
+    //! @details デコードはせずに IHDR チャンクのみ読みます。PNG 以外は失敗します。
+    //!
+    bool ReadPngSize(std::ifstream& ifs, int& width, int& height)
+    {
+        unsigned char header[PNG_HEADER_SIZE] = {};
+
+        if (!ifs.read(reinterpret_cast<char*>(header), PNG_HEADER_SIZE)) {
+            return false;
+        }
+
+        if (!std::equal(PNG_SIGNATURE, PNG_SIGNATURE + PNG_SIGNATURE_SIZE, header)
+            || std::string(reinterpret_cast<const char*>(header + PNG_IHDR_TYPE_OFFSET), 4) != "IHDR") {
+            return false;
+        }
+
+        width = static_cast<int>(ReadBigEndian(header + PNG_IHDR_WIDTH_OFFSET));
+        height = static_cast<int>(ReadBigEndian(header + PNG_IHDR_HEIGHT_OFFSET));
+
+        return true;
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn void DxHeadless::Reset()
+    //! @brief 入力状態と画像ハンドルの採番を初期状態に戻す
+    //! @details 同じスクリプトを何度実行しても同じ結果になる様に
+    //! 実行毎に呼び出します。
+    //!
+    void DxHeadless::Reset()
+    {
+        mouse_x = 0;
+        mouse_y = 0;
+        mouse_input = 0;
+        hit_key_escape = 0;
+        graph_handle_count = 0;
+        graph_sizes.clear();
+        current_font_size = DEFAULT_FONT_SIZE;
+    }
+
+    //!
+    //! @fn void DxHeadless::SetBaseDirectory(const std::string& directory)
+    //! @brief LoadGraph で使用する相対パスの基準ディレクトリを設定
+    //! @param[in] directory 基準ディレクトリ(空文字ならカレントディレクトリ)
+    //!
+    void DxHeadless::SetBaseDirectory(const std::string& directory)
+    {
+        base_directory = directory;
+    }
+
+    //!
+    //! @fn void DxHeadless::SetFileCheck(bool is_check)
+    //! @brief LoadGraph で画像ファイルの存在を確認するか設定
+    //! @param[in] is_check 確認するか(false なら常に成功する)
+    //! @details 自動生成したスクリプトなど、画像ファイルが存在しない場合に使用します。
+    //!
+    void DxHeadless::SetFileCheck(bool is_check)
+    {
+        is_file_check = is_check;
+    }
+
+    //!
+    //! @fn void DxHeadless::SetMousePoint(int x, int y)
+    //! @brief GetMousePoint で返すマウス座標を設定
+    //! @param[in] x X 座標
+    //! @param[in] y Y 座標
+    //!
+    void DxHeadless::SetMousePoint(int x, int y)
+    {
+        mouse_x = x;
+        mouse_y = y;
+    }
+
+    //!
+    //! @fn void DxHeadless::SetMouseInput(int mouse_input)
+    //! @brief GetMouseInput で返すマウスボタンの状態を設定
+    //! @param[in] mouse_input DxWrapper::MOUSE_INPUT_LEFT などの組み合わせ
+    //!
+    void DxHeadless::SetMouseInput(int mouse_input)
+    {
+        ::mouse_input = mouse_input;
+    }
+
+    //!
+    //! @fn void DxHeadless::SetHitKey(int key_code, bool is_hit)
+    //! @brief CheckHitKey で返すキーの状態を設定
+    //! @param[in] key_code キーコード(DxWrapper::KEY_INPUT_ESCAPE のみ対応)
+    //! @param[in] is_hit 押されているか
+    //!
+    void DxHeadless::SetHitKey(int key_code, bool is_hit)
+    {
+        if (key_code == DxWrapper::KEY_INPUT_ESCAPE) {
+            hit_key_escape = is_hit ? 1 : 0;
+        }
+    }
+
+    int DxWrapper::SetMainWindowText(const TCHAR* window_text)
+    {
+        return 0;
+    }
+
+    int DxWrapper::ChangeWindowMode(int flag)
+    {
+        return 0;
+    }
+
+    int DxWrapper::SetGraphMode(int screen_size_x, int screen_size_y, int color_bit_depth, int refresh_rate)
+    {
+        screen_width = screen_size_x;
+        screen_height = screen_size_y;
+        screen_depth = color_bit_depth;
+
+        return 0;
+    }
+
+    int DxWrapper::DxLib_Init()
+    {
+        return 0;
+    }
+
+    int DxWrapper::DxLib_End()
+    {
+        return 0;
+    }
+
+    //!
+    //! @details ヘッドレス実行ではデバイスロストが起きないので呼び出されません。
+    //!
+    int DxWrapper::SetGraphicsDeviceRestoreCallbackFunction(void (*callback)(void* data), void* callback_data)
+    {
+        return 0;
+    }
+
+    int DxWrapper::ProcessMessage()
+    {
+        return 0;
+    }
+
+    int DxWrapper::GetWindowActiveFlag()
+    {
+        return TRUE;
+    }
+
+    int DxWrapper::GetWindowMinSizeFlag()
+    {
+        return FALSE;
+    }
+
+    int DxWrapper::SetDrawScreen(int draw_screen)
+    {
+        return 0;
+    }
+
+    int DxWrapper::ClearDrawScreen(const tagRECT* clear_rect)
+    {
+        draw_call_count = 0;
+
+        return 0;
+    }
+
+    int DxWrapper::ScreenFlip()
+    {
+        return 0;
+    }
+
+    int DxWrapper::WaitVSync(int sync_num)
+    {
+        return 0;
+    }
+
+    int DxWrapper::GetColor(int red, int green, int blue)
+    {
+        return ((red & 0xff) << 16) | ((green & 0xff) << 8) | (blue & 0xff);
+    }
+
+    int DxWrapper::SetMouseDispFlag(int disp_flag)
+    {
+        return 0;
+    }
+
+    int DxWrapper::SetFontSize(int font_size)
+    {
+        current_font_size = font_size;
+
+        return 0;
+    }
+
+    //!
+    //! @details フォントが無いので 1 バイトを半角(フォントサイズの半分)として計算します。
+    //!
+    int DxWrapper::GetDrawStringWidth(const TCHAR* string, int str_len)
+    {
+        return str_len * current_font_size / 2;
+    }
+
+    int DxWrapper::GetScreenState(int* size_x, int* size_y, int* color_bit_depth)
+    {
+        *size_x = screen_width;
+        *size_y = screen_height;
+        *color_bit_depth = screen_depth;
+
+        return 0;
+    }
+
+    int DxWrapper::GetMousePoint(int* x_buf, int* y_buf)
+    {
+        *x_buf = mouse_x;
+        *y_buf = mouse_y;
+
+        return 0;
+    }
+
+    int DxWrapper::CheckHitKey(int key_code)
+    {
+        if (key_code == KEY_INPUT_ESCAPE) {
+            return hit_key_escape;
+        }
+
+        return 0;
+    }
+
+    int DxWrapper::GetMouseInput()
+    {
+        return mouse_input;
+    }
+
+    //!
+    //! @details 画像のデコードは行いませんが
+    //! ファイルが存在しなければ DX ライブラリと同様に -1 を返します。
+    //!
+    int DxWrapper::LoadGraph(const TCHAR* file_name, int not_use_3d_flag)
+    {
+        if (!is_file_check) {
+            graph_sizes.emplace_back(0, 0);
+            return ++graph_handle_count;
+        }
+
+        const auto path = base_directory.empty() ? std::string(file_name) : base_directory + "/" + file_name;
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return -1;
+        }
+
+        auto width = 0;
+        auto height = 0;
+
+        if (!ReadPngSize(ifs, width, height)) {
+            width = 0;
+            height = 0;
+        }
+
+        graph_sizes.emplace_back(width, height);
+
+        return ++graph_handle_count;
+    }
+
+    //!
+    //! @details 画像はデコードしないので LoadGraph で読んだ PNG のヘッダーのサイズを返します。
+    //! (PNG 以外の画像と SetFileCheck(false) の場合は失敗する)
+    //!
+    int DxWrapper::GetGraphSize(int gr_handle, int* size_x_buf, int* size_y_buf)
+    {
+        *size_x_buf = 0;
+        *size_y_buf = 0;
+
+        if (gr_handle <= 0 || static_cast<size_t>(gr_handle) > graph_sizes.size()) {
+            return -1;
+        }
+
+        const auto& size = graph_sizes[gr_handle - 1];
+
+        if (size.first <= 0 || size.second <= 0) {
+            return -1;
+        }
+
+        *size_x_buf = size.first;
+        *size_y_buf = size.second;
+
+        return 0;
+    }
+
+    //!
+    //! @details 描画はしませんが GetGraphSize() はサイズを返します。
+    //!
+    int DxWrapper::MakeScreen(int size_x, int size_y, int use_alpha_channel)
+    {
+        if (size_x <= 0 || size_y <= 0) {
+            return -1;
+        }
+
+        graph_sizes.emplace_back(size_x, size_y);
+
+        return ++graph_handle_count;
+    }
+
+    int DxWrapper::FillGraph(int gr_handle, int red, int green, int blue, int alpha)
+    {
+        return 0;
+    }
+
+    int DxWrapper::DeleteGraph(int gr_handle)
+    {
+        if (gr_handle <= 0 || static_cast<size_t>(gr_handle) > graph_sizes.size()) {
+            return -1;
+        }
+
+        // ハンドルは再利用しないのでサイズのみ消す
+        graph_sizes[gr_handle - 1] = std::make_pair(0, 0);
+
+        return 0;
+    }
+
+    int DxWrapper::CreateFontToHandle(const TCHAR* font_name, int size, int thick)
+    {
+        return ++font_handle_count;
+    }
+
+    int DxWrapper::DeleteFontToHandle(int font_handle)
+    {
+        return 0;
+    }
+
+    int DxWrapper::DrawBox(int x1, int y1, int x2, int y2, unsigned int color, int fill_flag)
+    {
+        ++draw_call_count;
+
+        return 0;
+    }
+
+    int DxWrapper::DrawString(int x, int y, const TCHAR* string, unsigned int color, unsigned int edge_color)
+    {
+        ++draw_call_count;
+
+        return 0;
+    }
+
+    int DxWrapper::DrawGraph(int x, int y, int gr_handle, int trans_flag)
+    {
+        ++draw_call_count;
+
+        return 0;
+    }
+
+    int DxWrapper::DrawGraphs(const int* positions, int num, int gr_handle, int trans_flag)
+    {
+        if (positions == nullptr || num <= 0) {
+            return -1;
+        }
+
+        ++draw_call_count;
+
+        return 0;
+    }
+
+    int DxWrapper::DrawStringToHandle(int x, int y, const TCHAR* string, unsigned int color, int font_handle)
+    {
+        ++draw_call_count;
+
+        return 0;
+    }
+
+    unsigned int DxWrapper::GetDrawCallCount()
+    {
+        return draw_call_count;
+    }
+
+    int DxWrapper::SetDrawArea(int x1, int y1, int x2, int y2)
+    {
+        return 0;
+    }
+
+    int DxWrapper::SetDrawBlendMode(int blend_mode, int blend_param)
+    {
+        return 0;
+    }
+}
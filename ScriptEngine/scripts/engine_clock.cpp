@@ -0,0 +1,66 @@
+﻿//!
+//! @file engine_clock.cpp
+//!
+//! @brief ScriptEngine::Update() に渡す経過時間を計る時計のクラス実装
+//!
+//! @details
+//! std::chrono::steady_clock(単調増加、Windows では QueryPerformanceCounter)で
+//! 前回の Advance() からの経過時間を計ります。
+//!
+//! 可変ステップ : GetDeltaUs() を ScriptEngine::Update(elapsed_us) に 1 回渡します。
+//! 固定ステップ : 経過時間を溜めて、Advance() が返した回数だけ ScriptEngine::Update() を呼び出します。
+//!                (1 回の Update() は常に同じ時間なので、記録した入力を再生すると必ず同じ結果になります)
+//!
+//! どちらもリフレッシュレートやフレーム落ちに関係なく、待ち時間と文字列の表示速度は実時間で進みます。
+//!
+#include "engine_clock.h"
+
+namespace amg
+{
+    EngineClock::EngineClock()
+    {
+        last_time = std::chrono::steady_clock::now();
+        step_us = 1;
+        delta_us = 0;
+        accumulator_us = 0;
+        time_us = 0;
+    }
+
+    //!
+    //! @fn void EngineClock::Start(unsigned int step_us)
+    //! @brief 計測を始める
+    //! @param[in] step_us 固定ステップの 1 回分の時間(ScriptEngine::FRAME_US)
+    //!
+    void EngineClock::Start(unsigned int step_us)
+    {
+        last_time = std::chrono::steady_clock::now();
+        this->step_us = (step_us > 0) ? step_us : 1;
+        delta_us = 0;
+        accumulator_us = 0;
+        time_us = 0;
+    }
+
+    //!
+    //! @fn unsigned int EngineClock::Advance()
+    //! @brief 前回からの経過時間を進める
+    //! @return 溜まった経過時間で進める固定ステップの回数(端数は次回に持ち越す)
+    //! @details 毎フレーム 1 回呼び出します。
+    //! 経過時間は MAX_DELTA_US までとし、それ以上止まっていた分は捨てます。
+    //!
+    unsigned int EngineClock::Advance()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last_time).count();
+
+        last_time = now;
+        delta_us = (elapsed < MAX_DELTA_US) ? static_cast<unsigned int>(elapsed) : MAX_DELTA_US;
+        time_us += delta_us;
+        accumulator_us += delta_us;
+
+        const auto steps = accumulator_us / step_us;
+
+        accumulator_us -= steps * step_us;
+
+        return static_cast<unsigned int>(steps);
+    }
+}
@@ -0,0 +1,42 @@
+﻿//!
+//! @file engine_clock.h
+//!
+//! @brief ScriptEngine::Update() に渡す経過時間を計る時計のクラス定義
+//!
+#pragma once
+
+#include <chrono>
+
+namespace amg
+{
+    class EngineClock
+    {
+    public:
+        // 1 回の Advance() で加算する経過時間の上限(止まっていた時に大量の Update() をしない為)
+        static constexpr unsigned int MAX_DELTA_US = 250000U;
+
+        EngineClock();
+        EngineClock(const EngineClock&) = default;
+        EngineClock(EngineClock&&) noexcept = default;
+
+        virtual ~EngineClock() = default;
+
+        EngineClock& operator=(const EngineClock& right) = default;
+        EngineClock& operator=(EngineClock&& right) noexcept = default;
+
+        void Start(unsigned int step_us);
+        unsigned int Advance();
+
+        inline unsigned int GetDeltaUs() const { return delta_us; }
+        inline unsigned int GetStepUs() const { return step_us; }
+        inline unsigned long long GetTimeUs() const { return time_us; }
+
+    private:
+        std::chrono::steady_clock::time_point last_time;
+
+        unsigned int step_us;
+        unsigned int delta_us;
+        unsigned long long accumulator_us;
+        unsigned long long time_us;
+    };
+}
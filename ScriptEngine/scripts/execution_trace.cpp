@@ -0,0 +1,235 @@
+﻿//!
+//! @file execution_trace.cpp
+//!
+//! @brief 実行したスクリプトの行と状態の遷移を記録するクラス実装
+//!
+//! @details
+//! ScriptEngine が処理した行(行番号、コマンド、フレーム番号)と ScriptState の遷移を
+//! 固定長の記録としてメモリ上のリングバッファに書き込みます。
+//! 1 件の記録はメンバーへの代入のみなので、常に有効にしたままでも処理時間への影響はほとんどありません。
+//! (リングバッファが一周したら古い記録から上書きします)
+//!
+//! プレイヤーからカクつきやクラッシュの報告があった時に、直前に何を処理していたかを
+//! Save() したファイルを TraceDecoder でスクリプトと照らし合わせて確認します。
+//!
+//! クラッシュ時はヒープが壊れているかも知れないので Save() は使用せず
+//! 予め ReserveSaveBuffer() で確保したバッファに SerializeToReserved() で書き込み
+//! 呼び出し側がメモリ確保の無い OS の関数(CreateFileA / WriteFile)でファイルに書き出します。
+//!
+//! @details 保存ファイルの形式
+//!
+//! ヘッダー: "AMGT"(4 バイト) + バージョン(1 バイト) + 記録数(4 バイト リトルエンディアン)
+//! 以降は古い順に 1 件 10 バイトの記録を並べます。
+//! フレーム番号(4 バイト) + 行番号(4 バイト) + 種類(1 バイト) + 値(1 バイト)
+//! (数値は全てリトルエンディアン)
+//!
+#include "execution_trace.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+    constexpr unsigned char MAGIC[] = { 'A', 'M', 'G', 'T' };
+    constexpr unsigned char VERSION = 1;
+    constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 1 + 4;
+    constexpr size_t RECORD_SIZE = 4 + 4 + 1 + 1;
+
+    void WriteUInt32(unsigned char* data, const unsigned int value)
+    {
+        data[0] = static_cast<unsigned char>(value);
+        data[1] = static_cast<unsigned char>(value >> 8);
+        data[2] = static_cast<unsigned char>(value >> 16);
+        data[3] = static_cast<unsigned char>(value >> 24);
+    }
+
+    unsigned int ReadUInt32(const unsigned char* data)
+    {
+        return static_cast<unsigned int>(data[0]) | (static_cast<unsigned int>(data[1]) << 8) |
+            (static_cast<unsigned int>(data[2]) << 16) | (static_cast<unsigned int>(data[3]) << 24);
+    }
+}
+
+namespace amg
+{
+    ExecutionTrace::ExecutionTrace()
+    {
+        entries.reset(new Entry[ENTRY_NUM]);
+        save_buffer = nullptr;
+        write_count = 0;
+        frame = 0;
+    }
+
+    //!
+    //! @fn void ExecutionTrace::Clear()
+    //! @brief 記録を全て消す
+    //!
+    void ExecutionTrace::Clear()
+    {
+        write_count = 0;
+        frame = 0;
+    }
+
+    //!
+    //! @fn void ExecutionTrace::GetEntries(std::vector<Entry>& entries) const
+    //! @brief リングバッファに残っている記録を取得
+    //! @param[out] entries 古い順に並べた記録
+    //!
+    void ExecutionTrace::GetEntries(std::vector<Entry>& entries) const
+    {
+        entries.clear();
+
+        const auto num = static_cast<unsigned int>(std::min<unsigned long long>(write_count, ENTRY_NUM));
+        const auto first = write_count - num;
+
+        entries.reserve(num);
+
+        for (auto i = 0U; i < num; ++i) {
+            entries.emplace_back(this->entries[(first + i) & (ENTRY_NUM - 1)]);
+        }
+    }
+
+    //!
+    //! @fn bool ExecutionTrace::Save(const std::string& path) const
+    //! @brief リングバッファに残っている記録をファイルに保存
+    //! @param[in] path パス付の保存ファイル名
+    //! @return 処理の成否
+    //! @details メモリを確保するのでクラッシュ時は SerializeToReserved() を使用して下さい。
+    //!
+    bool ExecutionTrace::Save(const std::string& path) const
+    {
+        std::ofstream ofs(path, std::ios::binary);
+
+        if (!ofs) {
+            return false;
+        }
+
+        std::vector<unsigned char> data(GetSaveSize());
+
+        Serialize(&(data[0]));
+
+        ofs.write(reinterpret_cast<const char*>(&(data[0])), data.size());
+
+        return ofs.good();
+    }
+
+    //!
+    //! @fn void ExecutionTrace::ReserveSaveBuffer()
+    //! @brief クラッシュ時の保存用に最大の記録数分のバッファを確保する
+    //! @details 記録を開始する前(クラッシュ時の例外フィルターを設定する時)に呼び出して下さい。
+    //!
+    void ExecutionTrace::ReserveSaveBuffer()
+    {
+        if (save_buffer == nullptr) {
+            save_buffer.reset(new unsigned char[HEADER_SIZE + RECORD_SIZE * ENTRY_NUM]);
+        }
+    }
+
+    //!
+    //! @fn const unsigned char* ExecutionTrace::SerializeToReserved(size_t& size) const
+    //! @brief リングバッファに残っている記録を保存ファイルの形式で確保済みのバッファに書き込む
+    //! @param[out] size 書き込んだサイズ
+    //! @return 書き込んだバッファ(ReserveSaveBuffer() を呼び出していない場合は nullptr)
+    //! @details メモリ確保もファイル操作も行わないのでクラッシュ時に呼び出せます。
+    //!
+    const unsigned char* ExecutionTrace::SerializeToReserved(size_t& size) const
+    {
+        size = 0;
+
+        if (save_buffer == nullptr) {
+            return nullptr;
+        }
+
+        size = GetSaveSize();
+        Serialize(save_buffer.get());
+
+        return save_buffer.get();
+    }
+
+    size_t ExecutionTrace::GetSaveSize() const
+    {
+        const auto num = static_cast<size_t>(std::min<unsigned long long>(write_count, ENTRY_NUM));
+
+        return HEADER_SIZE + RECORD_SIZE * num;
+    }
+
+    //!
+    //! @fn void ExecutionTrace::Serialize(unsigned char* data) const
+    //! @brief 記録を保存ファイルの形式で書き込む
+    //! @param[out] data GetSaveSize() 以上のサイズのバッファ
+    //!
+    void ExecutionTrace::Serialize(unsigned char* data) const
+    {
+        const auto num = static_cast<unsigned int>(std::min<unsigned long long>(write_count, ENTRY_NUM));
+        const auto first = write_count - num;
+
+        std::copy(MAGIC, MAGIC + sizeof(MAGIC), data);
+        data[4] = VERSION;
+        WriteUInt32(&data[5], num);
+
+        auto* record = &data[HEADER_SIZE];
+
+        for (auto i = 0U; i < num; ++i) {
+            const auto& entry = entries[(first + i) & (ENTRY_NUM - 1)];
+
+            WriteUInt32(record, entry.frame);
+            WriteUInt32(record + 4, entry.line);
+            record[8] = static_cast<unsigned char>(entry.kind);
+            record[9] = entry.value;
+            record += RECORD_SIZE;
+        }
+    }
+
+    //!
+    //! @fn bool ExecutionTrace::Load(const std::string& path, std::vector<Entry>& entries)
+    //! @brief Save() で保存したファイルの読込
+    //! @param[in] path パス付の保存ファイル名
+    //! @param[out] entries 古い順に並べた記録
+    //! @return 処理の成否
+    //!
+    bool ExecutionTrace::Load(const std::string& path, std::vector<Entry>& entries)
+    {
+        entries.clear();
+
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return false;
+        }
+
+        const std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        if (buffer.size() < HEADER_SIZE || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), buffer.begin())) {
+            return false;
+        }
+
+        if (buffer[4] != VERSION) {
+            return false;
+        }
+
+        const auto num = ReadUInt32(&buffer[5]);
+
+        if (buffer.size() != HEADER_SIZE + RECORD_SIZE * num) {
+            return false;
+        }
+
+        entries.reserve(num);
+
+        for (auto i = 0U; i < num; ++i) {
+            const auto* record = &buffer[HEADER_SIZE + RECORD_SIZE * i];
+            Entry entry;
+
+            if (record[8] >= static_cast<unsigned char>(Kind::NUM)) {
+                return false;
+            }
+
+            entry.frame = ReadUInt32(record);
+            entry.line = ReadUInt32(record + 4);
+            entry.kind = static_cast<Kind>(record[8]);
+            entry.value = record[9];
+
+            entries.emplace_back(entry);
+        }
+
+        return true;
+    }
+}
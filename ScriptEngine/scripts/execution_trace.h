@@ -0,0 +1,96 @@
+﻿//!
+//! @file execution_trace.h
+//!
+//! @brief 実行したスクリプトの行と状態の遷移を記録するクラス定義
+//!
+#pragma once
+
+#include "script_engine.h"
+#include <tchar.h>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace amg
+{
+    class ExecutionTrace
+    {
+    public:
+        enum class Kind : unsigned char {
+            INSTRUCTION,    // Parsing() で処理した行(value はコマンド文字)
+            STATE,          // ScriptState の遷移(value は遷移後の状態)
+            NUM
+        };
+
+        //!
+        //! @brief 固定長の記録 1 件
+        //!
+        struct Entry
+        {
+            unsigned int frame;
+            unsigned int line;
+            Kind kind;
+            unsigned char value;
+
+            Entry()
+            {
+                frame = 0;
+                line = 0;
+                kind = Kind::INSTRUCTION;
+                value = 0;
+            }
+        };
+
+        ExecutionTrace();
+        ExecutionTrace(const ExecutionTrace&) = delete;
+        ExecutionTrace(ExecutionTrace&&) = delete;
+
+        virtual ~ExecutionTrace() = default;
+
+        ExecutionTrace& operator=(const ExecutionTrace& right) = delete;
+        ExecutionTrace& operator=(ExecutionTrace&& right) = delete;
+
+        //! ScriptEngine::Update() の先頭で呼び出す
+        inline void BeginFrame() { ++frame; }
+
+        inline void RecordInstruction(const unsigned int line, const TCHAR command) {
+            Write(line, Kind::INSTRUCTION, static_cast<unsigned char>(command));
+        }
+        inline void RecordState(const unsigned int line, const ScriptEngine::ScriptState state) {
+            Write(line, Kind::STATE, static_cast<unsigned char>(state));
+        }
+
+        void Clear();
+        void GetEntries(std::vector<Entry>& entries) const;
+        bool Save(const std::string& path) const;
+
+        void ReserveSaveBuffer();
+        const unsigned char* SerializeToReserved(size_t& size) const;
+
+        inline unsigned int GetFrame() const { return frame; }
+        inline unsigned long long GetWriteCount() const { return write_count; }
+
+        static bool Load(const std::string& path, std::vector<Entry>& entries);
+
+    private:
+        static constexpr unsigned int ENTRY_NUM = 1U << 16; // 2 のべき乗
+
+        size_t GetSaveSize() const;
+        void Serialize(unsigned char* data) const;
+
+        inline void Write(const unsigned int line, const Kind kind, const unsigned char value) {
+            auto& entry = entries[write_count & (ENTRY_NUM - 1)];
+
+            entry.frame = frame;
+            entry.line = line;
+            entry.kind = kind;
+            entry.value = value;
+            ++write_count;
+        }
+
+        std::unique_ptr<Entry[]> entries;
+        std::unique_ptr<unsigned char[]> save_buffer; // クラッシュ時の保存用(ReserveSaveBuffer() で確保)
+        unsigned long long write_count;
+        unsigned int frame;
+    };
+}
@@ -0,0 +1,317 @@
+﻿//!
+//! @file frame_profiler.cpp
+//!
+//! @brief フレームの処理単位毎の処理時間を計測するクラス実装
+//!
+//! @details
+//! Scope で囲んだ処理の開始時刻と処理時間を固定長のリングバッファに記録します。
+//! 記録は書き込み位置の fetch_add と要素への書き込みのみでロックを使用しないので
+//! 毎フレーム計測したままでも処理時間への影響はほとんどありません。
+//! (リングバッファが一周したら古い記録から上書きします)
+//!
+//! SaveTrace() は Chrome の chrome://tracing や Perfetto で表示出来る
+//! trace event 形式の Json ファイルにリングバッファの内容を保存します。
+//! プレイヤーからカクつきの報告があった時に、どのフレームのどの処理が遅かったかを確認する為に使用します。
+//!
+//! フレーム毎の処理時間は処理単位毎に合計して直近 HISTORY_NUM フレーム分を保持し
+//! GetStats() で中央値、p99、最大値を実行中に取得出来ます。
+//! BeginFrame()、EndFrame()、GetStats() はメインループのスレッドから呼び出して下さい。
+//!
+#include "frame_profiler.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+    constexpr auto EVENT_NUM = 1U << 16; // 2 のべき乗
+    constexpr auto EVENT_MASK = EVENT_NUM - 1;
+    constexpr auto HISTORY_NUM = 600U;   // 60 fps で 10 秒分
+    constexpr auto PHASE_NUM = static_cast<unsigned int>(amg::FrameProfiler::Phase::NUM);
+
+    constexpr auto TRACE_PROCESS_ID = 1;
+
+    using Clock = std::chrono::steady_clock;
+
+    long long GetClockNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    double ToMicroseconds(const long long ns)
+    {
+        return static_cast<double>(ns) / 1000.0;
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn FrameProfiler::Scope::Scope(FrameProfiler* profiler, Phase phase)
+    //! @brief 計測の開始
+    //! @param[in] profiler プロファイラー(nullptr なら計測しない)
+    //! @param[in] phase 処理単位
+    //!
+    FrameProfiler::Scope::Scope(FrameProfiler* profiler, Phase phase)
+    {
+        this->profiler = profiler;
+        this->phase = phase;
+        begin_ns = (profiler != nullptr) ? profiler->Now() : 0;
+    }
+
+    FrameProfiler::Scope::~Scope()
+    {
+        if (profiler != nullptr) {
+            profiler->Record(phase, begin_ns, profiler->Now());
+        }
+    }
+
+    FrameProfiler::FrameProfiler()
+    {
+        events.reset(new Event[EVENT_NUM]);
+        write_index = 0;
+
+        for (auto i = 0U; i < EVENT_NUM; ++i) {
+            events[i].sequence = 0;
+        }
+
+        frame_ns.reset(new std::atomic<long long>[PHASE_NUM]);
+
+        for (auto i = 0U; i < PHASE_NUM; ++i) {
+            frame_ns[i] = 0;
+        }
+
+        history.assign(HISTORY_NUM * PHASE_NUM, 0);
+        samples.reserve(HISTORY_NUM);
+        history_index = 0;
+        history_num = 0;
+        base_ns = GetClockNanoseconds();
+        frame_begin_ns = 0;
+        frame_count = 0;
+    }
+
+    //!
+    //! @fn void FrameProfiler::BeginFrame()
+    //! @brief フレームの開始
+    //!
+    void FrameProfiler::BeginFrame()
+    {
+        frame_begin_ns = Now();
+    }
+
+    //!
+    //! @fn void FrameProfiler::EndFrame()
+    //! @brief フレームの終了
+    //! @details フレーム全体の処理時間を記録して
+    //! このフレームの処理単位毎の合計を統計用の履歴に追加します。
+    //!
+    void FrameProfiler::EndFrame()
+    {
+        Record(Phase::FRAME, frame_begin_ns, Now());
+
+        auto* row = &history[history_index * PHASE_NUM];
+
+        for (auto i = 0U; i < PHASE_NUM; ++i) {
+            row[i] = frame_ns[i].exchange(0, std::memory_order_relaxed);
+        }
+
+        history_index = (history_index + 1) % HISTORY_NUM;
+        history_num = std::min(history_num + 1, HISTORY_NUM);
+
+        frame_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //!
+    //! @fn void FrameProfiler::Record(Phase phase, long long begin_ns, long long end_ns)
+    //! @brief 処理時間を記録する
+    //! @param[in] phase 処理単位
+    //! @param[in] begin_ns 開始時刻(Now() の値)
+    //! @param[in] end_ns 終了時刻(Now() の値)
+    //! @details どのスレッドからでも呼び出せます。
+    //!
+    void FrameProfiler::Record(Phase phase, long long begin_ns, long long end_ns)
+    {
+        if (phase >= Phase::NUM) {
+            return;
+        }
+
+        const auto duration_ns = end_ns - begin_ns;
+        const auto index = write_index.fetch_add(1, std::memory_order_relaxed);
+        auto& event = events[index & EVENT_MASK];
+
+        // 書き込み中は奇数、書き込み後は偶数にする(周回数も含めて読み込み側で照合する)
+        event.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        event.begin_ns.store(begin_ns, std::memory_order_relaxed);
+        event.duration_ns.store(duration_ns, std::memory_order_relaxed);
+        event.frame.store(frame_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        event.thread.store(GetThreadId(), std::memory_order_relaxed);
+        event.phase.store(static_cast<int>(phase), std::memory_order_relaxed);
+
+        event.sequence.store(index * 2 + 2, std::memory_order_release);
+
+        frame_ns[static_cast<unsigned int>(phase)].fetch_add(duration_ns, std::memory_order_relaxed);
+    }
+
+    //!
+    //! @fn bool FrameProfiler::GetStats(Phase phase, Stats& stats) const
+    //! @brief 直近のフレームの処理時間の統計を取得する
+    //! @param[in] phase 処理単位
+    //! @param[out] stats 統計(1 フレーム内の合計の中央値、p99、最大値)
+    //! @return 処理の成否(1 フレームも終了していなければ失敗)
+    //!
+    bool FrameProfiler::GetStats(Phase phase, Stats& stats) const
+    {
+        stats = Stats();
+
+        if (phase >= Phase::NUM || history_num == 0) {
+            return false;
+        }
+
+        samples.clear();
+
+        for (auto i = 0U; i < history_num; ++i) {
+            samples.push_back(history[i * PHASE_NUM + static_cast<unsigned int>(phase)]);
+        }
+
+        const auto p50 = samples.size() / 2;
+        const auto p99 = (samples.size() * 99) / 100;
+
+        std::nth_element(samples.begin(), samples.begin() + p50, samples.end());
+        stats.p50_us = ToMicroseconds(samples[p50]);
+
+        std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+        stats.p99_us = ToMicroseconds(samples[p99]);
+
+        stats.max_us = ToMicroseconds(*std::max_element(samples.begin(), samples.end()));
+        stats.frames = history_num;
+
+        return true;
+    }
+
+    //!
+    //! @fn double FrameProfiler::GetLastFrameUs(Phase phase) const
+    //! @brief 直前に終了したフレームの処理時間を取得する
+    //! @param[in] phase 処理単位
+    //! @return 1 フレーム内の合計(マイクロ秒、1 フレームも終了していなければ 0)
+    //!
+    double FrameProfiler::GetLastFrameUs(Phase phase) const
+    {
+        if (phase >= Phase::NUM || history_num == 0) {
+            return 0.0;
+        }
+
+        const auto index = (history_index + HISTORY_NUM - 1) % HISTORY_NUM;
+
+        return ToMicroseconds(history[index * PHASE_NUM + static_cast<unsigned int>(phase)]);
+    }
+
+    //!
+    //! @fn bool FrameProfiler::SaveTrace(const std::string& path) const
+    //! @brief リングバッファの内容を trace event 形式の Json ファイルに保存する
+    //! @param[in] path 保存するファイル名
+    //! @return 処理の成否
+    //! @details 記録を止めずに保存出来ます。
+    //! 読み込み中に上書きされた要素は保存しません。
+    //!
+    bool FrameProfiler::SaveTrace(const std::string& path) const
+    {
+        std::ofstream file(path);
+
+        if (!file) {
+            return false;
+        }
+
+        const auto end = write_index.load(std::memory_order_acquire);
+        const auto begin = (end > EVENT_NUM) ? (end - EVENT_NUM) : 0;
+        auto is_first = true;
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        for (auto index = begin; index < end; ++index) {
+            const auto& event = events[index & EVENT_MASK];
+            const auto sequence = event.sequence.load(std::memory_order_acquire);
+
+            if (sequence != index * 2 + 2) {
+                continue;
+            }
+
+            const auto begin_ns = event.begin_ns.load(std::memory_order_relaxed);
+            const auto duration_ns = event.duration_ns.load(std::memory_order_relaxed);
+            const auto frame = event.frame.load(std::memory_order_relaxed);
+            const auto thread = event.thread.load(std::memory_order_relaxed);
+            const auto phase = static_cast<Phase>(event.phase.load(std::memory_order_relaxed));
+
+            // 値を読んでいる間に上書きされていないか確認する
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (event.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+
+            file << (is_first ? "\n" : ",\n");
+            file << "{\"name\":\"" << GetName(phase) << "\",\"cat\":\"frame\",\"ph\":\"X\""
+                << ",\"ts\":" << ToMicroseconds(begin_ns) << ",\"dur\":" << ToMicroseconds(duration_ns)
+                << ",\"pid\":" << TRACE_PROCESS_ID << ",\"tid\":" << thread
+                << ",\"args\":{\"frame\":" << frame << "}}";
+
+            is_first = false;
+        }
+
+        file << "\n]}\n";
+
+        return static_cast<bool>(file);
+    }
+
+    //!
+    //! @fn long long FrameProfiler::Now() const
+    //! @brief 現在時刻を取得する
+    //! @return プロファイラーを生成してからの経過時間(ナノ秒)
+    //!
+    long long FrameProfiler::Now() const
+    {
+        return GetClockNanoseconds() - base_ns;
+    }
+
+    //!
+    //! @fn const char* FrameProfiler::GetName(Phase phase)
+    //! @brief 処理単位の名前を取得する
+    //! @param[in] phase 処理単位
+    //! @return 名前(trace event の name に使用する)
+    //!
+    const char* FrameProfiler::GetName(Phase phase)
+    {
+        switch (phase) {
+        case Phase::FRAME: return "Frame";
+        case Phase::UPDATE: return "Update";
+        case Phase::CLEAR: return "ClearDrawScreen";
+        case Phase::RENDER: return "Render";
+        case Phase::FLIP: return "ScreenFlip";
+        case Phase::PARSING: return "Parsing";
+        case Phase::UPDATE_MESSAGE: return "UpdateMessage";
+        case Phase::CHOICE_WAIT: return "ChoiceWait";
+        case Phase::RENDER_IMAGE: return "RenderImage";
+        case Phase::RENDER_MESSAGE: return "RenderMessage";
+        case Phase::RENDER_CHOICE: return "RenderChoice";
+        case Phase::RENDER_SUBMIT: return "RenderSubmit";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+
+    //!
+    //! @fn unsigned int FrameProfiler::GetThreadId()
+    //! @brief 呼び出したスレッドの番号を取得する
+    //! @return 最初に記録したスレッドから順に 1 からの番号
+    //!
+    unsigned int FrameProfiler::GetThreadId()
+    {
+        static std::atomic<unsigned int> thread_num(0);
+        thread_local const auto thread_id = thread_num.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        return thread_id;
+    }
+}
@@ -0,0 +1,129 @@
+﻿//!
+//! @file frame_profiler.h
+//!
+//! @brief フレームの処理単位毎の処理時間を計測するクラス定義
+//!
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class FrameProfiler
+    {
+    public:
+        enum class Phase {
+            FRAME,          // BeginFrame() から EndFrame() まで
+            UPDATE,         // ScriptEngine::Update()
+            CLEAR,          // DxWrapper::ClearDrawScreen()
+            RENDER,         // ScriptEngine::Render()
+            FLIP,           // DxWrapper::ScreenFlip()
+            PARSING,        // ScriptEngine::Parsing()
+            UPDATE_MESSAGE, // ScriptEngine::UpdateMessage()
+            CHOICE_WAIT,    // ScriptEngine::ChoiceWait()
+            RENDER_IMAGE,   // ScriptEngine::RenderImage()
+            RENDER_MESSAGE, // ScriptEngine::RenderMessage()
+            RENDER_CHOICE,  // ScriptEngine::RenderChoice()
+            RENDER_SUBMIT,  // RenderList::Flush()
+            NUM
+        };
+
+        //!
+        //! @brief 直近のフレームの処理時間の統計
+        //!
+        struct Stats
+        {
+            double p50_us;
+            double p99_us;
+            double max_us;
+            unsigned int frames;
+
+            Stats()
+            {
+                p50_us = 0.0;
+                p99_us = 0.0;
+                max_us = 0.0;
+                frames = 0;
+            }
+        };
+
+        //!
+        //! @brief スコープの開始から終了までを計測する
+        //! @details プロファイラーが nullptr なら何もしません。
+        //!
+        class Scope
+        {
+        public:
+            Scope(FrameProfiler* profiler, Phase phase);
+            Scope(const Scope&) = delete;
+            Scope(Scope&&) = delete;
+
+            virtual ~Scope();
+
+            Scope& operator=(const Scope& right) = delete;
+            Scope& operator=(Scope&& right) = delete;
+
+        private:
+            FrameProfiler* profiler;
+            Phase phase;
+            long long begin_ns;
+        };
+
+        FrameProfiler();
+        FrameProfiler(const FrameProfiler&) = delete;
+        FrameProfiler(FrameProfiler&&) = delete;
+
+        virtual ~FrameProfiler() = default;
+
+        FrameProfiler& operator=(const FrameProfiler& right) = delete;
+        FrameProfiler& operator=(FrameProfiler&& right) = delete;
+
+        void BeginFrame();
+        void EndFrame();
+        void Record(Phase phase, long long begin_ns, long long end_ns);
+
+        bool GetStats(Phase phase, Stats& stats) const;
+        double GetLastFrameUs(Phase phase) const;
+        bool SaveTrace(const std::string& path) const;
+
+        inline unsigned int GetFrameCount() const { return frame_count; }
+
+        long long Now() const;
+
+        static const char* GetName(Phase phase);
+
+    private:
+        //!
+        //! @brief リングバッファの 1 要素
+        //! @details sequence が奇数の間は書き込み中です。
+        //! SaveTrace() は書き込みを止めずに読むので全てのメンバーを atomic にしています。
+        //!
+        struct Event
+        {
+            std::atomic<unsigned long long> sequence;
+            std::atomic<long long> begin_ns;
+            std::atomic<long long> duration_ns;
+            std::atomic<unsigned int> frame;
+            std::atomic<unsigned int> thread;
+            std::atomic<int> phase;
+        };
+
+        static unsigned int GetThreadId();
+
+        std::unique_ptr<Event[]> events;
+        std::atomic<unsigned long long> write_index;
+
+        std::unique_ptr<std::atomic<long long>[]> frame_ns;
+        std::vector<long long> history;
+        mutable std::vector<long long> samples; // GetStats() の作業用(毎回確保しない為)
+        unsigned int history_index;
+        unsigned int history_num;
+
+        long long base_ns;
+        long long frame_begin_ns;
+        std::atomic<unsigned int> frame_count;
+    };
+}
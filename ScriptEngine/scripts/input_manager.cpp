@@ -5,6 +5,8 @@
 //!
 #include "dx_wrapper.h"
 #include "input_manager.h"
+#include "input_record.h"
+#include "latency_tracker.h"
 
 namespace {
     constexpr unsigned int dx_mouse_config_num = static_cast<unsigned int>(amg::InputManager::KeyConfig::EXIT);
@@ -20,13 +22,49 @@ namespace {
 
 namespace amg
 {
+    InputManager::InputManager()
+    {
+        cursor_x = 0;
+        cursor_y = 0;
+        recorder = nullptr;
+        replayer = nullptr;
+        latency_tracker = nullptr;
+    }
+
+    //!
+    //! @fn void InputManager::Update()
+    //! @brief 入力状態の更新
+    //! @details 1 フレームに必要な入力は全てここで取得します。
+    //! InputReplayer が設定されていれば DX ライブラリの代わりに記録から取得し
+    //! InputRecorder が設定されていれば取得した入力を記録します。
+    //! LatencyTracker が設定されていればクリックを取得した時刻を記録します。
+    //!
     void InputManager::Update()
     {
+        InputFrame frame;
+
+        if (replayer == nullptr || !replayer->Read(frame)) {
+            frame.key = DxWrapper::CheckHitKey(DxWrapper::KEY_INPUT_ESCAPE);
+            frame.mouse = DxWrapper::GetMouseInput();
+            DxWrapper::GetMousePoint(&(frame.x), &(frame.y));
+        }
+
+        if (recorder != nullptr) {
+            recorder->Write(frame);
+        }
+
         input_key.last = input_key.fresh;
-        input_key.fresh = DxWrapper::CheckHitKey(DxWrapper::KEY_INPUT_ESCAPE);
+        input_key.fresh = frame.key;
 
         input_mouse.last = input_mouse.fresh;
-        input_mouse.fresh = DxWrapper::GetMouseInput();
+        input_mouse.fresh = frame.mouse;
+
+        cursor_x = frame.x;
+        cursor_y = frame.y;
+
+        if (latency_tracker != nullptr && IsClick()) {
+            latency_tracker->OnInput();
+        }
     }
 
     bool InputManager::IsClick() const
@@ -7,6 +7,10 @@
 
 namespace amg
 {
+    class InputRecorder;
+    class InputReplayer;
+    class LatencyTracker;
+
     class InputManager
     {
     public:
@@ -17,7 +21,7 @@ namespace amg
             EXIT
         };
 
-        InputManager() = default;
+        InputManager();
         InputManager(const InputManager&) = default;
         InputManager(InputManager&&) noexcept = default;
 
@@ -30,6 +34,13 @@ namespace amg
         bool IsClick() const;
         bool IsExit() const;
 
+        inline int GetCursorX() const { return cursor_x; }
+        inline int GetCursorY() const { return cursor_y; }
+
+        inline void SetRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+        inline void SetReplayer(InputReplayer* replayer) { this->replayer = replayer; }
+        inline void SetLatencyTracker(LatencyTracker* latency_tracker) { this->latency_tracker = latency_tracker; }
+
     private:
         struct InputState
         {
@@ -48,5 +59,12 @@ namespace amg
 
         InputState input_key;
         InputState input_mouse;
+
+        int cursor_x;
+        int cursor_y;
+
+        InputRecorder* recorder;
+        InputReplayer* replayer;
+        LatencyTracker* latency_tracker;
     };
 }
@@ -0,0 +1,356 @@
+﻿//!
+//! @file input_record.cpp
+//!
+//! @brief フレーム毎の入力状態の記録と再生の実装
+//!
+//! @details 記録ファイルの形式
+//!
+//! ヘッダー: "AMGI"(4 バイト) + バージョン(1 バイト) + 総フレーム数(4 バイト リトルエンディアン)
+//! 以降は前フレームとの差分を 1 レコードとして並べます。
+//!
+//! レコードの先頭 1 バイトは変化したフィールドのフラグです。
+//! 0x01 : キー(可変長整数)
+//! 0x02 : マウスボタン(可変長整数)
+//! 0x04 : マウス座標(前フレームとの差分 X, Y を ZigZag 符号化した可変長整数)
+//! フラグが 0 の場合は、続く可変長整数のフレーム数だけ前フレームと同じ入力が続きます。
+//! (放置されたフレームは何フレームでも数バイトになります)
+//!
+//! 可変長整数は 7 ビット単位で下位から格納し、最上位ビットが続きの有無を表します。
+//!
+#include "input_record.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+    constexpr unsigned char MAGIC[] = { 'A', 'M', 'G', 'I' };
+    constexpr unsigned char VERSION = 1;
+    constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 1 + 4;
+
+    constexpr unsigned char FLAG_REPEAT = 0x00;
+    constexpr unsigned char FLAG_KEY = 0x01;
+    constexpr unsigned char FLAG_MOUSE = 0x02;
+    constexpr unsigned char FLAG_POINT = 0x04;
+    constexpr unsigned char FLAG_ALL = FLAG_KEY | FLAG_MOUSE | FLAG_POINT;
+
+    void WriteVarint(std::vector<unsigned char>& data, unsigned int value)
+    {
+        while (value >= 0x80) {
+            data.emplace_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+
+        data.emplace_back(static_cast<unsigned char>(value));
+    }
+
+    bool ReadVarint(const std::vector<unsigned char>& data, size_t& position, unsigned int& value)
+    {
+        value = 0;
+
+        for (auto shift = 0; shift < 35; shift += 7) {
+            if (position >= data.size()) {
+                return false;
+            }
+
+            const auto byte = data[position++];
+
+            value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    unsigned int ZigZag(const int value)
+    {
+        return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+    }
+
+    int UnZigZag(const unsigned int value)
+    {
+        return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+    }
+}
+
+namespace amg
+{
+    InputRecorder::InputRecorder()
+    {
+        repeat = 0;
+        frame_num = 0;
+    }
+
+    //!
+    //! @fn void InputRecorder::Write(const InputFrame& frame)
+    //! @brief 1 フレーム分の入力状態を記録
+    //! @param[in] frame 入力状態
+    //!
+    void InputRecorder::Write(const InputFrame& frame)
+    {
+        ++frame_num;
+
+        if (frame == last) {
+            ++repeat;
+            return;
+        }
+
+        FlushRepeat();
+
+        auto flags = FLAG_REPEAT;
+
+        if (frame.key != last.key) {
+            flags |= FLAG_KEY;
+        }
+
+        if (frame.mouse != last.mouse) {
+            flags |= FLAG_MOUSE;
+        }
+
+        if (frame.x != last.x || frame.y != last.y) {
+            flags |= FLAG_POINT;
+        }
+
+        data.emplace_back(flags);
+
+        if ((flags & FLAG_KEY) != 0) {
+            WriteVarint(data, static_cast<unsigned int>(frame.key));
+        }
+
+        if ((flags & FLAG_MOUSE) != 0) {
+            WriteVarint(data, static_cast<unsigned int>(frame.mouse));
+        }
+
+        if ((flags & FLAG_POINT) != 0) {
+            WriteVarint(data, ZigZag(frame.x - last.x));
+            WriteVarint(data, ZigZag(frame.y - last.y));
+        }
+
+        last = frame;
+    }
+
+    //!
+    //! @fn bool InputRecorder::Save(const std::string& path)
+    //! @brief 記録した入力状態をファイルに保存
+    //! @param[in] path パス付の保存ファイル名
+    //! @return 処理の成否
+    //!
+    bool InputRecorder::Save(const std::string& path)
+    {
+        FlushRepeat();
+
+        std::ofstream ofs(path, std::ios::binary);
+
+        if (!ofs) {
+            return false;
+        }
+
+        const unsigned char header[HEADER_SIZE] = {
+            MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3], VERSION,
+            static_cast<unsigned char>(frame_num), static_cast<unsigned char>(frame_num >> 8),
+            static_cast<unsigned char>(frame_num >> 16), static_cast<unsigned char>(frame_num >> 24)
+        };
+
+        ofs.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+        if (!data.empty()) {
+            ofs.write(reinterpret_cast<const char*>(&(data[0])), data.size());
+        }
+
+        return ofs.good();
+    }
+
+    //!
+    //! @fn const std::vector<unsigned char>& InputRecorder::GetData()
+    //! @brief 記録したデータ(ヘッダー無し)を取得
+    //! @return 記録したデータ
+    //!
+    const std::vector<unsigned char>& InputRecorder::GetData()
+    {
+        FlushRepeat();
+
+        return data;
+    }
+
+    //!
+    //! @fn void InputRecorder::Clear()
+    //! @brief 記録した入力状態を破棄
+    //!
+    void InputRecorder::Clear()
+    {
+        data.clear();
+        last = InputFrame();
+        repeat = 0;
+        frame_num = 0;
+    }
+
+    //!
+    //! @fn void InputRecorder::FlushRepeat()
+    //! @brief 溜めている同一入力のフレーム数をレコードとして書き出す
+    //!
+    void InputRecorder::FlushRepeat()
+    {
+        if (repeat == 0) {
+            return;
+        }
+
+        data.emplace_back(FLAG_REPEAT);
+        WriteVarint(data, repeat);
+
+        repeat = 0;
+    }
+
+    InputReplayer::InputReplayer()
+    {
+        position = 0;
+        repeat = 0;
+        frame_num = 0;
+        read_num = 0;
+    }
+
+    //!
+    //! @fn bool InputReplayer::Load(const std::string& path)
+    //! @brief InputRecorder で保存したファイルの読込
+    //! @param[in] path パス付の記録ファイル名
+    //! @return 処理の成否
+    //!
+    bool InputReplayer::Load(const std::string& path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return false;
+        }
+
+        const std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        if (buffer.size() < HEADER_SIZE || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), buffer.begin())) {
+            return false;
+        }
+
+        if (buffer[4] != VERSION) {
+            return false;
+        }
+
+        const auto frames = static_cast<unsigned int>(buffer[5]) | (static_cast<unsigned int>(buffer[6]) << 8) |
+            (static_cast<unsigned int>(buffer[7]) << 16) | (static_cast<unsigned int>(buffer[8]) << 24);
+
+        return SetData(std::vector<unsigned char>(buffer.begin() + HEADER_SIZE, buffer.end()), frames);
+    }
+
+    //!
+    //! @fn bool InputReplayer::SetData(const std::vector<unsigned char>& data, unsigned int frame_num)
+    //! @brief InputRecorder の記録をファイルを介さず直接設定
+    //! @param[in] data InputRecorder::GetData() の値
+    //! @param[in] frame_num InputRecorder::GetFrameNum() の値
+    //! @return 処理の成否
+    //!
+    bool InputReplayer::SetData(const std::vector<unsigned char>& data, unsigned int frame_num)
+    {
+        this->data = data;
+        this->frame_num = frame_num;
+
+        Rewind();
+
+        return true;
+    }
+
+    //!
+    //! @fn bool InputReplayer::Read(InputFrame& frame)
+    //! @brief 次の 1 フレーム分の入力状態を取得
+    //! @param[out] frame 入力状態
+    //! @return 取得出来たか(記録の終端や不正なデータなら false)
+    //!
+    bool InputReplayer::Read(InputFrame& frame)
+    {
+        if (IsFinished()) {
+            return false;
+        }
+
+        if (repeat == 0 && !Decode()) {
+            read_num = frame_num;
+            return false;
+        }
+
+        if (repeat > 0) {
+            --repeat;
+        }
+
+        frame = last;
+        ++read_num;
+
+        return true;
+    }
+
+    //!
+    //! @fn void InputReplayer::Rewind()
+    //! @brief 記録の先頭から再生し直す
+    //!
+    void InputReplayer::Rewind()
+    {
+        position = 0;
+        last = InputFrame();
+        repeat = 0;
+        read_num = 0;
+    }
+
+    //!
+    //! @fn bool InputReplayer::Decode()
+    //! @brief 次のレコードを復号する
+    //! @return 処理の成否
+    //! @details 差分レコードなら last を更新し
+    //! 同一入力レコードなら repeat にフレーム数を設定します。
+    //!
+    bool InputReplayer::Decode()
+    {
+        if (position >= data.size()) {
+            return false;
+        }
+
+        const auto flags = data[position++];
+
+        if (flags == FLAG_REPEAT) {
+            return ReadVarint(data, position, repeat) && (repeat > 0);
+        }
+
+        if ((flags & ~FLAG_ALL) != 0) {
+            return false;
+        }
+
+        auto value = 0U;
+
+        if ((flags & FLAG_KEY) != 0) {
+            if (!ReadVarint(data, position, value)) {
+                return false;
+            }
+
+            last.key = static_cast<int>(value);
+        }
+
+        if ((flags & FLAG_MOUSE) != 0) {
+            if (!ReadVarint(data, position, value)) {
+                return false;
+            }
+
+            last.mouse = static_cast<int>(value);
+        }
+
+        if ((flags & FLAG_POINT) != 0) {
+            if (!ReadVarint(data, position, value)) {
+                return false;
+            }
+
+            last.x += UnZigZag(value);
+
+            if (!ReadVarint(data, position, value)) {
+                return false;
+            }
+
+            last.y += UnZigZag(value);
+        }
+
+        return true;
+    }
+}
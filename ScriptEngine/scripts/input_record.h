@@ -0,0 +1,97 @@
+﻿//!
+//! @file input_record.h
+//!
+//! @brief フレーム毎の入力状態の記録と再生の定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    //!
+    //! @brief 1 フレーム分の入力状態
+    //! @details InputManager::Update() で DX ライブラリから取得する値の全てです。
+    //!
+    struct InputFrame
+    {
+        int key;
+        int mouse;
+        int x;
+        int y;
+
+        InputFrame()
+        {
+            key = 0;
+            mouse = 0;
+            x = 0;
+            y = 0;
+        }
+
+        inline bool operator==(const InputFrame& right) const {
+            return (key == right.key) && (mouse == right.mouse) && (x == right.x) && (y == right.y);
+        }
+        inline bool operator!=(const InputFrame& right) const { return !(*this == right); }
+    };
+
+    class InputRecorder
+    {
+    public:
+        InputRecorder();
+        InputRecorder(const InputRecorder&) = default;
+        InputRecorder(InputRecorder&&) noexcept = default;
+
+        virtual ~InputRecorder() = default;
+
+        InputRecorder& operator=(const InputRecorder& right) = default;
+        InputRecorder& operator=(InputRecorder&& right) noexcept = default;
+
+        void Write(const InputFrame& frame);
+        bool Save(const std::string& path);
+        void Clear();
+
+        const std::vector<unsigned char>& GetData();
+        inline unsigned int GetFrameNum() const { return frame_num; }
+
+    private:
+        void FlushRepeat();
+
+        std::vector<unsigned char> data;
+        InputFrame last;
+        unsigned int repeat;
+        unsigned int frame_num;
+    };
+
+    class InputReplayer
+    {
+    public:
+        InputReplayer();
+        InputReplayer(const InputReplayer&) = default;
+        InputReplayer(InputReplayer&&) noexcept = default;
+
+        virtual ~InputReplayer() = default;
+
+        InputReplayer& operator=(const InputReplayer& right) = default;
+        InputReplayer& operator=(InputReplayer&& right) noexcept = default;
+
+        bool Load(const std::string& path);
+        bool SetData(const std::vector<unsigned char>& data, unsigned int frame_num);
+        bool Read(InputFrame& frame);
+        void Rewind();
+
+        inline bool IsFinished() const { return read_num >= frame_num; }
+        inline unsigned int GetFrameNum() const { return frame_num; }
+        inline unsigned int GetReadNum() const { return read_num; }
+
+    private:
+        bool Decode();
+
+        std::vector<unsigned char> data;
+        size_t position;
+        InputFrame last;
+        unsigned int repeat;
+        unsigned int frame_num;
+        unsigned int read_num;
+    };
+}
@@ -0,0 +1,295 @@
+﻿//!
+//! @file latency_tracker.cpp
+//!
+//! @brief クリックしてから画面に反映されるまでの遅延を計測するクラス実装
+//!
+//! @details
+//! 1 回のクリックを次の 4 点で追います。
+//! OnInput()   InputManager::Update() が押された瞬間を取得した時刻とフレーム
+//! OnHandle()  ScriptEngine がクリックを処理した時の操作の種類(最初の 1 回のみ)
+//! OnReflect() 処理した結果が描画内容に現れた(クリック待ちを進めたなら次のメッセージか選択肢、画像を追加したか終了した)
+//! OnPresent() 反映した後に初めて描画して ScreenFlip() した時刻とフレーム
+//!
+//! 遅延は OnInput() から OnPresent() までの時間と、その間のフレーム数です。
+//! メッセージ枠を消しただけのフレームや描画しなかったフレーム(WaitVSync() のみ)では終わりません。
+//! スクリプトが終了した場合は描画内容が変わらないので、描画しなくても次のフレームで終わります。
+//! 処理されなかったクリック(選択肢の外をクリックしたなど)は反映されないので無視した回数として数えます。
+//! DX ライブラリは入力の発生時刻を取得出来ないので、開始はエンジンが入力を取得した時刻です。
+//! (最大 1 フレーム分のポーリングの遅れは含みません)
+//!
+//! フレーム数は入力が同じなら必ず同じになるので、ヘッドレス実行で記録した入力を再生して
+//! エンジンの処理順の変更で反映が遅れていないか確認出来ます。
+//!
+#include "latency_tracker.h"
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+namespace {
+    constexpr auto INTERACTION_NUM = static_cast<unsigned int>(amg::LatencyTracker::Interaction::NUM);
+    constexpr auto NO_PENDING = -1;
+
+    double ToMilliseconds(const long long ns)
+    {
+        return static_cast<double>(ns) / 1000000.0;
+    }
+
+    long long GetPercentile(std::vector<long long>& values, const unsigned int percent)
+    {
+        const auto index = (values.size() * percent) / 100;
+
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+
+        return values[index];
+    }
+}
+
+namespace amg
+{
+    LatencyTracker::LatencyTracker()
+    {
+        samples.resize(INTERACTION_NUM);
+        input_ns = 0;
+        input_frame = 0;
+        frame = 0;
+        ignored_count = 0;
+        pending = NO_PENDING;
+        is_input = false;
+        is_reflected = false;
+        is_drawn = false;
+    }
+
+    //!
+    //! @fn void LatencyTracker::OnInput()
+    //! @brief クリックが押された瞬間を取得した
+    //! @details InputManager::Update() から呼び出します。
+    //!
+    void LatencyTracker::OnInput()
+    {
+        // 前のクリックが反映される前に次のクリックが来たら前のクリックは計測出来なかった
+        if (is_input) {
+            ++ignored_count;
+        }
+
+        input_ns = Now();
+        input_frame = frame;
+        pending = NO_PENDING;
+        is_input = true;
+        is_reflected = false;
+        is_drawn = false;
+    }
+
+    //!
+    //! @fn void LatencyTracker::OnHandle(Interaction interaction)
+    //! @brief クリックを処理した
+    //! @param[in] interaction 操作の種類
+    //! @details 同じクリックを複数の処理が使用した場合は最初の操作になります。
+    //!
+    void LatencyTracker::OnHandle(Interaction interaction)
+    {
+        if (!is_input || pending != NO_PENDING || interaction >= Interaction::NUM) {
+            return;
+        }
+
+        pending = static_cast<int>(interaction);
+    }
+
+    //!
+    //! @fn void LatencyTracker::OnReflect(bool is_drawn)
+    //! @brief 処理したクリックの結果が描画内容に現れた
+    //! @param[in] is_drawn 描画内容が変わらず、既に画面に表示されている結果か(スクリプトの終了など)
+    //! @details 処理していないクリックや既に反映したクリックでは何もしません。
+    //!
+    void LatencyTracker::OnReflect(bool is_drawn)
+    {
+        if (is_input && pending != NO_PENDING && !is_reflected) {
+            is_reflected = true;
+            this->is_drawn = is_drawn;
+        }
+    }
+
+    //!
+    //! @fn void LatencyTracker::OnPresent(bool is_redraw)
+    //! @brief フレームを画面に反映した
+    //! @param[in] is_redraw このフレームを描画したか(前のフレームをそのまま表示したなら false)
+    //! @details ScreenFlip() か WaitVSync() の後(ヘッドレス実行では Render() の後)に毎フレーム呼び出します。
+    //!
+    void LatencyTracker::OnPresent(bool is_redraw)
+    {
+        if (is_input) {
+            if (pending == NO_PENDING) {
+                // 取得したフレームで処理しなかったクリックはこの後も処理されない
+                ++ignored_count;
+                is_input = false;
+            }
+            else if (is_reflected && (is_redraw || is_drawn)) {
+                Sample sample;
+
+                sample.latency_ns = Now() - input_ns;
+                sample.frames = frame - input_frame;
+
+                samples[static_cast<unsigned int>(pending)].emplace_back(sample);
+
+                pending = NO_PENDING;
+                is_input = false;
+                is_reflected = false;
+                is_drawn = false;
+            }
+        }
+
+        ++frame;
+    }
+
+    //!
+    //! @fn void LatencyTracker::Clear()
+    //! @brief 計測結果を全て消す
+    //!
+    void LatencyTracker::Clear()
+    {
+        for (auto&& list : samples) {
+            list.clear();
+        }
+
+        frame = 0;
+        ignored_count = 0;
+        pending = NO_PENDING;
+        is_input = false;
+        is_reflected = false;
+        is_drawn = false;
+    }
+
+    //!
+    //! @fn bool LatencyTracker::GetStats(Interaction interaction, Stats& stats) const
+    //! @brief 操作の種類毎の遅延の統計を取得する
+    //! @param[in] interaction 操作の種類
+    //! @param[out] stats 統計
+    //! @return 処理の成否(1 回も計測していなければ失敗)
+    //!
+    bool LatencyTracker::GetStats(Interaction interaction, Stats& stats) const
+    {
+        stats = Stats();
+
+        if (interaction >= Interaction::NUM) {
+            return false;
+        }
+
+        const auto& list = samples[static_cast<unsigned int>(interaction)];
+
+        if (list.empty()) {
+            return false;
+        }
+
+        std::vector<long long> values;
+
+        values.reserve(list.size());
+
+        for (auto&& sample : list) {
+            values.emplace_back(sample.latency_ns);
+            stats.max_frames = std::max(stats.max_frames, sample.frames);
+        }
+
+        stats.count = static_cast<unsigned int>(list.size());
+        stats.p50_ms = ToMilliseconds(GetPercentile(values, 50));
+        stats.p90_ms = ToMilliseconds(GetPercentile(values, 90));
+        stats.p99_ms = ToMilliseconds(GetPercentile(values, 99));
+        stats.max_ms = ToMilliseconds(*std::max_element(values.begin(), values.end()));
+
+        return true;
+    }
+
+    //!
+    //! @fn void LatencyTracker::GetFrameHistogram(Interaction interaction, std::vector<unsigned int>& histogram) const
+    //! @brief 操作の種類毎の反映までのフレーム数の分布を取得する
+    //! @param[in] interaction 操作の種類
+    //! @param[out] histogram [フレーム数] = 回数
+    //! @details 入力が同じなら処理時間に関係なく同じ値になります。
+    //!
+    void LatencyTracker::GetFrameHistogram(Interaction interaction, std::vector<unsigned int>& histogram) const
+    {
+        histogram.clear();
+
+        if (interaction >= Interaction::NUM) {
+            return;
+        }
+
+        for (auto&& sample : samples[static_cast<unsigned int>(interaction)]) {
+            if (sample.frames >= histogram.size()) {
+                histogram.resize(sample.frames + 1, 0);
+            }
+
+            ++histogram[sample.frames];
+        }
+    }
+
+    //!
+    //! @fn bool LatencyTracker::SaveReport(const std::string& path) const
+    //! @brief 計測結果をタブ区切りのテキストファイルに保存する
+    //! @param[in] path 保存するファイル名
+    //! @return 処理の成否
+    //!
+    bool LatencyTracker::SaveReport(const std::string& path) const
+    {
+        std::ofstream file(path);
+
+        if (!file) {
+            return false;
+        }
+
+        file << "[latency]\n";
+        file << "interaction\tcount\tp50_ms\tp90_ms\tp99_ms\tmax_ms\tmax_frames\n";
+
+        for (auto i = 0U; i < INTERACTION_NUM; ++i) {
+            const auto interaction = static_cast<Interaction>(i);
+            Stats stats;
+
+            GetStats(interaction, stats);
+
+            file << GetName(interaction) << "\t" << stats.count << "\t" << stats.p50_ms << "\t" << stats.p90_ms
+                << "\t" << stats.p99_ms << "\t" << stats.max_ms << "\t" << stats.max_frames << "\n";
+        }
+
+        file << "Ignored\t" << ignored_count << "\n";
+
+        file << "\n[frames]\n";
+        file << "interaction\tframes\tcount\n";
+
+        std::vector<unsigned int> histogram;
+
+        for (auto i = 0U; i < INTERACTION_NUM; ++i) {
+            const auto interaction = static_cast<Interaction>(i);
+
+            GetFrameHistogram(interaction, histogram);
+
+            for (auto frames = 0U; frames < histogram.size(); ++frames) {
+                if (histogram[frames] > 0) {
+                    file << GetName(interaction) << "\t" << frames << "\t" << histogram[frames] << "\n";
+                }
+            }
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    //!
+    //! @fn const char* LatencyTracker::GetName(Interaction interaction)
+    //! @brief 操作の種類の名前を取得する
+    //! @param[in] interaction 操作の種類
+    //! @return 名前
+    //!
+    const char* LatencyTracker::GetName(Interaction interaction)
+    {
+        switch (interaction) {
+        case Interaction::ADVANCE: return "Advance";
+        case Interaction::CHOICE: return "Choice";
+        case Interaction::SKIP: return "Skip";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+
+    long long LatencyTracker::Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
@@ -0,0 +1,86 @@
+﻿//!
+//! @file latency_tracker.h
+//!
+//! @brief クリックしてから画面に反映されるまでの遅延を計測するクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class LatencyTracker
+    {
+    public:
+        enum class Interaction {
+            ADVANCE,    // クリック待ちを進めた(ClickWait)
+            CHOICE,     // 選択肢を選んだ(ChoiceWait)
+            SKIP,       // 表示中の文字列を全て表示した(UpdateMessage)
+            NUM
+        };
+
+        struct Stats
+        {
+            unsigned int count;
+            double p50_ms;
+            double p90_ms;
+            double p99_ms;
+            double max_ms;
+            unsigned int max_frames;    // 入力を取得したフレームから反映したフレームまでのフレーム数の最大値
+
+            Stats()
+            {
+                count = 0;
+                p50_ms = 0.0;
+                p90_ms = 0.0;
+                p99_ms = 0.0;
+                max_ms = 0.0;
+                max_frames = 0;
+            }
+        };
+
+        LatencyTracker();
+        LatencyTracker(const LatencyTracker&) = default;
+        LatencyTracker(LatencyTracker&&) noexcept = default;
+
+        virtual ~LatencyTracker() = default;
+
+        LatencyTracker& operator=(const LatencyTracker& right) = default;
+        LatencyTracker& operator=(LatencyTracker&& right) noexcept = default;
+
+        void OnInput();
+        void OnHandle(Interaction interaction);
+        void OnReflect(bool is_drawn = false);
+        void OnPresent(bool is_redraw);
+
+        void Clear();
+        bool GetStats(Interaction interaction, Stats& stats) const;
+        void GetFrameHistogram(Interaction interaction, std::vector<unsigned int>& histogram) const;
+        bool SaveReport(const std::string& path) const;
+
+        inline unsigned int GetIgnoredCount() const { return ignored_count; }
+
+        static const char* GetName(Interaction interaction);
+
+    private:
+        struct Sample
+        {
+            long long latency_ns;
+            unsigned int frames;
+        };
+
+        long long Now() const;
+
+        std::vector<std::vector<Sample>> samples;
+
+        long long input_ns;
+        unsigned int input_frame;
+        unsigned int frame;
+        unsigned int ignored_count;
+        int pending;    // 反映待ちの Interaction(無ければ -1)
+        bool is_input;
+        bool is_reflected;  // 処理した結果が描画内容に反映されたか
+        bool is_drawn;      // 反映した結果が既に画面に表示されているか(描画し直さなくても終われる)
+    };
+}
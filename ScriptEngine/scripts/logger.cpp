@@ -0,0 +1,282 @@
+﻿//!
+//! @file logger.cpp
+//!
+//! @brief 診断用のログを非同期でファイルに出力するクラス実装
+//!
+//! @details
+//! Write() は固定長のリングバッファの空き要素を CAS で確保して書式化するだけで、
+//! ファイルへの出力はバックグラウンドのスレッドが FLUSH_INTERVAL 毎にまとめて行います。
+//! ロック、メモリ確保、ファイル I/O のいずれも呼び出し側のスレッドでは行わないので
+//! メインループから呼び出してもフレームが止まることはありません。
+//!
+//! リングバッファが一杯の時は書き込まずに捨てて件数を数え、出力スレッドが件数をログに残します。
+//! (製品版でも有効にしたままにする為、待つよりも捨てることを優先しています)
+//!
+//! 出力はタブ区切りで、起動してからの時間(ミリ秒)、レベル、スクリプトの行、ラベル、内容です。
+//! 行は ScriptsData の行番号(0 から)で、スクリプトに関係しない場合は - になります。
+//!
+#include "logger.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iomanip>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+    constexpr auto RECORD_NUM = 1U << 10;   // 2 のべき乗
+    constexpr auto RECORD_MASK = RECORD_NUM - 1;
+    constexpr auto LABEL_LENGTH = 32U;
+    constexpr auto MESSAGE_LENGTH = 208U;
+
+    constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(10);
+
+    using Clock = std::chrono::steady_clock;
+
+    //!
+    //! @brief リングバッファの 1 要素
+    //! @details sequence が書き込み位置と一致すれば空き、書き込み位置 + 1 なら出力待ちです。
+    //!
+    struct Record
+    {
+        std::atomic<unsigned long long> sequence;
+        long long time_ns;
+        unsigned int line;
+        int level;
+        char label[LABEL_LENGTH];
+        char message[MESSAGE_LENGTH];
+    };
+
+    Record records[RECORD_NUM];
+    std::atomic<unsigned long long> write_index(0);
+    unsigned long long read_index = 0;  // 出力スレッドのみで使用する
+
+    std::atomic<bool> is_running(false);
+    std::atomic<unsigned long long> dropped_count(0);
+    unsigned long long reported_dropped_count = 0;
+
+    std::thread writer;
+    std::ofstream file;
+    Clock::time_point base_time;
+
+    long long GetElapsedNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - base_time).count();
+    }
+
+    void CopyLabel(char* dest, const char* label)
+    {
+        auto i = 0U;
+
+        if (label != nullptr) {
+            for (; i < LABEL_LENGTH - 1 && label[i] != '\0'; ++i) {
+                dest[i] = label[i];
+            }
+        }
+
+        dest[i] = '\0';
+    }
+
+    //!
+    //! @brief 出力待ちの要素を全てファイルに書き出す
+    //! @details 出力スレッド(終了時は Destroy() を呼び出したスレッド)のみで呼び出します。
+    //!
+    void Drain()
+    {
+        for (;;) {
+            auto& record = records[read_index & RECORD_MASK];
+
+            if (record.sequence.load(std::memory_order_acquire) != read_index + 1) {
+                break;
+            }
+
+            const auto level = static_cast<amg::Logger::Level>(record.level);
+
+            file << std::fixed << std::setprecision(3) << (static_cast<double>(record.time_ns) / 1000000.0)
+                << "\t" << amg::Logger::GetName(level) << "\t";
+
+            if (record.line == amg::Logger::NO_LINE) {
+                file << "-";
+            }
+            else {
+                file << record.line;
+            }
+
+            file << "\t" << record.label << "\t" << record.message << "\n";
+
+            // 次に一周して来た書き込みの為に空きにする
+            record.sequence.store(read_index + RECORD_NUM, std::memory_order_release);
+            ++read_index;
+        }
+
+        const auto dropped = dropped_count.load(std::memory_order_relaxed);
+
+        if (dropped != reported_dropped_count) {
+            file << std::fixed << std::setprecision(3) << (static_cast<double>(GetElapsedNanoseconds()) / 1000000.0)
+                << "\t" << amg::Logger::GetName(amg::Logger::Level::WARNING) << "\t-\t\t"
+                << (dropped - reported_dropped_count) << " log records were dropped (buffer full)\n";
+
+            reported_dropped_count = dropped;
+        }
+
+        file.flush();
+    }
+
+    void WriterMain()
+    {
+        while (is_running.load(std::memory_order_acquire)) {
+            Drain();
+
+            std::this_thread::sleep_for(FLUSH_INTERVAL);
+        }
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn bool Logger::Initialize(const std::string& path)
+    //! @brief ログファイルを開いて出力スレッドを開始する
+    //! @param[in] path ログファイル名(上書き)
+    //! @return 処理の成否
+    //! @details Write() を呼び出すスレッドが動き出す前に呼び出して下さい。
+    //!
+    bool Logger::Initialize(const std::string& path)
+    {
+        Destroy();
+
+        file.open(path, std::ios::out | std::ios::trunc);
+
+        if (!file) {
+            return false;
+        }
+
+        for (auto i = 0U; i < RECORD_NUM; ++i) {
+            records[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        write_index.store(0, std::memory_order_relaxed);
+        read_index = 0;
+        dropped_count.store(0, std::memory_order_relaxed);
+        reported_dropped_count = 0;
+        base_time = Clock::now();
+
+        file << "time_ms\tlevel\tline\tlabel\tmessage\n";
+
+        is_running.store(true, std::memory_order_release);
+        writer = std::thread(WriterMain);
+
+        return true;
+    }
+
+    //!
+    //! @fn void Logger::Destroy()
+    //! @brief 出力スレッドを止めて残っているログを全て書き出す
+    //!
+    void Logger::Destroy()
+    {
+        if (!is_running.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        if (writer.joinable()) {
+            writer.join();
+        }
+
+        Drain();
+        file.close();
+    }
+
+    //!
+    //! @fn void Logger::Write(Level level, unsigned int line, const char* label, const char* format, ...)
+    //! @brief ログをリングバッファに書き込む
+    //! @param[in] level レベル
+    //! @param[in] line スクリプトの行(関係しなければ NO_LINE)
+    //! @param[in] label スクリプトのラベル(nullptr 可、LABEL_LENGTH - 1 バイトまで)
+    //! @param[in] format printf 形式の書式(MESSAGE_LENGTH - 1 バイトまで)
+    //! @details 直接呼び出さずに AMG_LOG_* マクロを使用して下さい。
+    //! Initialize() 前とリングバッファが一杯の時は何もしません。
+    //!
+    void Logger::Write(Level level, unsigned int line, const char* label, const char* format, ...)
+    {
+        if (!is_running.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        auto index = write_index.load(std::memory_order_relaxed);
+        Record* record = nullptr;
+
+        for (;;) {
+            record = &records[index & RECORD_MASK];
+
+            const auto sequence = record->sequence.load(std::memory_order_acquire);
+
+            if (sequence == index) {
+                if (write_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (sequence < index) {
+                // 出力スレッドがまだ書き出していない
+                dropped_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else {
+                index = write_index.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->time_ns = GetElapsedNanoseconds();
+        record->line = line;
+        record->level = static_cast<int>(level);
+        CopyLabel(record->label, label);
+
+        va_list args;
+
+        va_start(args, format);
+        std::vsnprintf(record->message, MESSAGE_LENGTH, format, args);
+        va_end(args);
+
+        record->sequence.store(index + 1, std::memory_order_release);
+    }
+
+    //!
+    //! @fn bool Logger::IsRunning()
+    //! @brief ログを出力中か調べる
+    //! @return Initialize() に成功してから Destroy() するまで true
+    //!
+    bool Logger::IsRunning()
+    {
+        return is_running.load(std::memory_order_acquire);
+    }
+
+    //!
+    //! @fn unsigned long long Logger::GetDroppedCount()
+    //! @brief リングバッファが一杯で捨てたログの件数を取得する
+    //! @return 件数
+    //!
+    unsigned long long Logger::GetDroppedCount()
+    {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+    //!
+    //! @fn const char* Logger::GetName(Level level)
+    //! @brief レベルの名前を取得する
+    //! @param[in] level レベル
+    //! @return 名前
+    //!
+    const char* Logger::GetName(Level level)
+    {
+        switch (level) {
+        case Level::DEBUG: return "DEBUG";
+        case Level::INFO: return "INFO";
+        case Level::WARNING: return "WARNING";
+        case Level::CRITICAL: return "CRITICAL";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+}
@@ -0,0 +1,72 @@
+﻿//!
+//! @file logger.h
+//!
+//! @brief 診断用のログを非同期でファイルに出力するクラス定義
+//!
+#pragma once
+
+#include <string>
+
+//!
+//! @brief コンパイル時に出力するログのレベル(amg::Logger::Level の値)
+//! @details これより低いレベルの AMG_LOG_* は引数も評価されずに消えます。
+//! 省略時はデバッグビルドで全て、リリースビルドで INFO 以上を出力します。
+//!
+#ifndef AMG_LOG_LEVEL
+#ifdef _DEBUG
+#define AMG_LOG_LEVEL 0
+#else
+#define AMG_LOG_LEVEL 1
+#endif
+#endif
+
+#define AMG_LOG(level, line, label, ...) \
+    do { \
+        if (static_cast<int>(level) >= AMG_LOG_LEVEL) { \
+            amg::Logger::Write(level, line, label, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#define AMG_LOG_DEBUG(line, label, ...) AMG_LOG(amg::Logger::Level::DEBUG, line, label, __VA_ARGS__)
+#define AMG_LOG_INFO(line, label, ...) AMG_LOG(amg::Logger::Level::INFO, line, label, __VA_ARGS__)
+#define AMG_LOG_WARNING(line, label, ...) AMG_LOG(amg::Logger::Level::WARNING, line, label, __VA_ARGS__)
+#define AMG_LOG_CRITICAL(line, label, ...) AMG_LOG(amg::Logger::Level::CRITICAL, line, label, __VA_ARGS__)
+
+namespace amg
+{
+    class Logger
+    {
+    private:
+        Logger() = default;
+        Logger(const Logger&) = default;
+        Logger(Logger&&) noexcept = default;
+
+        virtual ~Logger() = default;
+
+        Logger& operator=(const Logger& right) = default;
+        Logger& operator=(Logger&& right) noexcept = default;
+
+    public:
+        // windows.h の ERROR マクロと衝突しないように CRITICAL としています
+        enum class Level {
+            DEBUG,      // 開発中の動作確認
+            INFO,       // 起動や終了などの通知
+            WARNING,    // 処理出来ずに読み飛ばしたスクリプト
+            CRITICAL,   // 続行出来ない失敗
+            NUM
+        };
+
+        //! スクリプトの行に関係しないログの行番号
+        static constexpr unsigned int NO_LINE = 0xffffffff;
+
+        static bool Initialize(const std::string& path);
+        static void Destroy();
+
+        static void Write(Level level, unsigned int line, const char* label, const char* format, ...);
+
+        static bool IsRunning();
+        static unsigned long long GetDroppedCount();
+
+        static const char* GetName(Level level);
+    };
+}
@@ -0,0 +1,265 @@
+﻿//!
+//! @file memory_footprint.cpp
+//!
+//! @brief スクリプトエンジンの構造毎のメモリ使用量を集計するクラス実装
+//!
+//! @details
+//! AllocTracker は処理単位毎の確保の回数と量を数えますが
+//! こちらはその時点でスクリプトエンジンが保持しているサイズを構造毎に数えます。
+//!
+//! コマンドのリストは配列(capacity 分)、コマンドのオブジェクト、コマンドが持つスクリプトのコピー
+//! (分割した文字列の配列と各文字列)のサイズの合計です。
+//! 文字列は std::string の中に格納される短い文字列(SSO)を除いたヒープのサイズで
+//! アロケーターの管理領域は含みません。
+//! テクスチャーは画像のサイズを 1 ピクセル 4 バイトとしたサイズです。(VRAM の実際の配置は含みません)
+//!
+//! Update() を毎フレーム呼び出すと最大値も記録するので、メモリの予算を決めたり
+//! 変更でメモリが減ったかを確認出来ます。
+//!
+#include "dx_wrapper.h"
+#include "memory_footprint.h"
+#include "script_engine.h"
+#include "scripts_data.h"
+#include "command_label.h"
+#include "command_image.h"
+#include "command_choice.h"
+#include "command_message.h"
+#include "command_draw.h"
+#include <fstream>
+#include <algorithm>
+
+namespace {
+    constexpr auto PART_NUM = static_cast<unsigned int>(amg::MemoryFootprint::Part::NUM);
+    constexpr auto TEXTURE_PIXEL_BYTES = 4ULL;
+
+    //!
+    //! @brief コマンドのリストが使用しているサイズを取得する
+    //!
+    template <typename T>
+    unsigned long long GetListBytes(const std::vector<std::unique_ptr<T>>& list)
+    {
+        auto bytes = static_cast<unsigned long long>(list.capacity() * sizeof(std::unique_ptr<T>));
+
+        for (auto&& command : list) {
+            bytes += sizeof(T) + command->GetScriptBytes();
+        }
+
+        return bytes;
+    }
+
+    //!
+    //! @brief 事前に配置した文字列が使用しているサイズを取得する
+    //! @details unordered_map のノードとバケットの管理領域は含みません。
+    //!
+    unsigned long long GetLayoutBytes(const std::unordered_map<unsigned int, amg::TextLayout>& list)
+    {
+        auto bytes = 0ULL;
+
+        for (auto&& layout : list) {
+            bytes += sizeof(layout)
+                + layout.second.GetGlyphs().capacity() * sizeof(amg::TextLayout::Glyph)
+                + layout.second.GetLines().capacity() * sizeof(amg::TextLayout::Line);
+        }
+
+        return bytes;
+    }
+
+    void WriteStats(std::ofstream& file, const char* name, const amg::MemoryFootprint::Stats& stats)
+    {
+        file << name << "\t" << stats.count << "\t" << stats.peak_count << "\t"
+            << stats.bytes << "\t" << stats.peak_bytes << "\n";
+    }
+}
+
+namespace amg
+{
+    MemoryFootprint::MemoryFootprint()
+    {
+        stats_list.resize(PART_NUM);
+        peak_total_bytes = 0;
+    }
+
+    //!
+    //! @fn void MemoryFootprint::Update(const ScriptEngine& engine)
+    //! @brief スクリプトエンジンが保持しているサイズを集計する
+    //! @param[in] engine スクリプトエンジン
+    //! @details 最大値は Clear() するまで保持します。
+    //!
+    void MemoryFootprint::Update(const ScriptEngine& engine)
+    {
+        const auto scripts_bytes = (engine.scripts_data != nullptr) ? engine.scripts_data->GetMemoryBytes() : 0;
+        const auto scripts_num = (engine.scripts_data != nullptr) ? engine.scripts_data->GetScriptNum() : 0;
+
+        SetBytes(Part::SCRIPTS, scripts_bytes, scripts_num);
+        SetBytes(Part::LABEL, GetListBytes(engine.label_list), static_cast<unsigned int>(engine.label_list.size()));
+        SetBytes(Part::IMAGE, GetListBytes(engine.image_list), static_cast<unsigned int>(engine.image_list.size()));
+        SetBytes(Part::MESSAGE, GetListBytes(engine.message_list), static_cast<unsigned int>(engine.message_list.size()));
+        SetBytes(Part::CHOICE, GetListBytes(engine.choice_list), static_cast<unsigned int>(engine.choice_list.size()));
+        SetBytes(Part::DRAW, GetListBytes(engine.draw_list), static_cast<unsigned int>(engine.draw_list.size()));
+
+        // image_list は PreParsing() で作った後は変わらないので、ラベルのコピーは数が変わった時のみ行う
+        const auto is_changed = (textures.size() != engine.image_list.size());
+
+        textures.resize(engine.image_list.size());
+
+        auto texture_bytes = 0ULL;
+
+        for (auto i = 0U; i < textures.size(); ++i) {
+            const auto& image = engine.image_list[i];
+            auto&& texture = textures[i];
+
+            if (is_changed) {
+                texture.line = image->GetLineNumber();
+                texture.label = image->GetLabel();
+            }
+
+            texture.handle = image->GetHandle();
+
+            if (DxWrapper::GetGraphSize(texture.handle, &texture.width, &texture.height) != 0) {
+                texture.width = 0;
+                texture.height = 0;
+            }
+
+            texture.bytes = static_cast<unsigned long long>(texture.width) * static_cast<unsigned long long>(texture.height) * TEXTURE_PIXEL_BYTES;
+            texture_bytes += texture.bytes;
+        }
+
+        SetBytes(Part::TEXTURE, texture_bytes, static_cast<unsigned int>(textures.size()));
+
+        const auto& text_cache_stats = engine.GetTextCacheStats();
+
+        SetBytes(Part::TEXT_CACHE, text_cache_stats.bytes, text_cache_stats.entries);
+        SetBytes(Part::LAYOUT, GetLayoutBytes(engine.layout_list), static_cast<unsigned int>(engine.layout_list.size()));
+
+        Stats total;
+
+        GetTotalStats(total);
+
+        peak_total_bytes = std::max(peak_total_bytes, total.bytes);
+    }
+
+    //!
+    //! @fn void MemoryFootprint::Clear()
+    //! @brief 集計と最大値を全て消す
+    //!
+    void MemoryFootprint::Clear()
+    {
+        for (auto&& stats : stats_list) {
+            stats = Stats();
+        }
+
+        textures.clear();
+        peak_total_bytes = 0;
+    }
+
+    //!
+    //! @fn void MemoryFootprint::GetStats(Part part, Stats& stats) const
+    //! @brief 構造毎のサイズを取得する
+    //! @param[in] part 構造
+    //! @param[out] stats サイズと最大値
+    //!
+    void MemoryFootprint::GetStats(Part part, Stats& stats) const
+    {
+        stats = Stats();
+
+        if (part >= Part::NUM) {
+            return;
+        }
+
+        stats = stats_list[static_cast<unsigned int>(part)];
+    }
+
+    //!
+    //! @fn void MemoryFootprint::GetTotalStats(Stats& stats) const
+    //! @brief 全ての構造の合計を取得する
+    //! @param[out] stats サイズと最大値
+    //! @details peak_bytes は合計の最大値です。(peak_count は構造毎の最大値の合計です)
+    //!
+    void MemoryFootprint::GetTotalStats(Stats& stats) const
+    {
+        stats = Stats();
+
+        for (auto&& part : stats_list) {
+            stats.bytes += part.bytes;
+            stats.count += part.count;
+            stats.peak_count += part.peak_count;
+        }
+
+        stats.peak_bytes = std::max(peak_total_bytes, stats.bytes);
+    }
+
+    //!
+    //! @fn bool MemoryFootprint::SaveReport(const std::string& path) const
+    //! @brief 集計をタブ区切りのテキストファイルに保存する
+    //! @param[in] path 保存するファイル名
+    //! @return 処理の成否
+    //! @details 構造毎のサイズと画像毎のテクスチャーのサイズを出力します。
+    //!
+    bool MemoryFootprint::SaveReport(const std::string& path) const
+    {
+        std::ofstream file(path);
+
+        if (!file) {
+            return false;
+        }
+
+        Stats stats;
+
+        file << "[footprint]\n";
+        file << "part\tcount\tpeak_count\tbytes\tpeak_bytes\n";
+
+        for (auto i = 0U; i < PART_NUM; ++i) {
+            const auto part = static_cast<Part>(i);
+
+            GetStats(part, stats);
+            WriteStats(file, GetName(part), stats);
+        }
+
+        GetTotalStats(stats);
+        WriteStats(file, "Total", stats);
+
+        file << "\n[texture]\n";
+        file << "line\tlabel\thandle\twidth\theight\tbytes\n";
+
+        for (auto&& texture : textures) {
+            file << texture.line << "\t" << texture.label << "\t" << texture.handle << "\t"
+                << texture.width << "\t" << texture.height << "\t" << texture.bytes << "\n";
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    //!
+    //! @fn const char* MemoryFootprint::GetName(Part part)
+    //! @brief 構造の名前を取得する
+    //! @param[in] part 構造
+    //! @return 名前
+    //!
+    const char* MemoryFootprint::GetName(Part part)
+    {
+        switch (part) {
+        case Part::SCRIPTS: return "Scripts";
+        case Part::LABEL: return "Label";
+        case Part::IMAGE: return "Image";
+        case Part::MESSAGE: return "Message";
+        case Part::CHOICE: return "Choice";
+        case Part::DRAW: return "Draw";
+        case Part::TEXTURE: return "Texture";
+        case Part::TEXT_CACHE: return "TextCache";
+        case Part::LAYOUT: return "Layout";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+
+    void MemoryFootprint::SetBytes(Part part, unsigned long long bytes, unsigned int count)
+    {
+        auto&& stats = stats_list[static_cast<unsigned int>(part)];
+
+        stats.bytes = bytes;
+        stats.count = count;
+        stats.peak_bytes = std::max(stats.peak_bytes, bytes);
+        stats.peak_count = std::max(stats.peak_count, count);
+    }
+}
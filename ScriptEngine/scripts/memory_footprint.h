@@ -0,0 +1,96 @@
+﻿//!
+//! @file memory_footprint.h
+//!
+//! @brief スクリプトエンジンの構造毎のメモリ使用量を集計するクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class ScriptEngine;
+
+    class MemoryFootprint
+    {
+    public:
+        enum class Part {
+            SCRIPTS,    // ScriptsData が読み込んだスクリプトの文字列
+            LABEL,      // label_list
+            IMAGE,      // image_list
+            MESSAGE,    // message_list
+            CHOICE,     // choice_list
+            DRAW,       // draw_list
+            TEXTURE,    // image_list の画像のテクスチャー
+            TEXT_CACHE, // TextCache の描画済みの文字列の画像
+            LAYOUT,     // layout_list
+            NUM
+        };
+
+        struct Stats
+        {
+            unsigned long long bytes;       // 現在のサイズ
+            unsigned long long peak_bytes;  // bytes の最大値
+            unsigned int count;             // 現在の要素数
+            unsigned int peak_count;        // count の最大値
+
+            Stats()
+            {
+                bytes = 0;
+                peak_bytes = 0;
+                count = 0;
+                peak_count = 0;
+            }
+        };
+
+        //!
+        //! @brief CommandImage 毎のテクスチャー
+        //!
+        struct Texture
+        {
+            unsigned int line;
+            std::string label;
+            int handle;
+            int width;
+            int height;
+            unsigned long long bytes;   // 1 ピクセル 4 バイト(サイズが分からなければ 0)
+
+            Texture()
+            {
+                line = 0;
+                handle = -1;
+                width = 0;
+                height = 0;
+                bytes = 0;
+            }
+        };
+
+        MemoryFootprint();
+        MemoryFootprint(const MemoryFootprint&) = default;
+        MemoryFootprint(MemoryFootprint&&) noexcept = default;
+
+        virtual ~MemoryFootprint() = default;
+
+        MemoryFootprint& operator=(const MemoryFootprint& right) = default;
+        MemoryFootprint& operator=(MemoryFootprint&& right) noexcept = default;
+
+        void Update(const ScriptEngine& engine);
+        void Clear();
+
+        void GetStats(Part part, Stats& stats) const;
+        void GetTotalStats(Stats& stats) const;
+        bool SaveReport(const std::string& path) const;
+
+        inline const std::vector<Texture>& GetTextures() const { return textures; }
+
+        static const char* GetName(Part part);
+
+    private:
+        void SetBytes(Part part, unsigned long long bytes, unsigned int count);
+
+        std::vector<Stats> stats_list;
+        std::vector<Texture> textures;
+        unsigned long long peak_total_bytes;
+    };
+}
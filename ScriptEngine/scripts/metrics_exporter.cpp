@@ -0,0 +1,349 @@
+﻿//!
+//! @file metrics_exporter.cpp
+//!
+//! @brief 実行中の計測値を Prometheus のテキスト形式でファイルに出力するクラス実装
+//!
+//! @details
+//! ヘッドレスの常駐サーバーや長時間の耐久テストで、処理量やメモリの推移を追う為に使用します。
+//! 出力したファイルは node_exporter の textfile collector などで収集して下さい。
+//!
+//! Update() はメインループから毎フレーム呼び出し、atomic の値を更新するだけです。
+//! ファイルへの出力はバックグラウンドのスレッドが interval 毎に行うので、フレームは止まりません。
+//! 収集側が書き込み途中のファイルを読まないように、一時ファイルに書いてから置き換えます。
+//!
+//! 出力する値
+//! script_engine_frames_total                  処理したフレーム数
+//! script_engine_instructions_total            Parsing() で処理した行数
+//! script_engine_state_frames_total{state}     ScriptState 毎のフレーム数
+//! script_engine_state_seconds_total{state}    ScriptState 毎の経過時間
+//! script_engine_frame_seconds                 フレームの間隔のヒストグラム
+//! script_engine_loads_total                   ScriptEngine::Initialize() の回数
+//! script_engine_load_seconds_total            ScriptEngine::Initialize() の処理時間の合計
+//! script_engine_texture_bytes                 読み込んだ画像のサイズ(概算)
+//! script_engine_alloc_total{subsystem}        処理単位毎のメモリ確保回数(AllocTracker)
+//! script_engine_alloc_bytes_total{subsystem}  処理単位毎のメモリ確保サイズ
+//! script_engine_heap_live_bytes               解放されていないサイズ
+//! script_engine_heap_peak_bytes               解放されていないサイズの最大値
+//!
+#include "metrics_exporter.h"
+#include "script_engine.h"
+#include "alloc_tracker.h"
+#include <fstream>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace {
+    constexpr auto STATE_NUM = static_cast<unsigned int>(amg::ScriptEngine::ScriptState::END) + 1;
+
+    // フレームの間隔のヒストグラムの上限(秒、最後は +Inf)
+    constexpr double FRAME_BUCKETS[] = { 0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25 };
+    constexpr auto FRAME_BUCKET_NUM = sizeof(FRAME_BUCKETS) / sizeof(FRAME_BUCKETS[0]) + 1;
+
+    constexpr auto DEFAULT_INTERVAL_MS = 10000U;
+
+    const char* GetStateName(const unsigned int state)
+    {
+        switch (static_cast<amg::ScriptEngine::ScriptState>(state)) {
+        case amg::ScriptEngine::ScriptState::PARSING: return "PARSING";
+        case amg::ScriptEngine::ScriptState::TIME_WAIT: return "TIME_WAIT";
+        case amg::ScriptEngine::ScriptState::CLICK_WAIT: return "CLICK_WAIT";
+        case amg::ScriptEngine::ScriptState::CHOICE_WAIT: return "CHOICE_WAIT";
+        case amg::ScriptEngine::ScriptState::END: return "END";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+
+    double ToSeconds(const long long ns)
+    {
+        return static_cast<double>(ns) / 1000000000.0;
+    }
+
+    void WriteHeader(std::ofstream& file, const char* name, const char* type, const char* help)
+    {
+        file << "# HELP " << name << " " << help << "\n";
+        file << "# TYPE " << name << " " << type << "\n";
+    }
+}
+
+namespace amg
+{
+    MetricsExporter::MetricsExporter()
+    {
+        interval = std::chrono::milliseconds(DEFAULT_INTERVAL_MS);
+        is_stop = false;
+        frames = 0;
+        instructions = 0;
+
+        state_frames.reset(new std::atomic<unsigned long long>[STATE_NUM]);
+        state_ns.reset(new std::atomic<long long>[STATE_NUM]);
+
+        for (auto i = 0U; i < STATE_NUM; ++i) {
+            state_frames[i] = 0;
+            state_ns[i] = 0;
+        }
+
+        frame_buckets.reset(new std::atomic<unsigned long long>[FRAME_BUCKET_NUM]);
+
+        for (auto i = 0U; i < FRAME_BUCKET_NUM; ++i) {
+            frame_buckets[i] = 0;
+        }
+
+        frame_ns_sum = 0;
+        loads = 0;
+        load_ns_sum = 0;
+        texture_bytes = 0;
+        last_executed_lines = 0;
+        texture_count = 0;
+        is_first_update = true;
+    }
+
+    MetricsExporter::~MetricsExporter()
+    {
+        Stop();
+    }
+
+    //!
+    //! @fn bool MetricsExporter::Start(const std::string& path, unsigned int interval_ms)
+    //! @brief 出力スレッドを開始する
+    //! @param[in] path 出力ファイル名(上書き)
+    //! @param[in] interval_ms 出力間隔(ミリ秒、0 なら既定の 10 秒)
+    //! @return 処理の成否
+    //!
+    bool MetricsExporter::Start(const std::string& path, unsigned int interval_ms)
+    {
+        Stop();
+
+        // 開始時点で書き込めるか確認しておく
+        if (!Save(path)) {
+            return false;
+        }
+
+        this->path = path;
+        interval = std::chrono::milliseconds((interval_ms > 0) ? interval_ms : DEFAULT_INTERVAL_MS);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            is_stop = false;
+        }
+
+        writer = std::thread(&MetricsExporter::WriterMain, this);
+
+        return true;
+    }
+
+    //!
+    //! @fn void MetricsExporter::Stop()
+    //! @brief 出力スレッドを止めて最後の値を出力する
+    //!
+    void MetricsExporter::Stop()
+    {
+        if (!writer.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            is_stop = true;
+        }
+
+        condition.notify_one();
+        writer.join();
+
+        Save(path);
+    }
+
+    //!
+    //! @fn void MetricsExporter::AddLoad(double seconds)
+    //! @brief スクリプトの読み込み時間を加える
+    //! @param[in] seconds ScriptEngine::Initialize() の処理時間(秒)
+    //!
+    void MetricsExporter::AddLoad(double seconds)
+    {
+        loads.fetch_add(1, std::memory_order_relaxed);
+        load_ns_sum.fetch_add(static_cast<long long>(seconds * 1000000000.0), std::memory_order_relaxed);
+    }
+
+    //!
+    //! @fn void MetricsExporter::Update(const ScriptEngine& engine)
+    //! @brief 1 フレーム分の値を加える
+    //! @param[in] engine スクリプトエンジン(Update() の後)
+    //! @details メインループから毎フレーム呼び出して下さい。
+    //! フレームの間隔は前回の呼び出しからの経過時間です。
+    //!
+    void MetricsExporter::Update(const ScriptEngine& engine)
+    {
+        const auto now = Clock::now();
+        const auto state = static_cast<unsigned int>(engine.GetState());
+        const auto executed_lines = engine.GetExecutedLines();
+
+        // ScriptEngine を作り直すと 0 に戻る
+        if (executed_lines < last_executed_lines) {
+            last_executed_lines = 0;
+        }
+
+        frames.fetch_add(1, std::memory_order_relaxed);
+        instructions.fetch_add(executed_lines - last_executed_lines, std::memory_order_relaxed);
+        last_executed_lines = executed_lines;
+
+        if (state < STATE_NUM) {
+            state_frames[state].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!is_first_update) {
+            const auto frame_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_update).count();
+            const auto seconds = ToSeconds(frame_ns);
+            auto bucket = 0U;
+
+            while (bucket < FRAME_BUCKET_NUM - 1 && seconds > FRAME_BUCKETS[bucket]) {
+                ++bucket;
+            }
+
+            frame_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            frame_ns_sum.fetch_add(frame_ns, std::memory_order_relaxed);
+
+            if (state < STATE_NUM) {
+                state_ns[state].fetch_add(frame_ns, std::memory_order_relaxed);
+            }
+        }
+
+        // 画像のサイズは読み込んだ画像の数が変わった時のみ計算し直す
+        const auto image_count = engine.GetImageCount();
+
+        if (is_first_update || image_count != texture_count) {
+            texture_bytes.store(engine.GetTextureBytes(), std::memory_order_relaxed);
+            texture_count = image_count;
+        }
+
+        last_update = now;
+        is_first_update = false;
+    }
+
+    //!
+    //! @fn bool MetricsExporter::Save(const std::string& path) const
+    //! @brief 現在の値を Prometheus のテキスト形式で保存する
+    //! @param[in] path 出力ファイル名
+    //! @return 処理の成否
+    //! @details 一時ファイル(path + ".tmp")に書いてから置き換えます。
+    //!
+    bool MetricsExporter::Save(const std::string& path) const
+    {
+        const auto temp_path = path + ".tmp";
+
+        {
+            std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
+
+            if (!file) {
+                return false;
+            }
+
+            WriteHeader(file, "script_engine_frames_total", "counter", "Frames processed.");
+            file << "script_engine_frames_total " << frames.load(std::memory_order_relaxed) << "\n";
+
+            WriteHeader(file, "script_engine_instructions_total", "counter", "Script lines executed by Parsing().");
+            file << "script_engine_instructions_total " << instructions.load(std::memory_order_relaxed) << "\n";
+
+            WriteHeader(file, "script_engine_state_frames_total", "counter", "Frames spent in each ScriptState.");
+
+            for (auto i = 0U; i < STATE_NUM; ++i) {
+                file << "script_engine_state_frames_total{state=\"" << GetStateName(i) << "\"} "
+                    << state_frames[i].load(std::memory_order_relaxed) << "\n";
+            }
+
+            WriteHeader(file, "script_engine_state_seconds_total", "counter", "Seconds spent in each ScriptState.");
+
+            for (auto i = 0U; i < STATE_NUM; ++i) {
+                file << "script_engine_state_seconds_total{state=\"" << GetStateName(i) << "\"} "
+                    << ToSeconds(state_ns[i].load(std::memory_order_relaxed)) << "\n";
+            }
+
+            WriteHeader(file, "script_engine_frame_seconds", "histogram", "Interval between frames.");
+
+            auto cumulative = 0ULL;
+
+            for (auto i = 0U; i < FRAME_BUCKET_NUM; ++i) {
+                cumulative += frame_buckets[i].load(std::memory_order_relaxed);
+
+                file << "script_engine_frame_seconds_bucket{le=\"";
+
+                if (i < FRAME_BUCKET_NUM - 1) {
+                    file << FRAME_BUCKETS[i];
+                }
+                else {
+                    file << "+Inf";
+                }
+
+                file << "\"} " << cumulative << "\n";
+            }
+
+            file << "script_engine_frame_seconds_sum " << ToSeconds(frame_ns_sum.load(std::memory_order_relaxed)) << "\n";
+            file << "script_engine_frame_seconds_count " << cumulative << "\n";
+
+            WriteHeader(file, "script_engine_loads_total", "counter", "Calls of ScriptEngine::Initialize().");
+            file << "script_engine_loads_total " << loads.load(std::memory_order_relaxed) << "\n";
+
+            WriteHeader(file, "script_engine_load_seconds_total", "counter", "Seconds spent in ScriptEngine::Initialize().");
+            file << "script_engine_load_seconds_total " << ToSeconds(load_ns_sum.load(std::memory_order_relaxed)) << "\n";
+
+            WriteHeader(file, "script_engine_texture_bytes", "gauge", "Approximate bytes of loaded images.");
+            file << "script_engine_texture_bytes " << texture_bytes.load(std::memory_order_relaxed) << "\n";
+
+            AllocTracker::Stats stats;
+
+            WriteHeader(file, "script_engine_alloc_total", "counter", "Heap allocations per subsystem.");
+
+            for (auto i = 0U; i < static_cast<unsigned int>(AllocTracker::Subsystem::NUM); ++i) {
+                const auto subsystem = static_cast<AllocTracker::Subsystem>(i);
+
+                AllocTracker::GetStats(subsystem, stats);
+                file << "script_engine_alloc_total{subsystem=\"" << AllocTracker::GetName(subsystem) << "\"} " << stats.count << "\n";
+            }
+
+            WriteHeader(file, "script_engine_alloc_bytes_total", "counter", "Heap bytes allocated per subsystem.");
+
+            for (auto i = 0U; i < static_cast<unsigned int>(AllocTracker::Subsystem::NUM); ++i) {
+                const auto subsystem = static_cast<AllocTracker::Subsystem>(i);
+
+                AllocTracker::GetStats(subsystem, stats);
+                file << "script_engine_alloc_bytes_total{subsystem=\"" << AllocTracker::GetName(subsystem) << "\"} " << stats.bytes << "\n";
+            }
+
+            AllocTracker::GetTotalStats(stats);
+
+            WriteHeader(file, "script_engine_heap_live_bytes", "gauge", "Heap bytes not yet freed.");
+            file << "script_engine_heap_live_bytes " << stats.live_bytes << "\n";
+
+            WriteHeader(file, "script_engine_heap_peak_bytes", "gauge", "Peak of heap bytes not yet freed.");
+            file << "script_engine_heap_peak_bytes " << stats.peak_live_bytes << "\n";
+
+            if (!file) {
+                return false;
+            }
+        }
+
+        // 置き換え先が無くなる瞬間を作らない様に 1 回の呼び出しで置き換える
+        // (Windows の rename は置き換え先があると失敗するので MoveFileEx を使用する)
+#if defined(_WIN32)
+        return MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+        return std::rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+    }
+
+    void MetricsExporter::WriterMain()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!condition.wait_for(lock, interval, [this] { return is_stop; })) {
+            lock.unlock();
+            Save(path);
+            lock.lock();
+        }
+    }
+}
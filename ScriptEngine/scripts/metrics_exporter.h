@@ -0,0 +1,71 @@
+﻿//!
+//! @file metrics_exporter.h
+//!
+//! @brief 実行中の計測値を Prometheus のテキスト形式でファイルに出力するクラス定義
+//!
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <string>
+
+namespace amg
+{
+    class ScriptEngine;
+
+    class MetricsExporter
+    {
+    public:
+        MetricsExporter();
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter(MetricsExporter&&) = delete;
+
+        virtual ~MetricsExporter();
+
+        MetricsExporter& operator=(const MetricsExporter& right) = delete;
+        MetricsExporter& operator=(MetricsExporter&& right) = delete;
+
+        bool Start(const std::string& path, unsigned int interval_ms);
+        void Stop();
+
+        void AddLoad(double seconds);
+        void Update(const ScriptEngine& engine);
+
+        bool Save(const std::string& path) const;
+
+        inline bool IsRunning() const { return writer.joinable(); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void WriterMain();
+
+        std::string path;
+        std::chrono::milliseconds interval;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool is_stop;
+
+        // メインループのスレッドで更新し、出力スレッドから読む
+        std::atomic<unsigned long long> frames;
+        std::atomic<unsigned long long> instructions;
+        std::unique_ptr<std::atomic<unsigned long long>[]> state_frames;
+        std::unique_ptr<std::atomic<long long>[]> state_ns;
+        std::unique_ptr<std::atomic<unsigned long long>[]> frame_buckets;
+        std::atomic<long long> frame_ns_sum;
+        std::atomic<unsigned long long> loads;
+        std::atomic<long long> load_ns_sum;
+        std::atomic<unsigned long long> texture_bytes;
+
+        // メインループのスレッドのみで使用する
+        Clock::time_point last_update;
+        unsigned long long last_executed_lines;
+        unsigned int texture_count;
+        bool is_first_update;
+    };
+}
@@ -0,0 +1,292 @@
+﻿//!
+//! @file perf_hud.cpp
+//!
+//! @brief 処理時間などをゲーム画面に重ねて表示するクラス実装
+//!
+//! @details
+//! 直近のフレームの処理時間のグラフと、処理時間の統計、描画関数の呼び出し回数、
+//! フレーム毎のメモリ確保、処理中のスクリプトの行とラベル、画像のサイズを表示します。
+//!
+//! 表示中の計測値を乱さないように、毎フレームの処理ではメモリ確保を行いません。
+//! 文字列は REFRESH_FRAMES フレーム毎に固定長のバッファーへ作り直し、
+//! 描画はフォントハンドルを事前に作成して DrawStringToHandle() で行います。
+//!
+#include "perf_hud.h"
+#include "dx_wrapper.h"
+#include "script_engine.h"
+#include "frame_profiler.h"
+#include "alloc_tracker.h"
+#include <cstdio>
+
+namespace {
+    constexpr auto REFRESH_FRAMES = 15U;    // 文字列を作り直す間隔(フレーム数)
+
+    constexpr auto HUD_LEFT = 8;
+    constexpr auto HUD_TOP = 8;
+    constexpr auto HUD_WIDTH = 480;
+    constexpr auto HUD_ALPHA = 160;
+
+    constexpr auto FONT_SIZE = 14;
+    constexpr auto FONT_THICK = 3;
+    constexpr auto TEXT_HEIGHT = 16;
+
+    constexpr auto GRAPH_HEIGHT = 64;
+    constexpr auto GRAPH_BAR_WIDTH = 4;
+    constexpr auto GRAPH_MAX_MS = 33.3f;    // グラフの上端
+    constexpr auto TARGET_MS = 16.7f;       // 60fps の 1 フレーム
+    constexpr auto MARGIN = 8;
+
+    constexpr auto MEGA_BYTES = 1024.0 * 1024.0;
+
+    const char* GetStateName(const amg::ScriptEngine::ScriptState state)
+    {
+        switch (state) {
+        case amg::ScriptEngine::ScriptState::PARSING: return "PARSING";
+        case amg::ScriptEngine::ScriptState::TIME_WAIT: return "TIME_WAIT";
+        case amg::ScriptEngine::ScriptState::CLICK_WAIT: return "CLICK_WAIT";
+        case amg::ScriptEngine::ScriptState::CHOICE_WAIT: return "CHOICE_WAIT";
+        case amg::ScriptEngine::ScriptState::END: return "END";
+        default: break;
+        }
+
+        return "Unknown";
+    }
+
+    double ToMilliseconds(const double us)
+    {
+        return us / 1000.0;
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn PerfHud::PerfHud()
+    //! @brief コンストラクタ
+    //!
+    PerfHud::PerfHud()
+    {
+        frame_ms.fill(0.0f);
+
+        for (auto&& text : texts) {
+            text.fill('\0');
+        }
+
+        graph_index = 0;
+        refresh_count = 0;
+        draw_calls_last = 0;
+        draw_calls_max = 0;
+        alloc_count_sum = 0;
+        alloc_count_max = 0;
+        alloc_bytes_sum = 0;
+        alloc_frames = 0;
+        font_handle = -1;
+        background_color = 0;
+        text_color = 0;
+        good_color = 0;
+        warning_color = 0;
+        bad_color = 0;
+        line_color = 0;
+        is_visible = false;
+    }
+
+    //!
+    //! @fn PerfHud::~PerfHud()
+    //! @brief デストラクタ
+    //!
+    PerfHud::~PerfHud()
+    {
+        Destroy();
+    }
+
+    //!
+    //! @fn bool PerfHud::Initialize()
+    //! @brief 表示に使用するフォントと色を作成する
+    //! @return 処理の成否
+    //! @details DX ライブラリの初期化後に呼び出して下さい。
+    //!
+    bool PerfHud::Initialize()
+    {
+        Destroy();
+
+        font_handle = DxWrapper::CreateFontToHandle(nullptr, FONT_SIZE, FONT_THICK);
+
+        if (font_handle == -1) {
+            return false;
+        }
+
+        background_color = DxWrapper::GetColor(0, 0, 0);
+        text_color = DxWrapper::GetColor(255, 255, 255);
+        good_color = DxWrapper::GetColor(64, 224, 64);
+        warning_color = DxWrapper::GetColor(240, 200, 32);
+        bad_color = DxWrapper::GetColor(240, 64, 64);
+        line_color = DxWrapper::GetColor(128, 128, 128);
+
+        return true;
+    }
+
+    //!
+    //! @fn void PerfHud::Destroy()
+    //! @brief フォントを破棄する
+    //!
+    void PerfHud::Destroy()
+    {
+        if (font_handle != -1) {
+            DxWrapper::DeleteFontToHandle(font_handle);
+            font_handle = -1;
+        }
+    }
+
+    //!
+    //! @fn void PerfHud::Update(const ScriptEngine& engine, const FrameProfiler& profiler, unsigned int draw_calls)
+    //! @brief 表示する値を更新する
+    //! @param[in] engine スクリプトエンジン
+    //! @param[in] profiler フレームの処理時間(EndFrame() の後)
+    //! @param[in] draw_calls このフレームの描画関数の呼び出し回数
+    //! @details 表示中のみ、AllocTracker::EndFrame() の後に毎フレーム呼び出して下さい。
+    //!
+    void PerfHud::Update(const ScriptEngine& engine, const FrameProfiler& profiler, unsigned int draw_calls)
+    {
+        if (!is_visible) {
+            return;
+        }
+
+        frame_ms[graph_index] = static_cast<float>(ToMilliseconds(profiler.GetLastFrameUs(FrameProfiler::Phase::FRAME)));
+        graph_index = (graph_index + 1) % GRAPH_NUM;
+
+        draw_calls_last = draw_calls;
+
+        if (draw_calls > draw_calls_max) {
+            draw_calls_max = draw_calls;
+        }
+
+        auto alloc_count = 0ULL;
+
+        for (auto i = 0U; i < static_cast<unsigned int>(AllocTracker::Subsystem::NUM); ++i) {
+            AllocTracker::Stats stats;
+
+            AllocTracker::GetFrameStats(static_cast<AllocTracker::Subsystem>(i), stats);
+
+            alloc_count += stats.count;
+            alloc_bytes_sum += stats.bytes;
+        }
+
+        alloc_count_sum += alloc_count;
+        ++alloc_frames;
+
+        if (alloc_count > alloc_count_max) {
+            alloc_count_max = alloc_count;
+        }
+
+        if (++refresh_count >= REFRESH_FRAMES) {
+            UpdateText(engine, profiler);
+
+            refresh_count = 0;
+            draw_calls_max = 0;
+            alloc_count_sum = 0;
+            alloc_count_max = 0;
+            alloc_bytes_sum = 0;
+            alloc_frames = 0;
+        }
+    }
+
+    //!
+    //! @fn void PerfHud::UpdateText(const ScriptEngine& engine, const FrameProfiler& profiler)
+    //! @brief 表示する文字列を作り直す
+    //! @param[in] engine スクリプトエンジン
+    //! @param[in] profiler フレームの処理時間
+    //!
+    void PerfHud::UpdateText(const ScriptEngine& engine, const FrameProfiler& profiler)
+    {
+        FrameProfiler::Stats frame;
+        FrameProfiler::Stats update;
+        FrameProfiler::Stats render;
+        FrameProfiler::Stats flip;
+
+        profiler.GetStats(FrameProfiler::Phase::FRAME, frame);
+        profiler.GetStats(FrameProfiler::Phase::UPDATE, update);
+        profiler.GetStats(FrameProfiler::Phase::RENDER, render);
+        profiler.GetStats(FrameProfiler::Phase::FLIP, flip);
+
+        const auto work_us = update.p50_us + render.p50_us;
+        const auto update_percent = (work_us > 0.0) ? (update.p50_us * 100.0 / work_us) : 0.0;
+
+        AllocTracker::Stats heap;
+
+        AllocTracker::GetTotalStats(heap);
+
+        const auto frames = (alloc_frames > 0) ? alloc_frames : 1U;
+
+        std::snprintf(texts[0].data(), TEXT_LENGTH, "frame %6.2f ms  p50 %6.2f  p99 %6.2f  max %6.2f",
+            ToMilliseconds(profiler.GetLastFrameUs(FrameProfiler::Phase::FRAME)),
+            ToMilliseconds(frame.p50_us), ToMilliseconds(frame.p99_us), ToMilliseconds(frame.max_us));
+        std::snprintf(texts[1].data(), TEXT_LENGTH, "update %6.2f ms  render %6.2f ms  flip %6.2f ms  (%.0f%% : %.0f%%)",
+            ToMilliseconds(update.p50_us), ToMilliseconds(render.p50_us), ToMilliseconds(flip.p50_us),
+            update_percent, (work_us > 0.0) ? (100.0 - update_percent) : 0.0);
+        std::snprintf(texts[2].data(), TEXT_LENGTH, "draw calls %u  (max %u)  state changes %u", draw_calls_last, draw_calls_max,
+            engine.GetRenderStats().state_changes);
+        std::snprintf(texts[3].data(), TEXT_LENGTH, "alloc/frame %.1f  (max %llu)  %.0f bytes/frame",
+            static_cast<double>(alloc_count_sum) / frames, alloc_count_max,
+            static_cast<double>(alloc_bytes_sum) / frames);
+        std::snprintf(texts[4].data(), TEXT_LENGTH, "heap %.2f MB  (peak %.2f MB)  texture %.2f MB",
+            heap.live_bytes / MEGA_BYTES, heap.peak_live_bytes / MEGA_BYTES, engine.GetTextureBytes() / MEGA_BYTES);
+        std::snprintf(texts[5].data(), TEXT_LENGTH, "line %u / %u  label %s",
+            engine.GetNowLine(), engine.GetMaxLine(), engine.GetNowLabel().c_str());
+        std::snprintf(texts[6].data(), TEXT_LENGTH, "state %s", GetStateName(engine.GetState()));
+    }
+
+    //!
+    //! @fn void PerfHud::Render() const
+    //! @brief ゲーム画面に重ねて描画する
+    //! @details ScriptEngine::Render() の後、ScreenFlip() の前に呼び出して下さい。
+    //!
+    void PerfHud::Render() const
+    {
+        if (!is_visible || font_handle == -1) {
+            return;
+        }
+
+        const auto graph_top = HUD_TOP + MARGIN;
+        const auto graph_bottom = graph_top + GRAPH_HEIGHT;
+        const auto text_top = graph_bottom + MARGIN;
+        const auto hud_bottom = text_top + TEXT_HEIGHT * static_cast<int>(TEXT_NUM) + MARGIN;
+
+        DxWrapper::SetDrawBlendMode(DxWrapper::DX_BLENDMODE_ALPHA, HUD_ALPHA);
+        DxWrapper::DrawBox(HUD_LEFT, HUD_TOP, HUD_LEFT + HUD_WIDTH, hud_bottom, background_color, DxWrapper::TRUE);
+        DxWrapper::SetDrawBlendMode(DxWrapper::DX_BLENDMODE_NOBLEND, 0);
+
+        // 古いフレームから順に左から並べる
+        for (auto i = 0U; i < GRAPH_NUM; ++i) {
+            const auto ms = frame_ms[(graph_index + i) % GRAPH_NUM];
+
+            if (ms <= 0.0f) {
+                continue;
+            }
+
+            const auto ratio = (ms < GRAPH_MAX_MS) ? (ms / GRAPH_MAX_MS) : 1.0f;
+            const auto height = static_cast<int>(ratio * GRAPH_HEIGHT);
+            const auto left = HUD_LEFT + MARGIN + static_cast<int>(i) * GRAPH_BAR_WIDTH;
+            auto color = good_color;
+
+            if (ms > TARGET_MS * 1.5f) {
+                color = bad_color;
+            }
+            else if (ms > TARGET_MS) {
+                color = warning_color;
+            }
+
+            DxWrapper::DrawBox(left, graph_bottom - height, left + GRAPH_BAR_WIDTH - 1, graph_bottom, color, DxWrapper::TRUE);
+        }
+
+        // 60fps の基準線
+        const auto target_y = graph_bottom - static_cast<int>(TARGET_MS / GRAPH_MAX_MS * GRAPH_HEIGHT);
+
+        DxWrapper::DrawBox(HUD_LEFT + MARGIN, target_y, HUD_LEFT + MARGIN + static_cast<int>(GRAPH_NUM) * GRAPH_BAR_WIDTH, target_y + 1,
+            line_color, DxWrapper::TRUE);
+
+        for (auto i = 0U; i < TEXT_NUM; ++i) {
+            DxWrapper::DrawStringToHandle(HUD_LEFT + MARGIN, text_top + TEXT_HEIGHT * static_cast<int>(i),
+                texts[i].data(), text_color, font_handle);
+        }
+    }
+}
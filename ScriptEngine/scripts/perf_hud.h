@@ -0,0 +1,67 @@
+﻿//!
+//! @file perf_hud.h
+//!
+//! @brief 処理時間などをゲーム画面に重ねて表示するクラス定義
+//!
+#pragma once
+
+#include <array>
+
+namespace amg
+{
+    class ScriptEngine;
+    class FrameProfiler;
+
+    class PerfHud
+    {
+    public:
+        PerfHud();
+        PerfHud(const PerfHud&) = delete;
+        PerfHud(PerfHud&&) = delete;
+
+        virtual ~PerfHud();
+
+        PerfHud& operator=(const PerfHud& right) = delete;
+        PerfHud& operator=(PerfHud&& right) = delete;
+
+        bool Initialize();
+        void Destroy();
+
+        void Update(const ScriptEngine& engine, const FrameProfiler& profiler, unsigned int draw_calls);
+        void Render() const;
+
+        inline void SetVisible(bool visible) { is_visible = visible; }
+        inline bool IsVisible() const { return is_visible; }
+        inline void Toggle() { is_visible = !is_visible; }
+
+    private:
+        static constexpr unsigned int GRAPH_NUM = 120;  // グラフに表示するフレーム数
+        static constexpr unsigned int TEXT_NUM = 7;     // 文字列の行数
+        static constexpr unsigned int TEXT_LENGTH = 128;
+
+        void UpdateText(const ScriptEngine& engine, const FrameProfiler& profiler);
+
+        std::array<float, GRAPH_NUM> frame_ms;
+        std::array<std::array<char, TEXT_LENGTH>, TEXT_NUM> texts;
+
+        unsigned int graph_index;
+        unsigned int refresh_count;
+
+        unsigned int draw_calls_last;
+        unsigned int draw_calls_max;
+        unsigned long long alloc_count_sum;
+        unsigned long long alloc_count_max;
+        unsigned long long alloc_bytes_sum;
+        unsigned int alloc_frames;
+
+        int font_handle;
+        unsigned int background_color;
+        unsigned int text_color;
+        unsigned int good_color;
+        unsigned int warning_color;
+        unsigned int bad_color;
+        unsigned int line_color;
+
+        bool is_visible;
+    };
+}
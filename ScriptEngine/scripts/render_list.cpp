@@ -0,0 +1,334 @@
+﻿//!
+//! @file render_list.cpp
+//!
+//! @brief 1 フレームの描画を記録して描画ステートの切り替えを減らして描画するクラス実装
+//!
+//! @details
+//! ScriptEngine::Render() は DxWrapper を直接呼び出す代わりに RenderList に描画を記録し
+//! 最後に Flush() でまとめて描画します。
+//!
+//! 記録した描画はレイヤー、描画ステート(ブレンドモードと描画エリア)、記録した順番で並べ替え
+//! 前の描画とステートが違う時のみ SetDrawBlendMode() と SetDrawArea() を呼び出します。
+//! Flush() の最後はブレンド無し、全画面の描画エリアに戻すので
+//! Flush() の後に描画する処理(パフォーマンス表示など)は今までと同じステートで始まります。
+//!
+//! 並べ替えは安定ソートの代わりに記録した順番を比較に含めた std::sort で行い
+//! 記録用の配列は前のフレームの容量を使い回すので毎フレームのメモリ確保はありません。
+//!
+//! 画像の描画は同じレイヤー、同じステートの後ろの描画から同じ画像を探し
+//! 間にある描画と重ならなければ前に移して DrawGraphs() の 1 回の呼び出しで描画します。
+//! (重なる描画を追い越さないので、描画結果は記録した順番で描画した場合と変わりません)
+//! 文字列とサイズの分からない画像は範囲が無いので全ての描画と重なるとします。
+//!
+#include "dx_wrapper.h"
+#include "render_list.h"
+#include <algorithm>
+#include <tuple>
+
+namespace {
+    constexpr auto COMMAND_RESERVE = 64U;
+    constexpr auto BATCH_MIN = 2U;  // DrawGraphs() でまとめる最少の画像数
+    constexpr auto BATCH_SKIP_MAX = 64U;    // 重なりの判定が増え過ぎない様に、追い越す描画がこの数を超えたら探すのを止める
+}
+
+namespace amg
+{
+    RenderList::RenderList()
+    {
+        commands.reserve(COMMAND_RESERVE);
+        batch_positions.reserve(COMMAND_RESERVE * 2);
+        batch_skipped.reserve(COMMAND_RESERVE);
+        default_state = { DxWrapper::DX_BLENDMODE_NOBLEND, 0, 0, 0, 0, 0 };
+        current_state = default_state;
+        applied_state = default_state;
+        layer = Layer::IMAGE;
+    }
+
+    //!
+    //! @fn void RenderList::Initialize(int screen_width, int screen_height)
+    //! @brief 全画面の描画エリアを設定する
+    //! @param[in] screen_width 画面の幅
+    //! @param[in] screen_height 画面の高さ
+    //!
+    void RenderList::Initialize(int screen_width, int screen_height)
+    {
+        default_state = { DxWrapper::DX_BLENDMODE_NOBLEND, 0, 0, 0, screen_width, screen_height };
+        current_state = default_state;
+        applied_state = default_state;
+    }
+
+    //!
+    //! @fn void RenderList::Begin(Layer layer)
+    //! @brief 以降の描画を記録するレイヤーを設定する
+    //! @param[in] layer レイヤー
+    //! @details 記録中のステートはブレンド無し、全画面の描画エリアに戻ります。
+    //!
+    void RenderList::Begin(Layer layer)
+    {
+        this->layer = layer;
+        current_state = default_state;
+    }
+
+    //!
+    //! @fn void RenderList::SetDrawBlendMode(int blend_mode, int blend_param)
+    //! @brief 以降の描画のブレンドモードを設定する
+    //! @param[in] blend_mode DxWrapper::DX_BLENDMODE_*
+    //! @param[in] blend_param ブレンドのパラメーター
+    //!
+    void RenderList::SetDrawBlendMode(int blend_mode, int blend_param)
+    {
+        current_state.blend_mode = blend_mode;
+        current_state.blend_param = blend_param;
+    }
+
+    //!
+    //! @fn void RenderList::SetDrawArea(const Rect& area)
+    //! @brief 以降の描画の描画エリアを設定する
+    //! @param[in] area 描画エリア
+    //!
+    void RenderList::SetDrawArea(const Rect& area)
+    {
+        current_state.area_left = area.left;
+        current_state.area_top = area.top;
+        current_state.area_right = area.right;
+        current_state.area_bottom = area.bottom;
+    }
+
+    //!
+    //! @fn void RenderList::ResetDrawArea()
+    //! @brief 以降の描画の描画エリアを全画面に戻す
+    //!
+    void RenderList::ResetDrawArea()
+    {
+        current_state.area_left = default_state.area_left;
+        current_state.area_top = default_state.area_top;
+        current_state.area_right = default_state.area_right;
+        current_state.area_bottom = default_state.area_bottom;
+    }
+
+    //!
+    //! @fn void RenderList::DrawBox(int x1, int y1, int x2, int y2, unsigned int color)
+    //! @brief 塗りつぶした四角形の描画を記録する
+    //!
+    void RenderList::DrawBox(int x1, int y1, int x2, int y2, unsigned int color)
+    {
+        AddCommand(Type::BOX, x1, y1, x2, y2, color, -1, nullptr, true);
+    }
+
+    //!
+    //! @fn void RenderList::DrawString(int x, int y, const std::string& str, unsigned int color)
+    //! @brief 文字列の描画を記録する
+    //! @details 文字列はコピーしないので Flush() まで変更や破棄をしないで下さい。
+    //!
+    void RenderList::DrawString(int x, int y, const std::string& str, unsigned int color)
+    {
+        AddCommand(Type::STRING, x, y, 0, 0, color, -1, str.c_str(), false);
+    }
+
+    //!
+    //! @fn void RenderList::DrawGraph(int x, int y, int handle)
+    //! @brief 画像の描画(透過色有効)を記録する
+    //! @details 重なりを判定する為に画像のサイズを取得します。
+    //!
+    void RenderList::DrawGraph(int x, int y, int handle)
+    {
+        auto width = 0;
+        auto height = 0;
+        const auto has_bounds = (DxWrapper::GetGraphSize(handle, &width, &height) == 0);
+
+        AddCommand(Type::GRAPH, x, y, x + width, y + height, 0, handle, nullptr, has_bounds);
+    }
+
+    //!
+    //! @fn void RenderList::Flush()
+    //! @brief 記録した描画を並べ替えて描画する
+    //! @details 記録は全て消え、GetStats() はこの呼び出しの統計になります。
+    //!
+    void RenderList::Flush()
+    {
+        stats = Stats();
+        stats.commands = static_cast<unsigned int>(commands.size());
+
+        std::sort(commands.begin(), commands.end(), IsDrawBefore);
+
+        const auto count = static_cast<unsigned int>(commands.size());
+
+        for (auto i = 0U; i < count; ++i) {
+            const auto& command = commands[i];
+
+            if (command.is_drawn) {
+                continue;
+            }
+
+            ApplyState(command.state);
+
+            switch (command.type) {
+            case Type::BOX:
+                DxWrapper::DrawBox(command.x1, command.y1, command.x2, command.y2, command.color, DxWrapper::TRUE);
+                break;
+
+            case Type::STRING:
+                DxWrapper::DrawString(command.x1, command.y1, command.str, command.color);
+                break;
+
+            case Type::GRAPH:
+            {
+                CollectBatch(i);
+
+                const auto graph_num = static_cast<unsigned int>(batch_positions.size() / 2);
+
+                if (graph_num >= BATCH_MIN) {
+                    DxWrapper::DrawGraphs(batch_positions.data(), static_cast<int>(graph_num), command.handle, DxWrapper::TRUE);
+                    stats.batched_graphs += graph_num;
+                }
+                else {
+                    DxWrapper::DrawGraph(command.x1, command.y1, command.handle, DxWrapper::TRUE);
+                }
+                break;
+            }
+            }
+
+            ++stats.draw_calls;
+        }
+
+        ApplyState(default_state);
+
+        commands.clear();
+        current_state = default_state;
+        layer = Layer::IMAGE;
+    }
+
+    void RenderList::AddCommand(Type type, int x1, int y1, int x2, int y2, unsigned int color, int handle, const TCHAR* str, bool has_bounds)
+    {
+        Command command;
+
+        command.layer = layer;
+        command.state = current_state;
+        command.sequence = static_cast<unsigned int>(commands.size());
+        command.type = type;
+        command.x1 = x1;
+        command.y1 = y1;
+        command.x2 = x2;
+        command.y2 = y2;
+        command.color = color;
+        command.handle = handle;
+        command.str = str;
+        command.has_bounds = has_bounds;
+        command.is_drawn = false;
+
+        commands.emplace_back(command);
+    }
+
+    //!
+    //! @fn void RenderList::CollectBatch(unsigned int first)
+    //! @brief 画像の描画と一緒に描画出来る同じ画像の描画を集める
+    //! @param[in] first 並べ替え後の先頭の画像の描画
+    //! @details 集めた描画の位置は batch_positions に格納し、先頭以外は描画済みにします。
+    //! 同じレイヤー、同じステートの範囲で、間にある未描画の描画と重ならない物のみ集めます。
+    //!
+    void RenderList::CollectBatch(unsigned int first)
+    {
+        const auto& head = commands[first];
+        const auto count = static_cast<unsigned int>(commands.size());
+
+        batch_positions.clear();
+        batch_positions.emplace_back(head.x1);
+        batch_positions.emplace_back(head.y1);
+        batch_skipped.clear();
+
+        if (!head.has_bounds) {
+            return;
+        }
+
+        for (auto i = first + 1; i < count; ++i) {
+            auto&& command = commands[i];
+
+            // レイヤーとステートを跨いでまとめると描画の順番が変わる
+            if (command.layer != head.layer || !IsSameBlend(command.state, head.state) || !IsSameArea(command.state, head.state)) {
+                break;
+            }
+
+            if (command.is_drawn) {
+                continue;
+            }
+
+            auto is_movable = (command.type == Type::GRAPH && command.handle == head.handle);
+
+            for (auto j = 0U; j < batch_skipped.size() && is_movable; ++j) {
+                is_movable = !IsOverlap(commands[batch_skipped[j]], command);
+            }
+
+            if (is_movable) {
+                batch_positions.emplace_back(command.x1);
+                batch_positions.emplace_back(command.y1);
+                command.is_drawn = true;
+            }
+            else {
+                if (batch_skipped.size() >= BATCH_SKIP_MAX) {
+                    break;
+                }
+
+                batch_skipped.emplace_back(i);
+            }
+        }
+    }
+
+    //!
+    //! @fn void RenderList::ApplyState(const State& next)
+    //! @brief 設定済みのステートと違う項目のみ DX ライブラリに設定する
+    //! @param[in] next 次の描画のステート
+    //!
+    void RenderList::ApplyState(const State& next)
+    {
+        if (!IsSameBlend(applied_state, next)) {
+            DxWrapper::SetDrawBlendMode(next.blend_mode, next.blend_param);
+            ++stats.state_changes;
+        }
+
+        if (!IsSameArea(applied_state, next)) {
+            DxWrapper::SetDrawArea(next.area_left, next.area_top, next.area_right, next.area_bottom);
+            ++stats.state_changes;
+        }
+
+        applied_state = next;
+    }
+
+    //!
+    //! @fn bool RenderList::IsDrawBefore(const Command& left, const Command& right)
+    //! @brief 描画の順番を比較する
+    //! @details レイヤー、ブレンドモード、描画エリア、記録した順番の順に比較します。
+    //!
+    bool RenderList::IsDrawBefore(const Command& left, const Command& right)
+    {
+        const auto& l = left.state;
+        const auto& r = right.state;
+
+        return std::tie(left.layer, l.blend_mode, l.blend_param, l.area_left, l.area_top, l.area_right, l.area_bottom, left.sequence)
+            < std::tie(right.layer, r.blend_mode, r.blend_param, r.area_left, r.area_top, r.area_right, r.area_bottom, right.sequence);
+    }
+
+    //!
+    //! @fn bool RenderList::IsOverlap(const Command& left, const Command& right)
+    //! @brief 描画する範囲が重なるかを判定する
+    //! @details 範囲の無い描画は全ての描画と重なるとします。
+    //!
+    bool RenderList::IsOverlap(const Command& left, const Command& right)
+    {
+        if (!left.has_bounds || !right.has_bounds) {
+            return true;
+        }
+
+        return (left.x1 < right.x2) && (right.x1 < left.x2) && (left.y1 < right.y2) && (right.y1 < left.y2);
+    }
+
+    bool RenderList::IsSameBlend(const State& left, const State& right)
+    {
+        return (left.blend_mode == right.blend_mode) && (left.blend_param == right.blend_param);
+    }
+
+    bool RenderList::IsSameArea(const State& left, const State& right)
+    {
+        return (left.area_left == right.area_left) && (left.area_top == right.area_top)
+            && (left.area_right == right.area_right) && (left.area_bottom == right.area_bottom);
+    }
+}
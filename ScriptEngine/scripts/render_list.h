@@ -0,0 +1,134 @@
+﻿//!
+//! @file render_list.h
+//!
+//! @brief 1 フレームの描画を記録して描画ステートの切り替えを減らして描画するクラス定義
+//!
+#pragma once
+
+#include "amg_rect.h"
+#include <tchar.h>
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class RenderList
+    {
+    public:
+        //!
+        //! @brief 描画の順番
+        //! @details 違うレイヤーは必ずこの順番で描画します。
+        //! 同じレイヤー内の描画は重ならない事を前提に描画ステート毎にまとめ直します。
+        //! 同じ画像の描画は重なる描画を追い越さない範囲で 1 回の呼び出しにまとめます。
+        //!
+        enum class Layer {
+            IMAGE,          // 'd' コマンドの画像(重なる画像は記録した順番のまま)
+            MESSAGE_WINDOW, // 文字列用のウィンドウ
+            MESSAGE,        // 'm' コマンドの文字列とクリック待ち画像
+            CHOICE_AREA,    // 'c' コマンドの選択エリア
+            CHOICE_MESSAGE, // 'c' コマンドの文字列
+            CURSOR,         // マウスカーソル
+            NUM
+        };
+
+        //!
+        //! @brief 直近の Flush() の描画の統計
+        //!
+        struct Stats
+        {
+            unsigned int commands;      // 記録した描画の数
+            unsigned int draw_calls;    // 描画関数の呼び出し回数
+            unsigned int state_changes; // SetDrawBlendMode() と SetDrawArea() の呼び出し回数
+            unsigned int batched_graphs;// DrawGraphs() でまとめて描画した画像の数
+
+            Stats()
+            {
+                commands = 0;
+                draw_calls = 0;
+                state_changes = 0;
+                batched_graphs = 0;
+            }
+        };
+
+        RenderList();
+        RenderList(const RenderList&) = default;
+        RenderList(RenderList&&) noexcept = default;
+
+        virtual ~RenderList() = default;
+
+        RenderList& operator=(const RenderList& right) = default;
+        RenderList& operator=(RenderList&& right) noexcept = default;
+
+        void Initialize(int screen_width, int screen_height);
+
+        void Begin(Layer layer);
+        void SetDrawBlendMode(int blend_mode, int blend_param);
+        void SetDrawArea(const Rect& area);
+        void ResetDrawArea();
+
+        void DrawBox(int x1, int y1, int x2, int y2, unsigned int color);
+        void DrawString(int x, int y, const std::string& str, unsigned int color);
+        void DrawGraph(int x, int y, int handle);
+
+        void Flush();
+
+        inline const Stats& GetStats() const { return stats; }
+
+    private:
+        enum class Type {
+            BOX,
+            STRING,
+            GRAPH
+        };
+
+        //!
+        //! @brief 描画ステート
+        //! @details 描画エリアは左上と右下の座標です。
+        //!
+        struct State
+        {
+            int blend_mode;
+            int blend_param;
+            int area_left;
+            int area_top;
+            int area_right;
+            int area_bottom;
+        };
+
+        struct Command
+        {
+            Layer layer;
+            State state;
+            unsigned int sequence;  // 同じステート内で記録した順番を保つ為
+            Type type;
+            int x1;
+            int y1;
+            int x2;
+            int y2;
+            unsigned int color;
+            int handle;
+            const TCHAR* str;       // Flush() まで呼び出し側が保持する文字列
+            bool has_bounds;        // x1, y1, x2, y2 が描画する範囲か(文字列とサイズの分からない画像は範囲無し)
+            bool is_drawn;          // 前の画像の描画にまとめて描画済みか
+        };
+
+        void AddCommand(Type type, int x1, int y1, int x2, int y2, unsigned int color, int handle, const TCHAR* str, bool has_bounds);
+        void ApplyState(const State& next);
+        void CollectBatch(unsigned int first);
+
+        static bool IsDrawBefore(const Command& left, const Command& right);
+        static bool IsOverlap(const Command& left, const Command& right);
+        static bool IsSameBlend(const State& left, const State& right);
+        static bool IsSameArea(const State& left, const State& right);
+
+        std::vector<Command> commands;
+        std::vector<int> batch_positions;  // DrawGraphs() に渡す x, y の組(前のフレームの容量を使い回す)
+        std::vector<unsigned int> batch_skipped; // CollectBatch() で追い越す未描画の描画
+
+        Stats stats;
+        State default_state;
+        State current_state;    // 記録中のステート
+        State applied_state;    // DX ライブラリに設定済みのステート
+        Layer layer;
+    };
+}
@@ -15,12 +15,18 @@
 //! メッセージを 1 行描画します。
 //! メッセージは最大 3 行です。
 //! (コマンドを続けて指定出来ます)
+//! ウィンドウの幅を超えるメッセージは禁則処理をして自動的に改行し
+//! 続けて指定した m コマンドと同じく次の行に描画します。
+//! (配置はスクリプトの読み込み時に全ての m コマンドを事前に計算します)
 //! クリックや選択肢の決定で全ての c コマンドと m コマンドがクリアされます。
-//! 4 つ目以降の m コマンドは、先頭の m コマンドを上書きします。
+//! 3 行が一杯の時に描画する行(4 つ目以降の m コマンドや改行した行)は改ページします。
+//! その場でクリック待ち状態になり、クリックでクリアしてから残りの行を描画します。
+//! (@ コマンドを指定していなくてもクリック待ちが入ります)
 //!
 //! コマンド: w [wait]
-//! 構文: "w, 数値"
-//! 数値分のフレーム数を待ちます。
+//! 構文: "w, 数値" または "w, 数値ms"
+//! 数値分のフレーム数(1 フレームは 60 Hz の 1/60 秒)か、ms を付けた場合はミリ秒を待ちます。
+//! 待ち時間は実時間なので、リフレッシュレートやフレーム落ちで長さは変わりません。
 //!
 //! コマンド: j [jump]
 //! 構文: "j, ラベル"
@@ -65,6 +71,12 @@
 #include "command_choice.h"
 #include "command_message.h"
 #include "command_draw.h"
+#include "script_listener.h"
+#include "frame_profiler.h"
+#include "alloc_tracker.h"
+#include "logger.h"
+#include "execution_trace.h"
+#include "latency_tracker.h"
 #include "amg_string.h"
 #include <algorithm>
 
@@ -86,6 +98,15 @@ namespace {
 
     constexpr auto FONT_SIZE = 24;
 
+    // 描画済みの文字列の画像を保持する容量(メッセージ 1 行は約 100KB)
+    constexpr auto TEXT_CACHE_BUDGET_BYTES = 8ULL * 1024ULL * 1024ULL;
+
+    // 文字列を 1 文字表示する間隔
+    constexpr auto MESSAGE_CHAR_US = amg::ScriptEngine::FRAME_US;
+
+    // 'w' コマンドの数値をミリ秒として扱う接尾辞
+    constexpr char WAIT_MS_SUFFIX[] = "ms";
+
     constexpr auto MSG_WORD_MAX = 42;
     constexpr auto MSG_STRING_MAX = MSG_WORD_MAX * 2; // 2 : MultiByte String
 
@@ -147,16 +168,29 @@ namespace amg
     {
         input_manager = nullptr;
         scripts_data = nullptr;
+        render_list.reset(new RenderList());
+        text_cache.reset(new TextCache());
+        listener = nullptr;
+        input_recorder = nullptr;
+        input_replayer = nullptr;
+        profiler = nullptr;
+        execution_trace = nullptr;
+        latency_tracker = nullptr;
         state = ScriptState::PARSING;
         max_line = 0;
         now_line = 0;
-        wait_count = 0;
+        wait_us = 0;
+        reveal_us = 0;
+        message_page_row = -1;
+        parsing_limit = 0;
+        executed_lines = 0;
         cursor_x = 0;
         cursor_y = 0;
         cursor_image_handle = -1;
         click_wait_image_handle = -1;
         is_click_wait_visible = false;
         is_message_output = false;
+        dirty_flags = DIRTY_ALL;
     }
 
     ScriptEngine::~ScriptEngine()
@@ -180,32 +214,47 @@ namespace amg
         }
 
         input_manager.reset(new InputManager());
+        input_manager->SetRecorder(input_recorder);
+        input_manager->SetReplayer(input_replayer);
+        input_manager->SetLatencyTracker(latency_tracker);
         scripts_data.reset(new ScriptsData());
 
         if (!scripts_data->LoadJson(path)) {
+            AMG_LOG_CRITICAL(Logger::NO_LINE, nullptr, "failed to load scripts json: %s", path);
             return false;
         }
 
         max_line = scripts_data->GetScriptNum();
 
         if (max_line <= 0) {
+            AMG_LOG_CRITICAL(Logger::NO_LINE, nullptr, "scripts json has no lines: %s", path);
             return false;
         }
 
         PreParsing();
 
         if (!InitializeCursor()) {
+            AMG_LOG_CRITICAL(Logger::NO_LINE, nullptr, "cursor image '%s' is not defined", CURSOR_IMAGE_LABEL);
             return false;
         }
 
         if (!InitializeClickWait()) {
+            AMG_LOG_CRITICAL(Logger::NO_LINE, nullptr, "click wait image '%s' is not defined", CLICK_WAIT_IMAGE_LABEL);
             return false;
         }
 
+        AMG_LOG_INFO(Logger::NO_LINE, nullptr, "loaded %s (%u lines, %u labels, %u images)", path, max_line,
+            static_cast<unsigned int>(label_list.size()), static_cast<unsigned int>(image_list.size()));
+
         if (!InitializeStrings()) {
             return false;
         }
 
+        // 文字の幅はフォントの設定後でないと計れない
+        PreLayout();
+
+        dirty_flags = DIRTY_ALL;
+
         return true;
     }
 
@@ -223,6 +272,361 @@ namespace amg
         return input_manager->IsExit();
     }
 
+    //!
+    //! @fn bool ScriptEngine::IsEnd() const
+    //! @brief スクリプトの処理が終了したか
+    //! @return 'e' コマンドを処理したか、最終行を越えたか
+    //!
+    bool ScriptEngine::IsEnd() const
+    {
+        return (state == ScriptState::END) || (now_line >= max_line);
+    }
+
+    //!
+    //! @fn bool ScriptEngine::IsInputWait() const
+    //! @brief クリックや選択の入力を受け付けている状態か
+    //! @return 入力待ちか
+    //! @details クリック待ちでもメッセージ表示中のクリックは
+    //! 全文表示になるだけなので入力待ちとはしません。
+    //!
+    bool ScriptEngine::IsInputWait() const
+    {
+        if (state == ScriptState::CHOICE_WAIT) {
+            return true;
+        }
+
+        return (state == ScriptState::CLICK_WAIT) && !is_message_output;
+    }
+
+    //!
+    //! @fn bool ScriptEngine::IsRedrawNeeded() const
+    //! @brief 前回の Render() から描画内容が変化したか
+    //! @return 描画し直す必要があるか
+    //! @details 変化していなければ前回描画した画面をそのまま使用出来ます。
+    //! (クリック待ちでマウスも動かしていない間など)
+    //! Initialize() の直後と Destroy() の後は必ず true になります。
+    //!
+    bool ScriptEngine::IsRedrawNeeded() const
+    {
+        return dirty_flags != 0;
+    }
+
+    //!
+    //! @fn ScriptEngine::WakeUp ScriptEngine::GetWakeUp(unsigned long long& wait_us) const
+    //! @brief 次に Update() を呼び出す必要がある時を取得
+    //! @param[out] wait_us WakeUp::TIME の場合、時間待ちの残り時間(それ以外は 0)
+    //! @return 次に Update() を呼び出す必要がある時
+    //! @details WakeUp::INPUT の間は入力が無ければ Update() を呼び出しても何も変化しないので
+    //! メインループは入力があるまで待つ事が出来ます。
+    //! WakeUp::TIME の間は待った時間を Update() に渡して下さい。
+    //! (固定ステップの場合は待った時間分の回数の Update() を呼び出します)
+    //!
+    ScriptEngine::WakeUp ScriptEngine::GetWakeUp(unsigned long long& wait_us) const
+    {
+        wait_us = 0;
+
+        if (dirty_flags != 0 || is_message_output) {
+            return WakeUp::IMMEDIATE;
+        }
+
+        switch (state) {
+        case ScriptState::PARSING:
+            return WakeUp::IMMEDIATE;
+
+        case ScriptState::TIME_WAIT:
+            // 0 になった次の Update() で PARSING に戻る
+            if (this->wait_us == 0) {
+                return WakeUp::IMMEDIATE;
+            }
+
+            wait_us = this->wait_us;
+            return WakeUp::TIME;
+
+        case ScriptState::CLICK_WAIT:
+        case ScriptState::CHOICE_WAIT:
+        case ScriptState::END:
+            break;
+        }
+
+        return WakeUp::INPUT;
+    }
+
+    //!
+    //! @fn ScriptEngine::ScriptState ScriptEngine::GetState() const
+    //! @brief スクリプトエンジンの状態を取得
+    //! @return スクリプトエンジンの状態
+    //!
+    ScriptEngine::ScriptState ScriptEngine::GetState() const
+    {
+        return state;
+    }
+
+    //!
+    //! @fn unsigned int ScriptEngine::GetNowLine() const
+    //! @brief 処理中のスクリプトの行数を取得
+    //! @return スクリプトの行数
+    //!
+    unsigned int ScriptEngine::GetNowLine() const
+    {
+        return now_line;
+    }
+
+    //!
+    //! @fn unsigned int ScriptEngine::GetMaxLine() const
+    //! @brief スクリプトの総行数を取得
+    //! @return スクリプトの総行数
+    //!
+    unsigned int ScriptEngine::GetMaxLine() const
+    {
+        return max_line;
+    }
+
+    //!
+    //! @fn unsigned long long ScriptEngine::GetExecutedLines() const
+    //! @brief Parsing() で処理した行数を取得
+    //! @return 初期化してからの行数(同じ行も処理した回数だけ数える)
+    //!
+    unsigned long long ScriptEngine::GetExecutedLines() const
+    {
+        return executed_lines;
+    }
+
+    //!
+    //! @fn unsigned int ScriptEngine::GetImageCount() const
+    //! @brief 読み込んだ画像の数を取得
+    //! @return 'i' コマンドで読み込んだ画像の数
+    //!
+    unsigned int ScriptEngine::GetImageCount() const
+    {
+        return static_cast<unsigned int>(image_list.size());
+    }
+
+    //!
+    //! @fn const std::string& ScriptEngine::GetNowLabel() const
+    //! @brief 処理中の行が含まれるラベルを取得
+    //! @return ラベル文字列(処理中の行より前にラベルが無ければ空文字列)
+    //! @details 毎フレーム呼び出せるように文字列はコピーしません。
+    //!
+    const std::string& ScriptEngine::GetNowLabel() const
+    {
+        static const std::string empty;
+        const std::string* label_name = &empty;
+        auto label_line = 0U;
+
+        for (auto&& label : label_list) {
+            const auto line = label->GetLineNumber();
+
+            if (line <= now_line && line >= label_line) {
+                label_name = &label->GetLabelRef();
+                label_line = line;
+            }
+        }
+
+        return *label_name;
+    }
+
+    //!
+    //! @fn unsigned long long ScriptEngine::GetTextureBytes() const
+    //! @brief 読み込んだ画像のテクスチャーのサイズを取得
+    //! @return 画像のサイズ(1 ピクセル 4 バイトとした概算)
+    //!
+    unsigned long long ScriptEngine::GetTextureBytes() const
+    {
+        auto bytes = 0ULL;
+
+        for (auto&& image : image_list) {
+            auto width = 0;
+            auto height = 0;
+
+            if (DxWrapper::GetGraphSize(image->GetHandle(), &width, &height) == 0) {
+                bytes += static_cast<unsigned long long>(width) * static_cast<unsigned long long>(height) * 4ULL;
+            }
+        }
+
+        return bytes;
+    }
+
+    //!
+    //! @fn unsigned int ScriptEngine::GetDirtyFlags() const
+    //! @brief 前回の Render() から変化した描画を取得
+    //! @return DIRTY_IMAGE などの組み合わせ
+    //!
+    unsigned int ScriptEngine::GetDirtyFlags() const
+    {
+        return dirty_flags;
+    }
+
+    //!
+    //! @fn const RenderList::Stats& ScriptEngine::GetRenderStats() const
+    //! @brief 直前の Render() の描画関数と描画ステートの切り替えの回数を取得
+    //! @return 描画の統計
+    //!
+    const RenderList::Stats& ScriptEngine::GetRenderStats() const
+    {
+        return render_list->GetStats();
+    }
+
+    //!
+    //! @fn const TextCache::Stats& ScriptEngine::GetTextCacheStats() const
+    //! @brief 描画済みの文字列の画像の使用回数と保持しているサイズを取得
+    //! @return 文字列の画像の統計
+    //!
+    const TextCache::Stats& ScriptEngine::GetTextCacheStats() const
+    {
+        return text_cache->GetStats();
+    }
+
+    //!
+    //! @fn unsigned int ScriptEngine::GetChoiceNum() const
+    //! @brief 表示中の選択肢の数を取得
+    //! @return 選択肢の数
+    //!
+    unsigned int ScriptEngine::GetChoiceNum() const
+    {
+        return static_cast<unsigned int>(choice_list.size());
+    }
+
+    //!
+    //! @fn bool ScriptEngine::GetChoiceArea(unsigned int index, Rect& area) const
+    //! @brief 表示中の選択肢の選択エリアを取得
+    //! @param[in] index 選択肢のインデックス(上から 0 番目)
+    //! @param[out] area 選択エリア
+    //! @return 処理の成否
+    //!
+    bool ScriptEngine::GetChoiceArea(unsigned int index, Rect& area) const
+    {
+        if (index >= choice_list.size()) {
+            return false;
+        }
+
+        area = choice_list[index]->GetArea();
+
+        return true;
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetListener(ScriptListener* listener)
+    //! @brief スクリプトの実行を観測するリスナーを設定
+    //! @param[in] listener リスナー(nullptr で解除)
+    //! @details リスナーの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetListener(ScriptListener* listener)
+    {
+        this->listener = listener;
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetParsingLimit(unsigned int limit)
+    //! @brief 1 フレームで処理するスクリプトの最大行数を設定
+    //! @param[in] limit 最大行数(0 なら無制限)
+    //! @details 待ちの無い 'j' コマンドのループでも Update() が戻る様になります。
+    //! 最大行数に達した場合は次のフレームで続きから処理します。
+    //!
+    void ScriptEngine::SetParsingLimit(unsigned int limit)
+    {
+        parsing_limit = limit;
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetInputRecorder(InputRecorder* recorder)
+    //! @brief 毎フレームの入力を記録するレコーダーを設定
+    //! @param[in] recorder レコーダー(nullptr で解除)
+    //! @details Initialize() の前後どちらで設定しても有効です。
+    //! レコーダーの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetInputRecorder(InputRecorder* recorder)
+    {
+        input_recorder = recorder;
+
+        if (input_manager != nullptr) {
+            input_manager->SetRecorder(recorder);
+        }
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetInputReplayer(InputReplayer* replayer)
+    //! @brief 実際の入力の代わりに記録を再生するリプレイヤーを設定
+    //! @param[in] replayer リプレイヤー(nullptr で解除)
+    //! @details Initialize() の前後どちらで設定しても有効です。
+    //! 記録を再生し終わった後は実際の入力に戻ります。
+    //! リプレイヤーの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetInputReplayer(InputReplayer* replayer)
+    {
+        input_replayer = replayer;
+
+        if (input_manager != nullptr) {
+            input_manager->SetReplayer(replayer);
+        }
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetProfiler(FrameProfiler* profiler)
+    //! @brief 処理単位毎の処理時間を記録するプロファイラーを設定
+    //! @param[in] profiler プロファイラー(nullptr で解除)
+    //! @details Parsing、UpdateMessage、ChoiceWait、RenderImage、RenderMessage、RenderChoice を計測します。
+    //! プロファイラーの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetProfiler(FrameProfiler* profiler)
+    {
+        this->profiler = profiler;
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetExecutionTrace(ExecutionTrace* execution_trace)
+    //! @brief 実行した行と状態の遷移を記録するトレースを設定
+    //! @param[in] execution_trace トレース(nullptr で解除)
+    //! @details トレースの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetExecutionTrace(ExecutionTrace* execution_trace)
+    {
+        this->execution_trace = execution_trace;
+    }
+
+    //!
+    //! @fn void ScriptEngine::SetLatencyTracker(LatencyTracker* latency_tracker)
+    //! @brief クリックしてから画面に反映されるまでの遅延を計測するトラッカーを設定
+    //! @param[in] latency_tracker トラッカー(nullptr で解除)
+    //! @details Initialize() の前後どちらで設定しても有効です。
+    //! LatencyTracker::OnPresent() は画面に反映した後に呼び出し側で呼び出して下さい。
+    //! トラッカーの寿命は呼び出し側で管理します。
+    //!
+    void ScriptEngine::SetLatencyTracker(LatencyTracker* latency_tracker)
+    {
+        this->latency_tracker = latency_tracker;
+
+        if (input_manager != nullptr) {
+            input_manager->SetLatencyTracker(latency_tracker);
+        }
+    }
+
+    //!
+    //! @fn void ScriptEngine::OnDeviceRestore()
+    //! @brief デバイスロストから復帰した
+    //! @details DxWrapper::SetGraphicsDeviceRestoreCallbackFunction() で通知されたら次の Render() の前に呼び出して下さい。
+    //! MakeScreen で作成した文字列の画像は内容が失われているので全て破棄して次の描画で作り直します。
+    //! (LoadGraph で読み込んだ画像は DX ライブラリが読み込み直します)
+    //! 裏画面の内容も失われているので次の Render() は全て描画し直します。
+    //!
+    void ScriptEngine::OnDeviceRestore()
+    {
+        if (text_cache != nullptr) {
+            text_cache->Destroy();
+        }
+
+        ForceRedraw();
+    }
+
+    //!
+    //! @fn void ScriptEngine::ForceRedraw()
+    //! @brief 描画内容が変化していなくても次の Render() で全て描画し直す
+    //! @details 最小化から戻った時などウィンドウの内容が前回描画した画面と違う場合に呼び出します。
+    //!
+    void ScriptEngine::ForceRedraw()
+    {
+        dirty_flags = DIRTY_ALL;
+    }
+
     //!
     //! @fn bool ScriptEngine::InitializeCursor()
     //! @brief スクリプトエンジン用マウスカーソル画像の初期化
@@ -276,6 +680,9 @@ namespace amg
             return false;
         }
 
+        render_list->Initialize(screen_width, screen_height);
+        text_cache->Initialize(FONT_SIZE, TEXT_CACHE_BUDGET_BYTES);
+
         screen_center_x = screen_width / 2;
 
         message_window_left = screen_center_x - MSG_WINDOW_WIDTH / 2;
@@ -311,13 +718,21 @@ namespace amg
         input_manager.reset();
         input_manager = nullptr;
 
+        // ムーブ元は保持していない
+        if (text_cache != nullptr) {
+            text_cache->Destroy();
+        }
+
         scripts_data.reset();
         scripts_data = nullptr;
 
         state = ScriptState::PARSING;
         max_line = 0;
         now_line = 0;
-        wait_count = 0;
+        wait_us = 0;
+        reveal_us = 0;
+        message_page_row = -1;
+        executed_lines = 0;
         cursor_x = 0;
         cursor_y = 0;
         cursor_image_handle = -1;
@@ -330,28 +745,60 @@ namespace amg
         choice_list.clear();
         message_list.clear();
         draw_list.clear();
+
+        layout_list.clear();
+
+        dirty_flags = DIRTY_ALL;
     }
 
     //!
     //! @fn void ScriptEngine::Update()
+    //! @brief スクリプトエンジンの更新処理(固定ステップ)
+    //! @details FRAME_US の時間が経過したとして更新します。
+    //! EngineClock::Advance() が返した回数だけ呼び出すか、毎フレーム呼び出します。
+    //! (記録した入力の再生とヘッドレス実行はこちらを使用します)
+    //!
+    void ScriptEngine::Update()
+    {
+        Update(FRAME_US);
+    }
+
+    //!
+    //! @fn void ScriptEngine::Update(unsigned int elapsed_us)
     //! @brief スクリプトエンジンの更新処理
+    //! @param[in] elapsed_us 前回の Update() からの経過時間(マイクロ秒)
     //! @details 毎フレーム呼び出す必要があります。
+    //! 時間待ちと文字列の表示は経過時間で進めるので、フレームレートに関係なく同じ速さになります。
     //!
-    void ScriptEngine::Update()
+    void ScriptEngine::Update(unsigned int elapsed_us)
     {
+        const auto previous_state = state;
+
+        if (execution_trace != nullptr) {
+            execution_trace->BeginFrame();
+        }
+
         input_manager->Update();
 
-        DxWrapper::GetMousePoint(&(cursor_x), &(cursor_y));
+        if (cursor_x != input_manager->GetCursorX() || cursor_y != input_manager->GetCursorY()) {
+            dirty_flags |= DIRTY_CURSOR;
+        }
+
+        cursor_x = input_manager->GetCursorX();
+        cursor_y = input_manager->GetCursorY();
 
         auto is_update_message = false;
 
         switch (state) {
-        case ScriptState::PARSING:
+        case ScriptState::PARSING: {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::PARSING);
+
             Parsing();
             break;
+        }
 
         case ScriptState::TIME_WAIT:
-            TimeWait();
+            TimeWait(elapsed_us);
             is_update_message = true;
             break;
 
@@ -360,17 +807,34 @@ namespace amg
             is_update_message = true;
             break;
 
-        case ScriptState::CHOICE_WAIT:
+        case ScriptState::CHOICE_WAIT: {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::CHOICE_WAIT);
+
             ChoiceWait();
             is_update_message = true;
             break;
+        }
 
         case ScriptState::END:
             break;
         }
 
         if (is_update_message) {
-            UpdateMessage();
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::UPDATE_MESSAGE);
+
+            UpdateMessage(elapsed_us);
+        }
+
+        if (execution_trace != nullptr && state != previous_state) {
+            // Parsing() は遷移させた行の次の行に進んでいるので遷移させた行を記録する
+            // (改ページした 'm' コマンドは続きを表示する為に同じ行に留まっている)
+            const auto is_parsed = (previous_state == ScriptState::PARSING) && (now_line > 0) && (message_page_row < 0);
+
+            execution_trace->RecordState(is_parsed ? now_line - 1 : now_line, state);
+        }
+
+        if (listener != nullptr) {
+            listener->OnUpdate(state);
         }
     }
 
@@ -405,6 +869,41 @@ namespace amg
         now_line = 0;
     }
 
+    //!
+    //! @fn void ScriptEngine::PreLayout()
+    //! @brief スクリプトの文字列の事前配置
+    //! @details 'm' コマンドの文字列を予め全て配置(改行位置と 1 文字毎の表示範囲)して
+    //! 実行時は配置済みの結果を読むだけにします。
+    //! メッセージウィンドウの行数を超える 'm' コマンドは改ページするので警告します。
+    //! 'c' コマンドの文字列は選択肢の幅に収まるかを確認します。
+    //!
+    void ScriptEngine::PreLayout()
+    {
+        TextLayout layout;
+
+        for (auto line = 0U; line < max_line; ++line) {
+            const auto script = scripts_data->GetScript(line);
+            const auto command = (script[0])[0];
+
+            if (command == COMMAND_M && script.size() == 2) {
+                if (layout.Layout(script[1], MSG_LINE_WIDTH)) {
+                    const auto rows = static_cast<int>(layout.GetLines().size());
+
+                    if (rows > MSG_LINE_MAX) {
+                        AMG_LOG_WARNING(line, nullptr, "'m' message is taller than the message window (%d lines, split into pages)", rows);
+                    }
+
+                    layout_list.emplace(line, std::move(layout));
+                }
+            }
+            else if (command == COMMAND_C && script.size() == 3) {
+                if (layout.Layout(script[2], CHOICE_LINE_WIDTH) && layout.GetLines().size() > 1) {
+                    AMG_LOG_WARNING(line, nullptr, "'c' message is wider than the choice window");
+                }
+            }
+        }
+    }
+
     //!
     //! @fn void ScriptEngine::Parsing()
     //! @brief スクリプトの解析
@@ -414,11 +913,33 @@ namespace amg
     void ScriptEngine::Parsing()
     {
         auto stop_parsing = false;
+        auto parsed_line = 0U;
 
         while (!stop_parsing && (now_line >= 0) && (now_line < max_line)) {
+            if (parsing_limit > 0 && parsed_line >= parsing_limit) {
+                break;
+            }
+
+            ++parsed_line;
+
             const auto script = scripts_data->GetScript(now_line);
             const auto command = (script[0])[0];
 
+            // 改ページした 'm' コマンドの続きは同じ行の実行の続きなので数えない
+            const auto is_page_resume = (message_page_row >= 0);
+
+            if (!is_page_resume) {
+                ++executed_lines;
+
+                if (listener != nullptr) {
+                    listener->OnParse(now_line, command);
+                }
+
+                if (execution_trace != nullptr) {
+                    execution_trace->RecordInstruction(now_line, command);
+                }
+            }
+
             switch (command) {
             case COMMAND_A:
                 OnCommandClick();
@@ -427,6 +948,12 @@ namespace amg
 
             case COMMAND_M:
                 OnCommandMessage(now_line, script);
+
+                // 改ページしたらクリック待ちの後に同じ行の続きから表示する
+                if (message_page_row >= 0) {
+                    stop_parsing = true;
+                    continue;
+                }
                 break;
 
             case COMMAND_W:
@@ -458,39 +985,96 @@ namespace amg
 
             ++now_line;
         }
+
+        // 終了した場合はこれ以上描画内容が変わらないので、直前に描画した画面で反映したとする
+        if (latency_tracker != nullptr && IsEnd()) {
+            latency_tracker->OnReflect(true);
+        }
+
+        if (listener != nullptr) {
+            listener->OnParseEnd();
+        }
     }
 
     //!
-    //! @fn void ScriptEngine::UpdateMessage()
+    //! @fn void ScriptEngine::UpdateMessage(unsigned int elapsed_us)
     //! @brief 文字列を 1 文字づつ表示させる処理
+    //! @param[in] elapsed_us 前回の Update() からの経過時間
+    //! @details MESSAGE_CHAR_US 経過する毎に 1 文字表示し
+    //! 全て表示した後の MESSAGE_CHAR_US で表示の終了とします。
+    //! (FRAME_US 毎に呼び出した場合は 1 フレームに 1 文字です)
     //!
-    void ScriptEngine::UpdateMessage()
+    void ScriptEngine::UpdateMessage(unsigned int elapsed_us)
     {
+        const auto was_click_wait_visible = is_click_wait_visible;
+        auto is_complete = !is_message_output;
+
         is_click_wait_visible = false;
 
-        for (auto&& message : message_list) {
-            const auto area = message->GetArea();
-            const auto right_goal = message->GetRightGoal();
+        // クリックされたら全メッセージを表示
+        if (input_manager->IsClick()) {
+            for (auto&& message : message_list) {
+                const auto area = message->GetArea();
+                const auto right_goal = message->GetRightGoal();
+
+                // 全て表示した文字列はこのフレームで描画するので直ぐに反映したとする
+                if (latency_tracker != nullptr && area.right < right_goal) {
+                    latency_tracker->OnHandle(LatencyTracker::Interaction::SKIP);
+                    latency_tracker->OnReflect();
+                }
 
-            // クリックされたら全メッセージを表示
-            if (input_manager->IsClick()) {
-                message->UpdateAreaRight(right_goal);
-                continue;
+                if (area.right != right_goal) {
+                    message->UpdateAreaRight(right_goal);
+                    dirty_flags |= DIRTY_MESSAGE;
+                }
             }
 
-            // 右終端(全文字列)になるまで 1 文字サイズ分づつ足して行く
-            if (area.right < right_goal) {
-                message->UpdateAreaRight(area.right + FONT_SIZE);
-                return; // 1 文字分処理したらメソッド終了
+            is_complete = true;
+        }
+        else if (!is_complete) {
+            reveal_us += elapsed_us;
+
+            while (!is_complete && reveal_us >= MESSAGE_CHAR_US) {
+                reveal_us -= MESSAGE_CHAR_US;
+                is_complete = !RevealMessage();
             }
         }
 
-        // return せずに for 文が終わったなら全文字列を表示している
+        if (!is_complete) {
+            return;
+        }
+
+        reveal_us = 0;
         is_message_output = false;
 
         if (state == ScriptState::CLICK_WAIT) {
             is_click_wait_visible = (click_wait_image_handle != -1);
         }
+
+        if (is_click_wait_visible != was_click_wait_visible) {
+            dirty_flags |= DIRTY_MESSAGE;
+        }
+    }
+
+    //!
+    //! @fn bool ScriptEngine::RevealMessage()
+    //! @brief 表示中の文字列を 1 文字分表示する
+    //! @return 表示した場合は true、全文字列を表示していた場合は false
+    //!
+    bool ScriptEngine::RevealMessage()
+    {
+        for (auto&& message : message_list) {
+            const auto area = message->GetArea();
+            const auto right_goal = message->GetRightGoal();
+
+            // 右終端(全文字列)になるまで事前に配置した 1 文字分づつ広げて行く
+            if (area.right < right_goal && message->RevealGlyph()) {
+                dirty_flags |= DIRTY_MESSAGE;
+                return true;
+            }
+        }
+
+        return false;
     }
 
     //!
@@ -517,12 +1101,23 @@ namespace amg
     {
         auto wait = 0;
         auto result = false;
+        const auto& wait_string = scripts[1];
+        const auto suffix_length = sizeof(WAIT_MS_SUFFIX) - 1;
+        auto unit_us = static_cast<unsigned long long>(FRAME_US);
+
+        // 数値の後ろの文字列は ToInt() で無視される
+        if (wait_string.size() > suffix_length && wait_string.compare(wait_string.size() - suffix_length, suffix_length, WAIT_MS_SUFFIX) == 0) {
+            unit_us = 1000;
+        }
 
-        if (string::ToInt(scripts[1], wait)) {
-            wait_count = static_cast<unsigned int>(wait);
+        if (string::ToInt(wait_string, wait) && wait >= 0) {
+            wait_us = static_cast<unsigned long long>(wait) * unit_us;
             state = ScriptState::TIME_WAIT;
             result = true;
         }
+        else {
+            AMG_LOG_WARNING(now_line, GetNowLabel().c_str(), "'w' wait '%s' is not a non-negative number", scripts[1].c_str());
+        }
 
         return result;
     }
@@ -539,8 +1134,12 @@ namespace amg
         const auto result = GetLineNumber(scripts[1], line);
 
         if (result) {
+            AMG_LOG_DEBUG(now_line, GetNowLabel().c_str(), "'j' jump to '%s' (line %u)", scripts[1].c_str(), line);
             now_line = line;
         }
+        else {
+            AMG_LOG_WARNING(now_line, GetNowLabel().c_str(), "'j' unknown label '%s'", scripts[1].c_str());
+        }
 
         return result;
     }
@@ -554,9 +1153,11 @@ namespace amg
     //!
     bool ScriptEngine::OnCommandLabel(unsigned int line, const std::vector<std::string>& scripts)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::COMMAND);
         std::unique_ptr<CommandLabel> label(new CommandLabel(line, scripts));
 
         if (!label->Check()) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'l' has invalid arguments (%u)", static_cast<unsigned int>(scripts.size()));
             return false;
         }
 
@@ -574,9 +1175,16 @@ namespace amg
     //!
     bool ScriptEngine::OnCommandImage(unsigned int line, const std::vector<std::string>& scripts)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::COMMAND);
         std::unique_ptr<CommandImage> image(new CommandImage(line, scripts));
 
         if (!image->Check()) {
+            if (scripts.size() > 2) {
+                AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'i' failed to load image '%s'", scripts[2].c_str());
+            }
+            else {
+                AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'i' has %u arguments", static_cast<unsigned int>(scripts.size()));
+            }
             return false;
         }
 
@@ -594,15 +1202,18 @@ namespace amg
     //!
     bool ScriptEngine::OnCommandChoice(unsigned int line, const std::vector<std::string>& scripts)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::COMMAND);
         std::unique_ptr<CommandChoice> choice(new CommandChoice(line, scripts));
 
         if (!choice->Check()) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'c' has invalid arguments (%u)", static_cast<unsigned int>(scripts.size()));
             return false;
         }
 
         auto line_number = 0U;
 
         if (!GetLineNumber(choice->GetLabel(), line_number)) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'c' unknown label '%s'", choice->GetLabel().c_str());
             return false;
         }
 
@@ -621,6 +1232,12 @@ namespace amg
         }
 
         choice_list.emplace_back(std::move(choice));
+        dirty_flags |= DIRTY_CHOICE;
+
+        // クリック待ちを進めたり選択したりした結果は次の選択肢が現れた時に反映される
+        if (latency_tracker != nullptr) {
+            latency_tracker->OnReflect();
+        }
 
         return true;
     }
@@ -634,33 +1251,73 @@ namespace amg
     //!
     bool ScriptEngine::OnCommandMessage(unsigned int line, const std::vector<std::string>& scripts)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::COMMAND);
         std::unique_ptr<CommandMessage> message(new CommandMessage(line, scripts));
 
         if (!message->Check()) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'m' has invalid arguments (%u)", static_cast<unsigned int>(scripts.size()));
             return false;
         }
 
-        Rect rect;
-        int right_goal = 0;
+        const auto* const layout = GetMessageLayout(line);
 
-        if (!CalculateMessageArea(message->GetMessage(), rect, right_goal)) {
+        if (layout == nullptr) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'m' message area could not be calculated");
             return false;
         }
 
-        message->Initialize(std::move(rect), right_goal);
+        const auto& rows = layout->GetLines();
+        const auto first_row = (message_page_row < 0) ? 0U : static_cast<unsigned int>(message_page_row);
+
+        message_page_row = -1;
+
+        // 自動的に改行した行は続けて指定した m コマンドと同じく 1 行づつ追加する
+        for (auto index = first_row; index < rows.size(); ++index) {
+            // メッセージウィンドウが一杯なら改ページする(残りの行はクリック待ちの後に表示する)
+            if (static_cast<int>(message_list.size()) >= MSG_LINE_MAX) {
+                message_page_row = static_cast<int>(index);
+                state = ScriptState::CLICK_WAIT;
+                break;
+            }
+
+            const auto& row = rows[index];
+            std::unique_ptr<CommandMessage> row_message;
+
+            if (rows.size() == 1) {
+                row_message = std::move(message);
+            }
+            else {
+                const std::vector<std::string> row_scripts = { scripts[0], scripts[1].substr(row.offset, row.bytes) };
+
+                row_message.reset(new CommandMessage(line, row_scripts));
+            }
+
+            Rect rect;
+            int right_goal = 0;
+
+            CalculateMessageArea(row.width, rect, right_goal);
 
-        const auto size = static_cast<int>(message_list.size());
+            row_message->Initialize(std::move(rect), right_goal);
+            row_message->SetRevealGlyphs(layout->GetGlyphs().data() + row.glyph_begin, row.glyph_end - row.glyph_begin);
 
-        // 最大メッセージライン数を超えたら先頭(インデックス 0 )を削除
-        if (size > MSG_LINE_MAX) {
-            message_list.erase(message_list.begin() + 0);
+            message_list.emplace_back(std::move(row_message));
         }
 
-        message_list.emplace_back(std::move(message));
+        // 1 行も追加せずに改ページした場合は表示が変わらない
+        if (message_page_row == static_cast<int>(first_row)) {
+            return true;
+        }
+
+        dirty_flags |= DIRTY_MESSAGE;
 
         // メッセージコマンドを処理したらメッセージ表示を有効にする
         is_message_output = true;
 
+        // クリック待ちを進めたり選択したりした結果は次のメッセージが現れた時に反映される
+        if (latency_tracker != nullptr) {
+            latency_tracker->OnReflect();
+        }
+
         return true;
     }
 
@@ -673,15 +1330,18 @@ namespace amg
     //!
     bool ScriptEngine::OnCommandDraw(unsigned int line, const std::vector<std::string>& scripts)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::COMMAND);
         std::unique_ptr<CommandDraw> draw(new CommandDraw(line, scripts));
 
         if (!draw->Check()) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'d' has invalid arguments (%u)", static_cast<unsigned int>(scripts.size()));
             return false;
         }
 
         auto handle = 0;
 
         if (!GetImageHandle(draw->GetLabel(), handle)) {
+            AMG_LOG_WARNING(line, GetNowLabel().c_str(), "'d' unknown image label '%s'", draw->GetLabel().c_str());
             return false;
         }
 
@@ -696,6 +1356,12 @@ namespace amg
 
         draw_list.erase(remove, draw_list.end());
         draw_list.emplace_back(std::move(draw));
+        dirty_flags |= DIRTY_IMAGE;
+
+        // クリック待ちを進めたり選択したりした結果は画像が変わった時にも反映される
+        if (latency_tracker != nullptr) {
+            latency_tracker->OnReflect();
+        }
 
         // 描画リストが複数あるなら Index でソートする
         if (draw_list.size() >= 2) {
@@ -722,6 +1388,11 @@ namespace amg
         if (input_manager->IsClick()) {
             state = ScriptState::PARSING;
             message_list.clear();
+            dirty_flags |= DIRTY_MESSAGE;
+
+            if (latency_tracker != nullptr) {
+                latency_tracker->OnHandle(LatencyTracker::Interaction::ADVANCE);
+            }
         }
     }
 
@@ -748,6 +1419,12 @@ namespace amg
                     // 全ての文字列表示をなくす
                     message_list.clear();
                     choice_list.clear();
+                    dirty_flags |= DIRTY_MESSAGE | DIRTY_CHOICE;
+
+                    if (latency_tracker != nullptr) {
+                        latency_tracker->OnHandle(LatencyTracker::Interaction::CHOICE);
+                    }
+
                     return;
                 }
 
@@ -755,23 +1432,28 @@ namespace amg
                 color = choice_select_color;
             }
 
+            if (choice->IsCursorOver() != cursor_over || choice->GetColor() != color) {
+                dirty_flags |= DIRTY_CHOICE;
+            }
+
             choice->SetCursorOver(cursor_over);
             choice->SetColor(color);
         }
     }
 
     //!
-    //! @fn void ScriptEngine::TimeWait()
+    //! @fn void ScriptEngine::TimeWait(unsigned int elapsed_us)
     //! @brief 時間待ち処理
+    //! @param[in] elapsed_us 前回の Update() からの経過時間
     //!
-    void ScriptEngine::TimeWait()
+    void ScriptEngine::TimeWait(unsigned int elapsed_us)
     {
         if (is_message_output) {
             return;
         }
 
-        if (wait_count > 0) {
-            --wait_count;
+        if (wait_us > 0) {
+            wait_us -= std::min(wait_us, static_cast<unsigned long long>(elapsed_us));
         }
         else {
             state = ScriptState::PARSING;
@@ -779,35 +1461,43 @@ namespace amg
     }
 
     //!
-    //! @fn bool ScriptEngine::CalculateMessageArea(const std::string& message, Rect& area, int& right_goal)
-    //! @brief メッセージ文字列より表示エリアや右終端を計算する
-    //! @param[in] message メッセージ文字列
+    //! @fn const TextLayout* ScriptEngine::GetMessageLayout(unsigned int line) const
+    //! @brief PreLayout() で配置したメッセージ文字列を取得する
+    //! @param[in] line スクリプトの行番号
+    //! @return 文字列の配置(配置出来なかった場合は nullptr)
+    //!
+    const TextLayout* ScriptEngine::GetMessageLayout(unsigned int line) const
+    {
+        const auto it = layout_list.find(line);
+
+        if (it == layout_list.end()) {
+            return nullptr;
+        }
+
+        return &(it->second);
+    }
+
+    //!
+    //! @fn void ScriptEngine::CalculateMessageArea(int width, Rect& area, int& right_goal)
+    //! @brief メッセージ文字列の幅より表示エリアや右終端を計算する
+    //! @param[in] width メッセージ文字列の幅(TextLayout で計った 1 行の幅)
     //! @param[out] area メッセージ表示エリア
     //! @param[out] right_goal メッセージ右終端
-    //! @return 処理の成否
-    //! @details メッセージの順番や文字数より表示エリアを計算します。
+    //! @details メッセージの順番や文字列の幅より表示エリアを計算します。
     //! 表示エリアの右側は、初期値は左側と同値とします。
     //! (数学的にはエリアは面積を持たない)
     //! これは左側から 1 文字づつ表示していく仕様の為です。
     //! 実際の右側の値は right_goal に格納します。
     //!
-    bool ScriptEngine::CalculateMessageArea(const std::string& message, Rect& area, int& right_goal)
+    void ScriptEngine::CalculateMessageArea(int width, Rect& area, int& right_goal)
     {
-        if (message.empty()) {
-            return false;
-        }
-
         const auto line_index = static_cast<int>(message_list.size());
         const auto message_top = MSG_WINDOW_TOP + MSG_LINE_GRID_HEIGHT * line_index;
         const auto message_bottom = message_top + MSG_LINE_HEIGHT;
 
         area.Set(message_window_left, message_top, message_window_left, message_bottom);
 
-        const auto string_lenght = static_cast<int>(std::strlen(message.c_str()));
-
-        right_goal = message_window_left + ((string_lenght + 1) * (FONT_SIZE / 2));
-
-        return true;
+        right_goal = message_window_left + width;
     }
 
     //!
@@ -856,14 +1546,43 @@ namespace amg
     //! @fn void ScriptEngine::Render() const
     //! @brief スクリプトの全ての描画処理
     //! @details 毎フレーム呼び出す必要があります。
+    //! 各描画処理は RenderList に記録し、最後にブレンドモードと描画エリアの
+    //! 切り替えが少なくなる順番でまとめて描画します。
     //!
     void ScriptEngine::Render() const
     {
-        RenderImage();
-        RenderMessageWindow();
-        RenderMessage();
-        RenderChoice();
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::RENDER);
+
+        {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::RENDER_IMAGE);
+
+            RenderImage();
+        }
+
+        {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::RENDER_MESSAGE);
+
+            RenderMessageWindow();
+            RenderMessage();
+        }
+
+        {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::RENDER_CHOICE);
+
+            RenderChoice();
+        }
+
         RenderCursor();
+
+        {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::RENDER_SUBMIT);
+
+            render_list->Flush();
+        }
+
+        text_cache->EndFrame();
+
+        dirty_flags = 0;
     }
 
     //!
@@ -876,7 +1595,8 @@ namespace amg
             return;
         }
 
-        DxWrapper::DrawGraph(cursor_x, cursor_y, cursor_image_handle, DxWrapper::TRUE);
+        render_list->Begin(RenderList::Layer::CURSOR);
+        render_list->DrawGraph(cursor_x, cursor_y, cursor_image_handle);
     }
 
     //!
@@ -885,8 +1605,10 @@ namespace amg
     //!
     void ScriptEngine::RenderImage() const
     {
+        render_list->Begin(RenderList::Layer::IMAGE);
+
         for (auto&& draw : draw_list) {
-            DxWrapper::DrawGraph(draw->GetX(), draw->GetY(), draw->GetHandle(), DxWrapper::TRUE);
+            render_list->DrawGraph(draw->GetX(), draw->GetY(), draw->GetHandle());
         }
     }
 
@@ -896,22 +1618,20 @@ namespace amg
     //!
     void ScriptEngine::RenderMessageWindow() const
     {
-        DxWrapper::SetDrawBlendMode(DxWrapper::DX_BLENDMODE_ALPHA, 64);
+        render_list->Begin(RenderList::Layer::MESSAGE_WINDOW);
+        render_list->SetDrawBlendMode(DxWrapper::DX_BLENDMODE_ALPHA, 64);
 
-        DxWrapper::DrawBox(message_window_left, MSG_WINDOW_TOP,
-            message_window_right, MSG_WINDOW_BOTTOM,
-            message_window_color, DxWrapper::TRUE);
+        render_list->DrawBox(message_window_left, MSG_WINDOW_TOP,
+            message_window_right, MSG_WINDOW_BOTTOM, message_window_color);
 
 #ifdef _DEBUG
         // デバッグ中はメッセージエリアに色を付けて確認する
         for (auto&& message : message_list) {
-            const auto area = message->GetArea();
+            const auto& area = message->GetArea();
 
-            DxWrapper::DrawBox(area.left, area.top, area.right, area.bottom, message_area_color, DxWrapper::TRUE);
+            render_list->DrawBox(area.left, area.top, area.right, area.bottom, message_area_color);
         }
 #endif
-
-        DxWrapper::SetDrawBlendMode(DxWrapper::DX_BLENDMODE_NOBLEND, 0);
     }
 
     //!
@@ -920,20 +1640,26 @@ namespace amg
     //!
     void ScriptEngine::RenderMessage() const
     {
-        for (auto&& message : message_list) {
-            const auto area = message->GetArea();
+        render_list->Begin(RenderList::Layer::MESSAGE);
 
-            // 表示エリアを制御して 1文字づつ描画する
-            DxWrapper::SetDrawArea(area.left, area.top, area.right, area.bottom);
-            DxWrapper::DrawString(area.left, area.top,
-                message->GetMessage().c_str(), message_string_color);
+        // 表示エリアを全画面に戻すのは RenderList が行う
+        if (is_click_wait_visible) {
+            render_list->DrawGraph(click_wait_x, click_wait_y, click_wait_image_handle);
         }
 
-        // 表示エリアを全画面に戻す
-        DxWrapper::SetDrawArea(0, 0, screen_width, screen_height);
+        for (auto&& message : message_list) {
+            const auto& area = message->GetArea();
 
-        if (is_click_wait_visible) {
-            DxWrapper::DrawGraph(click_wait_x, click_wait_y, click_wait_image_handle, DxWrapper::TRUE);
+            // 表示エリアを制御して 1文字づつ描画する
+            // (全て表示した行は表示エリアで隠す部分が無いので全画面のまま描画して描画エリアの切り替えを減らす)
+            if (area.right < message->GetRightGoal()) {
+                render_list->SetDrawArea(area);
+            }
+            else {
+                render_list->ResetDrawArea();
+            }
+
+            DrawMessageString(area.left, area.top, message->GetMessageRef());
         }
     }
 
@@ -943,19 +1669,36 @@ namespace amg
     //!
     void ScriptEngine::RenderChoice() const
     {
-        // 先に選択エリアを描画してしまう
+        // 選択エリアは選択文字列より前のレイヤーなので 1 回のループで記録出来る
         for (auto&& choice : choice_list) {
-            const auto area = choice->GetArea();
+            const auto& area = choice->GetArea();
+
+            render_list->Begin(RenderList::Layer::CHOICE_AREA);
+            render_list->DrawBox(area.left, area.top, area.right, area.bottom, choice->GetColor());
 
-            DxWrapper::DrawBox(area.left, area.top, area.right, area.bottom, choice->GetColor(), DxWrapper::TRUE);
+            render_list->Begin(RenderList::Layer::CHOICE_MESSAGE);
+            DrawMessageString(area.left, area.top, choice->GetMessageRef());
         }
+    }
 
-        // 次に選択文字列を描画する
-        for (auto&& choice : choice_list) {
-            const auto area = choice->GetArea();
+    //!
+    //! @fn void ScriptEngine::DrawMessageString(int x, int y, const std::string& message) const
+    //! @brief 文字列の描画を記録する
+    //! @param[in] x 描画位置
+    //! @param[in] y 描画位置
+    //! @param[in] message 文字列
+    //! @details 描画済みの文字列の画像があれば DrawGraph() の 1 回で描画します。
+    //! (画像を作成出来なかった場合は DrawString() で描画します)
+    //!
+    void ScriptEngine::DrawMessageString(int x, int y, const std::string& message) const
+    {
+        const auto handle = text_cache->GetGraph(message, message_string_color);
 
-            DxWrapper::DrawString(area.left, area.top,
-                choice->GetMessage().c_str(), message_string_color);
+        if (handle != -1) {
+            render_list->DrawGraph(x, y, handle);
+        }
+        else {
+            render_list->DrawString(x, y, message, message_string_color);
         }
     }
 }
@@ -6,23 +6,62 @@
 #pragma once
 
 #include "amg_rect.h"
+#include "render_list.h"
+#include "text_cache.h"
+#include "text_layout.h"
 #include <tchar.h>
 #include <vector>
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 namespace amg
 {
     class InputManager;
+    class InputRecorder;
+    class InputReplayer;
     class ScriptsData;
     class CommandLabel;
     class CommandImage;
     class CommandChoice;
     class CommandMessage;
     class CommandDraw;
+    class ScriptListener;
+    class FrameProfiler;
+    class ExecutionTrace;
+    class LatencyTracker;
+    class ScriptEngineProbe;
+    class MemoryFootprint;
 
     class ScriptEngine {
     public:
+        enum class ScriptState {
+            PARSING,
+            TIME_WAIT,
+            CLICK_WAIT,
+            CHOICE_WAIT,
+            END
+        };
+
+        //!
+        //! @brief 次に Update() を呼び出す必要がある時(GetWakeUp() の値)
+        //!
+        enum class WakeUp {
+            IMMEDIATE,  // 次のフレーム(スクリプトの処理中、文字列の表示中、描画内容の変化)
+            TIME,       // 指定時間後('w' コマンドの時間待ち)
+            INPUT       // 入力があった時(クリック待ち、選択待ち、スクリプトの終了後)
+        };
+
+        // Update() の 1 回分の時間(60 Hz、固定ステップと 'w' コマンドのフレーム数の単位)
+        static constexpr unsigned int FRAME_US = 16667U;
+
+        // 前回の Render() から変化した描画(GetDirtyFlags() の値)
+        static constexpr unsigned int DIRTY_IMAGE = 1U << 0;    // draw_list
+        static constexpr unsigned int DIRTY_MESSAGE = 1U << 1;  // message_list と文字列の表示範囲、クリック待ち画像
+        static constexpr unsigned int DIRTY_CHOICE = 1U << 2;   // choice_list と選択エリアの色
+        static constexpr unsigned int DIRTY_CURSOR = 1U << 3;   // マウスカーソルの座標
+        static constexpr unsigned int DIRTY_ALL = DIRTY_IMAGE | DIRTY_MESSAGE | DIRTY_CHOICE | DIRTY_CURSOR;
+
         ScriptEngine();
         ScriptEngine(const ScriptEngine&) = default;
         ScriptEngine(ScriptEngine&&) noexcept = default;
@@ -36,30 +75,58 @@ namespace amg
         void Destroy();
 
         void Update();
+        void Update(unsigned int elapsed_us);
         void Render() const;
+        void OnDeviceRestore();
+        void ForceRedraw();
 
         bool IsExit() const;
+        bool IsEnd() const;
+        bool IsInputWait() const;
+        bool IsRedrawNeeded() const;
+        WakeUp GetWakeUp(unsigned long long& wait_us) const;
+
+        ScriptState GetState() const;
+        unsigned int GetNowLine() const;
+        unsigned int GetMaxLine() const;
+        unsigned long long GetExecutedLines() const;
+        unsigned int GetImageCount() const;
+        const std::string& GetNowLabel() const;
+        unsigned long long GetTextureBytes() const;
+        unsigned int GetChoiceNum() const;
+        unsigned int GetDirtyFlags() const;
+        const RenderList::Stats& GetRenderStats() const;
+        const TextCache::Stats& GetTextCacheStats() const;
+        bool GetChoiceArea(unsigned int index, Rect& area) const;
+
+        void SetListener(ScriptListener* listener);
+        void SetParsingLimit(unsigned int limit);
+        void SetInputRecorder(InputRecorder* recorder);
+        void SetInputReplayer(InputReplayer* replayer);
+        void SetProfiler(FrameProfiler* profiler);
+        void SetExecutionTrace(ExecutionTrace* execution_trace);
+        void SetLatencyTracker(LatencyTracker* latency_tracker);
 
     private:
-        enum class ScriptState {
-            PARSING,
-            TIME_WAIT,
-            CLICK_WAIT,
-            CHOICE_WAIT,
-            END
-        };
+        // ベンチマークなどのツールから内部の処理単位を直接呼び出す為
+        friend class ScriptEngineProbe;
+        // 構造毎のメモリ使用量を集計する為
+        friend class MemoryFootprint;
 
         bool InitializeCursor();
         bool InitializeClickWait();
         bool InitializeStrings();
 
         void PreParsing();
+        void PreLayout();
         void Parsing();
 
-        void UpdateMessage();
-        bool CalculateMessageArea(const std::string& message, Rect& area, int& right_goal);
+        void UpdateMessage(unsigned int elapsed_us);
+        bool RevealMessage();
+        const TextLayout* GetMessageLayout(unsigned int line) const;
+        void CalculateMessageArea(int width, Rect& area, int& right_goal);
 
-        void TimeWait();
+        void TimeWait(unsigned int elapsed_us);
         void ClickWait();
         void ChoiceWait();
 
@@ -80,9 +147,19 @@ namespace amg
         void RenderMessageWindow() const;
         void RenderMessage() const;
         void RenderChoice() const;
+        void DrawMessageString(int x, int y, const std::string& message) const;
 
         std::unique_ptr<InputManager> input_manager;
         std::unique_ptr<ScriptsData> scripts_data;
+        std::unique_ptr<RenderList> render_list;   // Render() const から記録する為
+        std::unique_ptr<TextCache> text_cache;     // Render() const から画像を作成する為
+
+        ScriptListener* listener;
+        InputRecorder* input_recorder;
+        InputReplayer* input_replayer;
+        FrameProfiler* profiler;
+        ExecutionTrace* execution_trace;
+        LatencyTracker* latency_tracker;
 
         std::vector<std::unique_ptr<CommandImage>> image_list;
         std::vector<std::unique_ptr<CommandLabel>> label_list;
@@ -90,11 +167,17 @@ namespace amg
         std::vector<std::unique_ptr<CommandMessage>> message_list;
         std::vector<std::unique_ptr<CommandDraw>> draw_list;
 
+        std::unordered_map<unsigned int, TextLayout> layout_list; // [行番号] = PreLayout() で配置した 'm' コマンドの文字列
+
         ScriptState state;
 
         unsigned int max_line;
         unsigned int now_line;
-        unsigned int wait_count;
+        unsigned long long wait_us;     // 時間待ちの残り時間
+        unsigned int reveal_us;         // 文字列の表示に使っていない経過時間
+        int message_page_row;           // 改ページした 'm' コマンドのクリック待ちの後に表示する行(改ページしていなければ -1)
+        unsigned int parsing_limit;
+        unsigned long long executed_lines;
 
         int cursor_x;
         int cursor_y;
@@ -104,5 +187,7 @@ namespace amg
 
         bool is_click_wait_visible;
         bool is_message_output;
+
+        mutable unsigned int dirty_flags;   // Render() const で消す為
     };
 }
@@ -0,0 +1,44 @@
+﻿//!
+//! @file script_listener.h
+//!
+//! @brief スクリプトエンジンの実行を外部から観測する為のインターフェース定義
+//!
+#pragma once
+
+#include "script_engine.h"
+#include <tchar.h>
+
+namespace amg
+{
+    class ScriptListener
+    {
+    public:
+        ScriptListener() = default;
+        ScriptListener(const ScriptListener&) = default;
+        ScriptListener(ScriptListener&&) noexcept = default;
+
+        virtual ~ScriptListener() = default;
+
+        ScriptListener& operator=(const ScriptListener& right) = default;
+        ScriptListener& operator=(ScriptListener&& right) noexcept = default;
+
+        //!
+        //! @brief Parsing() でスクリプトを 1 行処理する直前に呼び出されます
+        //! @param[in] line スクリプトの行数
+        //! @param[in] command コマンド文字
+        //!
+        virtual void OnParse(unsigned int line, TCHAR command) = 0;
+
+        //!
+        //! @brief Parsing() の処理を終える時に呼び出されます
+        //! @details 最後に処理した行の処理時間を計測する為に使用します。
+        //!
+        virtual void OnParseEnd() {}
+
+        //!
+        //! @brief Update() の最後に毎フレーム呼び出されます
+        //! @param[in] state このフレームの処理を終えた時のスクリプトエンジンの状態
+        //!
+        virtual void OnUpdate(ScriptEngine::ScriptState state) {}
+    };
+}
@@ -0,0 +1,459 @@
+﻿//!
+//! @file script_profiler.cpp
+//!
+//! @brief スクリプトの行毎の実行回数と処理時間を計測するクラス実装
+//!
+//! @details
+//! ScriptEngine::SetListener() で設定すると Parsing() で処理した行毎と
+//! コマンド毎に実行回数と処理時間を集計します。
+//! 行の処理時間は OnParse() から次の OnParse() か OnParseEnd() までの時間です。
+//!
+//! スクリプトは 'l' コマンドの行で区切ったラベル毎の区間にまとめ
+//! 区間毎に処理時間、区間に入った回数と TIME_WAIT、CLICK_WAIT、CHOICE_WAIT で
+//! 止まっていたフレーム数を集計します。(待ちのフレームは最後に処理した行の区間に加えます)
+//! 最初の 'l' コマンドより前の行は "(top)" の区間になります。
+//!
+//! 行番号はスクリプトの行(0 から)と Json ファイルの行(1 から)の両方を出力するので
+//! シナリオの作者は Json ファイルの該当箇所を直接確認出来ます。
+//! 1 度も入らなかった区間は entries が 0 になります。(実際に遊ばれていない区間)
+//!
+#include "script_profiler.h"
+#include "scripts_data.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+    constexpr auto TOP_SECTION_LABEL = "(top)";
+    constexpr auto SCRIPTS_KEY = "\"scripts\"";
+    constexpr auto DELIMITER = ", ";
+    constexpr auto COMMAND_L = _T('l');
+    constexpr auto COMMAND_NUM = 256U;
+
+    using Clock = std::chrono::steady_clock;
+
+    long long GetClockNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    double ToMicroseconds(const long long ns)
+    {
+        return static_cast<double>(ns) / 1000.0;
+    }
+
+    //!
+    //! @brief Json ファイルの "scripts" 配列の各要素が何行目にあるかを調べる
+    //! @param[in] path パス付のスクリプト用 Json ファイル名
+    //! @param[out] lines 要素毎の Json ファイルの行番号(1 から)
+    //! @return 処理の成否
+    //!
+    bool FindSourceLines(const TCHAR* path, std::vector<unsigned int>& lines)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs) {
+            return false;
+        }
+
+        const std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        auto position = text.find(SCRIPTS_KEY);
+
+        if (position == std::string::npos) {
+            return false;
+        }
+
+        position = text.find('[', position);
+
+        if (position == std::string::npos) {
+            return false;
+        }
+
+        auto source_line = 1U + static_cast<unsigned int>(std::count(text.begin(), text.begin() + position, '\n'));
+
+        lines.clear();
+
+        for (++position; position < text.size(); ++position) {
+            const auto c = text[position];
+
+            if (c == '\n') {
+                ++source_line;
+            }
+            else if (c == ']') {
+                return true;
+            }
+            else if (c == '"') {
+                lines.push_back(source_line);
+
+                // 文字列の終端まで読み飛ばす(エスケープされた '"' は終端ではない)
+                for (++position; position < text.size() && text[position] != '"'; ++position) {
+                    if (text[position] == '\\') {
+                        ++position;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+}
+
+namespace amg
+{
+    ScriptProfiler::ScriptProfiler()
+    {
+        parsing_line = 0;
+        last_section = 0;
+        frames = 0;
+        line_begin_ns = 0;
+        is_parsing = false;
+        is_section_entered = false;
+    }
+
+    //!
+    //! @fn bool ScriptProfiler::Initialize(const TCHAR* path)
+    //! @brief 計測するスクリプトを読み込む
+    //! @param[in] path パス付のスクリプト用 Json ファイル名(ScriptEngine::Initialize() と同じファイル)
+    //! @return 処理の成否
+    //! @details 行とラベルの区間、Json ファイルの行番号の対応を作成して計測結果を初期化します。
+    //!
+    bool ScriptProfiler::Initialize(const TCHAR* path)
+    {
+        ScriptsData scripts_data;
+
+        if (path == nullptr || !scripts_data.LoadJson(path)) {
+            return false;
+        }
+
+        const auto script_num = scripts_data.GetScriptNum();
+
+        scripts.clear();
+        line_sections.clear();
+        sections.clear();
+
+        sections.emplace_back();
+        sections.back().label = TOP_SECTION_LABEL;
+
+        for (auto i = 0U; i < script_num; ++i) {
+            const auto script = scripts_data.GetScript(i);
+            std::string line;
+
+            for (auto&& parameter : script) {
+                line += (line.empty() ? "" : DELIMITER) + parameter;
+            }
+
+            if (script.size() >= 2 && !script[0].empty() && script[0][0] == COMMAND_L) {
+                sections.emplace_back();
+                sections.back().label = script[1];
+                sections.back().line = i;
+            }
+
+            scripts.emplace_back(line);
+            line_sections.push_back(static_cast<unsigned int>(sections.size() - 1));
+        }
+
+        // Json ファイルの行番号が分からなければスクリプトの行番号で代用する
+        if (!FindSourceLines(path, source_lines) || source_lines.size() != script_num) {
+            source_lines.clear();
+        }
+
+        Clear();
+
+        return true;
+    }
+
+    //!
+    //! @fn void ScriptProfiler::Clear()
+    //! @brief 計測結果を初期化する
+    //!
+    void ScriptProfiler::Clear()
+    {
+        line_costs.assign(scripts.size(), Cost());
+        command_costs.assign(COMMAND_NUM, Cost());
+
+        for (auto&& section : sections) {
+            section.entries = 0;
+            section.time_wait_frames = 0;
+            section.click_wait_frames = 0;
+            section.choice_wait_frames = 0;
+        }
+
+        parsing_line = 0;
+        last_section = 0;
+        frames = 0;
+        line_begin_ns = 0;
+        is_parsing = false;
+        is_section_entered = false;
+    }
+
+    //!
+    //! @fn void ScriptProfiler::OnParse(unsigned int line, TCHAR command)
+    //! @brief 前の行の計測を終えて次の行の計測を開始する
+    //! @param[in] line スクリプトの行数
+    //! @param[in] command コマンド文字
+    //!
+    void ScriptProfiler::OnParse(unsigned int line, TCHAR command)
+    {
+        const auto now_ns = GetClockNanoseconds();
+
+        if (is_parsing) {
+            EndLine(now_ns);
+        }
+
+        if (line >= line_sections.size()) {
+            is_parsing = false;
+            return;
+        }
+
+        const auto section = line_sections[line];
+
+        if (!is_section_entered || section != last_section) {
+            ++sections[section].entries;
+        }
+
+        parsing_line = line;
+        last_section = section;
+        line_begin_ns = now_ns;
+        is_parsing = true;
+        is_section_entered = true;
+    }
+
+    //!
+    //! @fn void ScriptProfiler::OnParseEnd()
+    //! @brief 最後に処理した行の計測を終える
+    //!
+    void ScriptProfiler::OnParseEnd()
+    {
+        if (is_parsing) {
+            EndLine(GetClockNanoseconds());
+        }
+
+        is_parsing = false;
+    }
+
+    //!
+    //! @fn void ScriptProfiler::OnUpdate(ScriptEngine::ScriptState state)
+    //! @brief 待ち状態のフレーム数を最後に処理した行の区間に加える
+    //! @param[in] state このフレームの処理を終えた時のスクリプトエンジンの状態
+    //!
+    void ScriptProfiler::OnUpdate(ScriptEngine::ScriptState state)
+    {
+        ++frames;
+
+        if (!is_section_entered) {
+            return;
+        }
+
+        auto& section = sections[last_section];
+
+        switch (state) {
+        case ScriptEngine::ScriptState::TIME_WAIT:
+            ++section.time_wait_frames;
+            break;
+
+        case ScriptEngine::ScriptState::CLICK_WAIT:
+            ++section.click_wait_frames;
+            break;
+
+        case ScriptEngine::ScriptState::CHOICE_WAIT:
+            ++section.choice_wait_frames;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    //!
+    //! @fn void ScriptProfiler::GetLineReports(std::vector<LineReport>& reports) const
+    //! @brief 実行した行の計測結果を取得する
+    //! @param[out] reports 処理時間の長い順に並べた計測結果(実行していない行は含まない)
+    //!
+    void ScriptProfiler::GetLineReports(std::vector<LineReport>& reports) const
+    {
+        reports.clear();
+
+        for (auto i = 0U; i < line_costs.size(); ++i) {
+            const auto& cost = line_costs[i];
+
+            if (cost.count == 0) {
+                continue;
+            }
+
+            LineReport report;
+
+            report.line = i;
+            report.source_line = GetSourceLine(i);
+            report.label = sections[line_sections[i]].label;
+            report.script = scripts[i];
+            report.count = cost.count;
+            report.time_us = ToMicroseconds(cost.time_ns);
+
+            reports.emplace_back(report);
+        }
+
+        std::stable_sort(reports.begin(), reports.end(), [](const LineReport& left, const LineReport& right) {
+            return left.time_us > right.time_us;
+        });
+    }
+
+    //!
+    //! @fn void ScriptProfiler::GetCommandReports(std::vector<CommandReport>& reports) const
+    //! @brief 実行したコマンド毎の計測結果を取得する
+    //! @param[out] reports 処理時間の長い順に並べた計測結果
+    //!
+    void ScriptProfiler::GetCommandReports(std::vector<CommandReport>& reports) const
+    {
+        reports.clear();
+
+        for (auto i = 0U; i < command_costs.size(); ++i) {
+            const auto& cost = command_costs[i];
+
+            if (cost.count == 0) {
+                continue;
+            }
+
+            CommandReport report;
+
+            report.command = static_cast<TCHAR>(i);
+            report.count = cost.count;
+            report.time_us = ToMicroseconds(cost.time_ns);
+
+            reports.emplace_back(report);
+        }
+
+        std::stable_sort(reports.begin(), reports.end(), [](const CommandReport& left, const CommandReport& right) {
+            return left.time_us > right.time_us;
+        });
+    }
+
+    //!
+    //! @fn void ScriptProfiler::GetSectionReports(std::vector<SectionReport>& reports) const
+    //! @brief ラベルの区間毎の計測結果を取得する
+    //! @param[out] reports 処理時間の長い順に並べた計測結果(入らなかった区間も含む)
+    //! @details 処理時間が同じ場合は待ちのフレーム数の多い順にします。
+    //!
+    void ScriptProfiler::GetSectionReports(std::vector<SectionReport>& reports) const
+    {
+        reports.clear();
+
+        for (auto&& section : sections) {
+            SectionReport report;
+
+            report.label = section.label;
+            report.line = section.line;
+            report.source_line = GetSourceLine(section.line);
+            report.entries = section.entries;
+            report.time_wait_frames = section.time_wait_frames;
+            report.click_wait_frames = section.click_wait_frames;
+            report.choice_wait_frames = section.choice_wait_frames;
+
+            reports.emplace_back(report);
+        }
+
+        for (auto i = 0U; i < line_costs.size(); ++i) {
+            auto& report = reports[line_sections[i]];
+
+            report.count += line_costs[i].count;
+            report.time_us += ToMicroseconds(line_costs[i].time_ns);
+        }
+
+        std::stable_sort(reports.begin(), reports.end(), [](const SectionReport& left, const SectionReport& right) {
+            if (left.time_us != right.time_us) {
+                return left.time_us > right.time_us;
+            }
+
+            const auto left_frames = left.time_wait_frames + left.click_wait_frames + left.choice_wait_frames;
+            const auto right_frames = right.time_wait_frames + right.click_wait_frames + right.choice_wait_frames;
+
+            return left_frames > right_frames;
+        });
+    }
+
+    //!
+    //! @fn bool ScriptProfiler::SaveReport(const std::string& path) const
+    //! @brief 計測結果をタブ区切りのテキストファイルに保存する
+    //! @param[in] path 保存するファイル名
+    //! @return 処理の成否
+    //! @details 区間、コマンド、行の順に処理時間の長い順で出力します。
+    //! ラベルとスクリプトの文字コードはスクリプトエンジン内部と同じ(マルチバイト文字)です。
+    //!
+    bool ScriptProfiler::SaveReport(const std::string& path) const
+    {
+        std::ofstream file(path);
+
+        if (!file) {
+            return false;
+        }
+
+        std::vector<SectionReport> section_reports;
+        std::vector<CommandReport> command_reports;
+        std::vector<LineReport> line_reports;
+
+        GetSectionReports(section_reports);
+        GetCommandReports(command_reports);
+        GetLineReports(line_reports);
+
+        file << "frames\t" << frames << "\n";
+
+        file << "\n[sections]\n";
+        file << "time_us\tlines\tentries\ttime_wait_frames\tclick_wait_frames\tchoice_wait_frames\tjson_line\tlabel\n";
+
+        for (auto&& report : section_reports) {
+            file << report.time_us << "\t" << report.count << "\t" << report.entries << "\t"
+                << report.time_wait_frames << "\t" << report.click_wait_frames << "\t" << report.choice_wait_frames << "\t"
+                << report.source_line << "\t" << report.label << "\n";
+        }
+
+        file << "\n[commands]\n";
+        file << "time_us\tcount\tcommand\n";
+
+        for (auto&& report : command_reports) {
+            file << report.time_us << "\t" << report.count << "\t" << report.command << "\n";
+        }
+
+        file << "\n[lines]\n";
+        file << "time_us\tcount\tjson_line\tline\tlabel\tscript\n";
+
+        for (auto&& report : line_reports) {
+            file << report.time_us << "\t" << report.count << "\t" << report.source_line << "\t"
+                << report.line << "\t" << report.label << "\t" << report.script << "\n";
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    //!
+    //! @fn void ScriptProfiler::EndLine(long long now_ns)
+    //! @brief 処理中の行の計測を終える
+    //! @param[in] now_ns 現在時刻(ナノ秒)
+    //!
+    void ScriptProfiler::EndLine(long long now_ns)
+    {
+        const auto time_ns = now_ns - line_begin_ns;
+        const auto& script = scripts[parsing_line];
+        const auto command = script.empty() ? 0U : static_cast<unsigned char>(script[0]);
+
+        ++line_costs[parsing_line].count;
+        line_costs[parsing_line].time_ns += time_ns;
+
+        ++command_costs[command].count;
+        command_costs[command].time_ns += time_ns;
+    }
+
+    //!
+    //! @fn unsigned int ScriptProfiler::GetSourceLine(unsigned int line) const
+    //! @brief スクリプトの行に対応する Json ファイルの行番号を取得する
+    //! @param[in] line スクリプトの行数
+    //! @return Json ファイルの行番号(1 から)
+    //!
+    unsigned int ScriptProfiler::GetSourceLine(unsigned int line) const
+    {
+        if (line < source_lines.size()) {
+            return source_lines[line];
+        }
+
+        return line + 1;
+    }
+}
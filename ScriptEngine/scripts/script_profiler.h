@@ -0,0 +1,148 @@
+﻿//!
+//! @file script_profiler.h
+//!
+//! @brief スクリプトの行毎の実行回数と処理時間を計測するクラス定義
+//!
+#pragma once
+
+#include "script_engine.h"
+#include "script_listener.h"
+#include <tchar.h>
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class ScriptProfiler final : public ScriptListener
+    {
+    public:
+        struct LineReport
+        {
+            unsigned int line;
+            unsigned int source_line;
+            std::string label;
+            std::string script;
+            unsigned long long count;
+            double time_us;
+
+            LineReport()
+            {
+                line = 0;
+                source_line = 0;
+                count = 0;
+                time_us = 0.0;
+            }
+        };
+
+        struct CommandReport
+        {
+            TCHAR command;
+            unsigned long long count;
+            double time_us;
+
+            CommandReport()
+            {
+                command = _T('\0');
+                count = 0;
+                time_us = 0.0;
+            }
+        };
+
+        struct SectionReport
+        {
+            std::string label;
+            unsigned int line;
+            unsigned int source_line;
+            unsigned long long entries;
+            unsigned long long count;
+            double time_us;
+            unsigned int time_wait_frames;
+            unsigned int click_wait_frames;
+            unsigned int choice_wait_frames;
+
+            SectionReport()
+            {
+                line = 0;
+                source_line = 0;
+                entries = 0;
+                count = 0;
+                time_us = 0.0;
+                time_wait_frames = 0;
+                click_wait_frames = 0;
+                choice_wait_frames = 0;
+            }
+        };
+
+        ScriptProfiler();
+        ScriptProfiler(const ScriptProfiler&) = default;
+        ScriptProfiler(ScriptProfiler&&) noexcept = default;
+
+        virtual ~ScriptProfiler() = default;
+
+        ScriptProfiler& operator=(const ScriptProfiler& right) = default;
+        ScriptProfiler& operator=(ScriptProfiler&& right) noexcept = default;
+
+        bool Initialize(const TCHAR* path);
+        void Clear();
+
+        void OnParse(unsigned int line, TCHAR command) override;
+        void OnParseEnd() override;
+        void OnUpdate(ScriptEngine::ScriptState state) override;
+
+        void GetLineReports(std::vector<LineReport>& reports) const;
+        void GetCommandReports(std::vector<CommandReport>& reports) const;
+        void GetSectionReports(std::vector<SectionReport>& reports) const;
+        bool SaveReport(const std::string& path) const;
+
+        inline unsigned int GetFrames() const { return frames; }
+
+    private:
+        struct Cost
+        {
+            unsigned long long count;
+            long long time_ns;
+
+            Cost()
+            {
+                count = 0;
+                time_ns = 0;
+            }
+        };
+
+        struct Section
+        {
+            std::string label;
+            unsigned int line;
+            unsigned long long entries;
+            unsigned int time_wait_frames;
+            unsigned int click_wait_frames;
+            unsigned int choice_wait_frames;
+
+            Section()
+            {
+                line = 0;
+                entries = 0;
+                time_wait_frames = 0;
+                click_wait_frames = 0;
+                choice_wait_frames = 0;
+            }
+        };
+
+        void EndLine(long long now_ns);
+        unsigned int GetSourceLine(unsigned int line) const;
+
+        std::vector<std::string> scripts;
+        std::vector<unsigned int> source_lines;
+        std::vector<unsigned int> line_sections;
+        std::vector<Section> sections;
+        std::vector<Cost> line_costs;
+        std::vector<Cost> command_costs;
+
+        unsigned int parsing_line;
+        unsigned int last_section;
+        unsigned int frames;
+        long long line_begin_ns;
+        bool is_parsing;
+        bool is_section_entered;
+    };
+}
@@ -5,6 +5,7 @@
 //!
 #include "scripts_data.h"
 #include "amg_string.h"
+#include "alloc_tracker.h"
 #include "picojson.h"
 #include <windows.h>
 #include <fstream>
@@ -31,26 +32,34 @@ namespace amg
     //!
     bool ScriptsData::LoadJson(const TCHAR* path)
     {
+        AllocTracker::Scope alloc_scope(AllocTracker::Subsystem::SCRIPTS_DATA);
+
         // UTF-8 BOM無し Json file
         std::ifstream ifs(path);
         picojson::value json_value;
+        picojson::array array;
+
+        {
+            AllocTracker::Scope json_scope(AllocTracker::Subsystem::PICOJSON);
+
+            ifs >> json_value;
+
+            const auto err = picojson::get_last_error();
 
-        ifs >> json_value;
+            if (!err.empty()) {
+                return false;
+            }
 
-        const auto err = picojson::get_last_error();
+            auto root = json_value.get<picojson::array>();
+            auto object = root[0].get<picojson::object>();
 
-        if (!err.empty()) {
-            return false;
+            array = object["scripts"].get<picojson::array>();
         }
 
         if (scripts == nullptr) {
             scripts.reset(new std::vector<std::string>());
         }
 
-        auto root = json_value.get<picojson::array>();
-        auto object = root[0].get<picojson::object>();
-        const auto array = object["scripts"].get<picojson::array>();
-
         // UTF-8 -> Wide(UTF-16) -> MultiByte と文字コードを変換しながらスクリプト文字を取得
         for (auto i = array.begin(); i != array.end(); ++i) {
             const auto utf8 = (*i).get<std::string>();
@@ -170,4 +179,18 @@ namespace amg
 
         return string::Split(line, DELIMITER);
     }
+
+    //!
+    //! @fn size_t ScriptsData::GetMemoryBytes() const
+    //! @brief 読み込んだスクリプトの文字列が使用しているサイズを返す
+    //! @return 配列と全ての行の文字列がヒープに確保しているサイズ
+    //!
+    size_t ScriptsData::GetMemoryBytes() const
+    {
+        if (scripts == nullptr) {
+            return 0;
+        }
+
+        return sizeof(*scripts) + string::GetHeapBytes(*scripts);
+    }
 }
@@ -27,6 +27,7 @@ namespace amg
         bool LoadJson(const TCHAR* path);
         std::vector<std::string> GetScript(const unsigned int index) const;
         unsigned int GetScriptNum()  const;
+        size_t GetMemoryBytes() const;
 
     private:
         std::string GetScriptLine(const unsigned int index) const;
@@ -0,0 +1,196 @@
+﻿//!
+//! @file text_cache.cpp
+//!
+//! @brief 描画済みの文字列を画像として再利用するクラス実装
+//!
+//! @details
+//! DrawString() は呼び出す毎に文字列の 1 文字づつのグリフをフォントキャッシュから探して描画するので
+//! 'm' コマンドと 'c' コマンドの文字列は最初の 1 回のみ画像(MakeScreen)に描画し
+//! 以降のフレームは DrawGraph() の 1 回で描画します。
+//! (表示中の文字列は描画エリアで隠すので、画像は全文字列を描画したものを使い回せます)
+//!
+//! 画像は文字列をキーにして保持し、同じ文字列は違うコマンドでも同じ画像を使用します。
+//! 合計サイズが容量を超えたら最後に使用したフレームが古い順に破棄します。
+//! 同じフレームで使用した画像は RenderList::Flush() まで破棄出来ないので
+//! それらで容量を超えた場合は画像を作成せずに -1 を返します。(呼び出し側は DrawString() で描画します)
+//!
+//! フォントサイズ毎のグリフのキャッシュと破棄は DX ライブラリが行います。
+//!
+#include "dx_wrapper.h"
+#include "text_cache.h"
+
+namespace {
+    constexpr auto PIXEL_BYTES = 4ULL;
+}
+
+namespace amg
+{
+    TextCache::TextCache()
+    {
+        budget_bytes = 0;
+        frame = 0;
+        font_size = 0;
+    }
+
+    TextCache::~TextCache()
+    {
+        Destroy();
+    }
+
+    //!
+    //! @fn void TextCache::Initialize(int font_size, unsigned long long budget_bytes)
+    //! @brief 初期化
+    //! @param[in] font_size 文字列を描画するフォントサイズ(DxWrapper::SetFontSize() で設定したサイズ)
+    //! @param[in] budget_bytes 保持する画像の合計サイズの上限
+    //!
+    void TextCache::Initialize(int font_size, unsigned long long budget_bytes)
+    {
+        Destroy();
+
+        this->font_size = font_size;
+        this->budget_bytes = budget_bytes;
+    }
+
+    //!
+    //! @fn void TextCache::Destroy()
+    //! @brief 保持している全ての画像を破棄する
+    //! @details DxLib_End() の前とデバイスロストから復帰した時に呼び出して下さい。
+    //! (描画先にした画像は復帰しても内容が失われたままなので)
+    //!
+    void TextCache::Destroy()
+    {
+        for (auto&& entry : entries) {
+            DxWrapper::DeleteGraph(entry.second.handle);
+        }
+
+        entries.clear();
+        stats.bytes = 0;
+        stats.entries = 0;
+    }
+
+    //!
+    //! @fn int TextCache::GetGraph(const std::string& str, unsigned int color)
+    //! @brief 文字列を描画した画像を取得する
+    //! @param[in] str 文字列
+    //! @param[in] color 文字列の色
+    //! @return 画像のハンドル(作成出来なかった場合は -1)
+    //! @details 画像は左上が文字列の描画位置です。
+    //! このフレームの RenderList::Flush() までは破棄しません。
+    //!
+    int TextCache::GetGraph(const std::string& str, unsigned int color)
+    {
+        auto it = entries.find(str);
+
+        if (it != entries.end()) {
+            if (it->second.color == color) {
+                ++stats.hits;
+                it->second.last_frame = frame;
+                return it->second.handle;
+            }
+
+            // 色が違う場合は描画し直す
+            if (it->second.last_frame == frame) {
+                return -1;
+            }
+
+            DxWrapper::DeleteGraph(it->second.handle);
+            stats.bytes -= it->second.bytes;
+            --stats.entries;
+            entries.erase(it);
+        }
+
+        const auto width = DxWrapper::GetDrawStringWidth(str.c_str(), static_cast<int>(str.size()));
+
+        if (width <= 0 || font_size <= 0) {
+            return -1;
+        }
+
+        const auto bytes = static_cast<unsigned long long>(width) * static_cast<unsigned long long>(font_size) * PIXEL_BYTES;
+
+        // 作成してから破棄しない様に先に容量を空ける
+        if (!Evict(bytes)) {
+            return -1;
+        }
+
+        const auto handle = CreateGraph(str, color, width);
+
+        if (handle == -1) {
+            return -1;
+        }
+
+        entries.emplace(str, Entry{ handle, color, bytes, frame });
+        ++stats.misses;
+        stats.bytes += bytes;
+        ++stats.entries;
+
+        return handle;
+    }
+
+    //!
+    //! @fn void TextCache::EndFrame()
+    //! @brief フレームの終了
+    //! @details RenderList::Flush() の後に呼び出します。
+    //! 以降はこのフレームで使用した画像も破棄出来ます。
+    //!
+    void TextCache::EndFrame()
+    {
+        ++frame;
+    }
+
+    //!
+    //! @fn int TextCache::CreateGraph(const std::string& str, unsigned int color, int width)
+    //! @brief 文字列を透過画像に描画する
+    //! @param[in] str 文字列
+    //! @param[in] color 文字列の色
+    //! @param[in] width 文字列の幅(画像の高さはフォントサイズ)
+    //! @return 画像のハンドル(作成出来なかった場合は -1)
+    //! @details 描画先は裏画面に戻るので描画エリアは全画面になります。
+    //! (RenderList は Flush() の最後に全画面に戻しているので記録中の描画ステートと一致します)
+    //!
+    int TextCache::CreateGraph(const std::string& str, unsigned int color, int width)
+    {
+        const auto handle = DxWrapper::MakeScreen(width, font_size, DxWrapper::TRUE);
+
+        if (handle == -1) {
+            return -1;
+        }
+
+        DxWrapper::FillGraph(handle, 0, 0, 0, 0);
+        DxWrapper::SetDrawScreen(handle);
+        DxWrapper::DrawString(0, 0, str.c_str(), color);
+        DxWrapper::SetDrawScreen(DxWrapper::DX_SCREEN_BACK);
+
+        return handle;
+    }
+
+    //!
+    //! @fn bool TextCache::Evict(unsigned long long bytes)
+    //! @brief 画像を追加出来るまで古い画像を破棄する
+    //! @param[in] bytes 追加する画像のサイズ
+    //! @return 追加出来る場合は true
+    //!
+    bool TextCache::Evict(unsigned long long bytes)
+    {
+        while (stats.bytes + bytes > budget_bytes) {
+            auto oldest = entries.end();
+
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->second.last_frame != frame && (oldest == entries.end() || it->second.last_frame < oldest->second.last_frame)) {
+                    oldest = it;
+                }
+            }
+
+            if (oldest == entries.end()) {
+                return false;
+            }
+
+            DxWrapper::DeleteGraph(oldest->second.handle);
+            stats.bytes -= oldest->second.bytes;
+            --stats.entries;
+            ++stats.evictions;
+            entries.erase(oldest);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,70 @@
+﻿//!
+//! @file text_cache.h
+//!
+//! @brief 描画済みの文字列を画像として再利用するクラス定義
+//!
+#pragma once
+
+#include <unordered_map>
+#include <string>
+
+namespace amg
+{
+    class TextCache
+    {
+    public:
+        struct Stats
+        {
+            unsigned long long hits;        // 作成済みの画像を使用した回数
+            unsigned long long misses;      // 画像を作成した回数
+            unsigned long long evictions;   // 容量を超えて破棄した回数
+            unsigned long long bytes;       // 保持している画像のサイズ(1 ピクセル 4 バイト)
+            unsigned int entries;           // 保持している画像の数
+
+            Stats()
+            {
+                hits = 0;
+                misses = 0;
+                evictions = 0;
+                bytes = 0;
+                entries = 0;
+            }
+        };
+
+        TextCache();
+        TextCache(const TextCache&) = delete;
+        TextCache(TextCache&&) = delete;
+
+        virtual ~TextCache();
+
+        TextCache& operator=(const TextCache& right) = delete;
+        TextCache& operator=(TextCache&& right) = delete;
+
+        void Initialize(int font_size, unsigned long long budget_bytes);
+        void Destroy();
+
+        int GetGraph(const std::string& str, unsigned int color);
+        void EndFrame();
+
+        inline const Stats& GetStats() const { return stats; }
+
+    private:
+        struct Entry
+        {
+            int handle;
+            unsigned int color;
+            unsigned long long bytes;
+            unsigned long long last_frame;  // 最後に使用したフレーム
+        };
+
+        int CreateGraph(const std::string& str, unsigned int color, int width);
+        bool Evict(unsigned long long bytes);
+
+        std::unordered_map<std::string, Entry> entries;
+
+        Stats stats;
+        unsigned long long budget_bytes;
+        unsigned long long frame;
+        int font_size;
+    };
+}
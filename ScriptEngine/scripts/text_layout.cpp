@@ -0,0 +1,247 @@
+﻿//!
+//! @file text_layout.cpp
+//!
+//! @brief 文字列の幅を計って禁則処理をしながら行に分けるクラス実装
+//!
+//! @details
+//! スクリプトの文字列はマルチバイト文字(CP_ACP)なので、1 度 UTF-16 に変換して
+//! 1 文字毎にマルチバイト文字のバイト数を求めます。(Shift_JIS でも UTF-8 でも同じ様に分けられます)
+//! 文字の幅は DxWrapper::GetDrawStringWidth() で 1 文字づつ計るので、全角と半角が混ざっていても正しい幅になります。
+//!
+//! 行の幅を超える文字の手前で改行し、次の場合は改行する位置を前に戻します。(追い出し)
+//! ・次の行の先頭が行頭禁則文字(、。」）ー ゃ など)
+//! ・前の行の末尾が行末禁則文字(「（ など)
+//! ・英数字の単語の途中
+//! 戻せる位置が無い場合(1 行が全て禁則文字など)は幅を超える文字の手前で改行します。
+//! 改行した位置の半角と全角のスペースは次の行の先頭に表示しません。
+//!
+#include "dx_wrapper.h"
+#include "text_layout.h"
+#include <windows.h>
+
+namespace {
+    // 行頭禁則文字(行の先頭に置かない)
+    constexpr wchar_t LINE_START_FORBIDDEN[] =
+        L"、。，．・：；？！゛゜ヽヾゝゞ々ー）］｝」』】〕〉》〙〗’”"
+        L"ぁぃぅぇぉっゃゅょゎゕゖァィゥェォッャュョヮヵヶ…‥"
+        L",.:;?!)]}";
+
+    // 行末禁則文字(行の末尾に置かない)
+    constexpr wchar_t LINE_END_FORBIDDEN[] = L"（［｛「『【〔〈《〘〖‘“([{";
+
+    bool Contains(const wchar_t* table, wchar_t code)
+    {
+        for (auto p = table; *p != L'\0'; ++p) {
+            if (*p == code) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool IsSpace(wchar_t code)
+    {
+        return (code == L' ') || (code == L'\x3000');
+    }
+
+    // 単語の途中で改行しない半角英数字
+    bool IsWordCharacter(wchar_t code)
+    {
+        return ((code >= L'0') && (code <= L'9')) || ((code >= L'A') && (code <= L'Z')) || ((code >= L'a') && (code <= L'z'));
+    }
+
+    bool IsHighSurrogate(wchar_t code)
+    {
+        return (code >= 0xD800) && (code <= 0xDBFF);
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn bool TextLayout::Layout(const std::string& text, int max_width)
+    //! @brief 文字列を行に分ける
+    //! @param[in] text マルチバイト文字列
+    //! @param[in] max_width 1 行の幅の上限
+    //! @return 処理の成否(空の文字列と変換出来ない文字列は失敗)
+    //! @details DxWrapper::SetFontSize() で設定したフォントで計ります。
+    //!
+    bool TextLayout::Layout(const std::string& text, int max_width)
+    {
+        glyphs.clear();
+        lines.clear();
+
+        if (!MeasureGlyphs(text)) {
+            return false;
+        }
+
+        const auto glyph_num = static_cast<unsigned int>(glyphs.size());
+        auto line_begin = 0U;
+        auto x = 0;
+
+        for (auto i = 0U; i < glyph_num; ++i) {
+            // 行の先頭のスペースは表示しない
+            if (i == line_begin && IsSpace(glyphs[i].code) && !lines.empty()) {
+                ++line_begin;
+                continue;
+            }
+
+            if (x + glyphs[i].advance > max_width && i > line_begin) {
+                const auto line_end = FindBreak(line_begin, i);
+
+                AddLine(line_begin, line_end);
+
+                line_begin = line_end;
+                x = 0;
+
+                // 改行した位置から数え直す
+                i = line_end - 1;
+                continue;
+            }
+
+            x += glyphs[i].advance;
+        }
+
+        if (line_begin < glyph_num) {
+            AddLine(line_begin, glyph_num);
+        }
+
+        return !lines.empty();
+    }
+
+    //!
+    //! @fn bool TextLayout::IsLineStartForbidden(wchar_t code)
+    //! @brief 行頭禁則文字か
+    //! @param[in] code UTF-16 の文字
+    //! @return 行の先頭に置かない文字の場合は true
+    //!
+    bool TextLayout::IsLineStartForbidden(wchar_t code)
+    {
+        return Contains(LINE_START_FORBIDDEN, code);
+    }
+
+    //!
+    //! @fn bool TextLayout::IsLineEndForbidden(wchar_t code)
+    //! @brief 行末禁則文字か
+    //! @param[in] code UTF-16 の文字
+    //! @return 行の末尾に置かない文字の場合は true
+    //!
+    bool TextLayout::IsLineEndForbidden(wchar_t code)
+    {
+        return Contains(LINE_END_FORBIDDEN, code);
+    }
+
+    //!
+    //! @fn bool TextLayout::MeasureGlyphs(const std::string& text)
+    //! @brief 文字列を 1 文字づつに分けて幅を計る
+    //! @param[in] text マルチバイト文字列
+    //! @return 処理の成否
+    //!
+    bool TextLayout::MeasureGlyphs(const std::string& text)
+    {
+        if (text.empty()) {
+            return false;
+        }
+
+        const auto in_length = static_cast<int>(text.length());
+        const auto wide_length = MultiByteToWideChar(CP_ACP, 0, text.c_str(), in_length, 0, 0);
+
+        if (wide_length <= 0) {
+            return false;
+        }
+
+        std::vector<wchar_t> wide(wide_length);
+
+        MultiByteToWideChar(CP_ACP, 0, text.c_str(), in_length, &(wide[0]), wide_length);
+
+        glyphs.reserve(wide.size());
+
+        auto offset = 0U;
+
+        for (auto i = 0; i < wide_length; ++i) {
+            // サロゲートペアは 2 つで 1 文字
+            const auto units = (IsHighSurrogate(wide[i]) && (i + 1 < wide_length)) ? 2 : 1;
+            const auto bytes = WideCharToMultiByte(CP_ACP, 0, &(wide[i]), units, 0, 0, 0, 0);
+
+            if (bytes <= 0 || offset + bytes > text.length()) {
+                glyphs.clear();
+                return false;
+            }
+
+            Glyph glyph;
+
+            glyph.offset = offset;
+            glyph.bytes = static_cast<unsigned int>(bytes);
+            glyph.advance = DxWrapper::GetDrawStringWidth(text.c_str() + offset, bytes);
+            glyph.reveal_right = 0;
+            glyph.code = wide[i];
+
+            glyphs.emplace_back(glyph);
+
+            offset += glyph.bytes;
+            i += units - 1;
+        }
+
+        return true;
+    }
+
+    //!
+    //! @fn unsigned int TextLayout::FindBreak(unsigned int line_begin, unsigned int overflow) const
+    //! @brief 禁則処理をして改行する位置を探す
+    //! @param[in] line_begin 行の先頭の文字
+    //! @param[in] overflow 行の幅を超えた文字
+    //! @return 次の行の先頭の文字
+    //!
+    unsigned int TextLayout::FindBreak(unsigned int line_begin, unsigned int overflow) const
+    {
+        for (auto next = overflow; next > line_begin + 1; --next) {
+            const auto previous_code = glyphs[next - 1].code;
+            const auto next_code = glyphs[next].code;
+
+            if (IsLineStartForbidden(next_code) || IsLineEndForbidden(previous_code)) {
+                continue;
+            }
+
+            if (IsWordCharacter(previous_code) && IsWordCharacter(next_code)) {
+                continue;
+            }
+
+            return next;
+        }
+
+        return overflow;
+    }
+
+    //!
+    //! @fn void TextLayout::AddLine(unsigned int glyph_begin, unsigned int glyph_end)
+    //! @brief 1 行分の配置を追加する
+    //! @param[in] glyph_begin 行の先頭の文字
+    //! @param[in] glyph_end 次の行の先頭の文字
+    //! @details 行の末尾のスペースは幅に含めません。
+    //! 行の各文字には 1 文字づつ表示する時の表示範囲の右端を設定します。
+    //!
+    void TextLayout::AddLine(unsigned int glyph_begin, unsigned int glyph_end)
+    {
+        auto last = glyph_end;
+
+        while (last > glyph_begin + 1 && IsSpace(glyphs[last - 1].code)) {
+            --last;
+        }
+
+        Line line;
+
+        line.offset = glyphs[glyph_begin].offset;
+        line.bytes = glyphs[last - 1].offset + glyphs[last - 1].bytes - line.offset;
+        line.glyph_begin = glyph_begin;
+        line.glyph_end = last;
+        line.width = 0;
+
+        for (auto i = glyph_begin; i < last; ++i) {
+            line.width += glyphs[i].advance;
+            glyphs[i].reveal_right = line.width;
+        }
+
+        lines.emplace_back(line);
+    }
+}
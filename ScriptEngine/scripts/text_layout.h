@@ -0,0 +1,67 @@
+﻿//!
+//! @file text_layout.h
+//!
+//! @brief 文字列の幅を計って禁則処理をしながら行に分けるクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class TextLayout
+    {
+    public:
+        //!
+        //! @brief 1 文字分の配置
+        //! @details offset と bytes はマルチバイト文字列の中の位置です。
+        //!
+        struct Glyph
+        {
+            unsigned int offset;
+            unsigned int bytes;
+            int advance;        // 文字の送り幅(DxWrapper::GetDrawStringWidth() で計った幅)
+            int reveal_right;   // 行の左端からこの文字の右端までの幅(1 文字づつ表示する時の表示範囲)
+            wchar_t code;       // 禁則処理の判定用(サロゲートペアは上位のみ)
+        };
+
+        //!
+        //! @brief 1 行分の配置
+        //! @details glyph_begin から glyph_end の手前までの文字を 1 行に表示します。
+        //!
+        struct Line
+        {
+            unsigned int offset;
+            unsigned int bytes;
+            unsigned int glyph_begin;
+            unsigned int glyph_end;
+            int width;
+        };
+
+        TextLayout() = default;
+        TextLayout(const TextLayout&) = default;
+        TextLayout(TextLayout&&) noexcept = default;
+
+        virtual ~TextLayout() = default;
+
+        TextLayout& operator=(const TextLayout& right) = default;
+        TextLayout& operator=(TextLayout&& right) noexcept = default;
+
+        bool Layout(const std::string& text, int max_width);
+
+        inline const std::vector<Glyph>& GetGlyphs() const { return glyphs; }
+        inline const std::vector<Line>& GetLines() const { return lines; }
+
+        static bool IsLineStartForbidden(wchar_t code);
+        static bool IsLineEndForbidden(wchar_t code);
+
+    private:
+        bool MeasureGlyphs(const std::string& text);
+        unsigned int FindBreak(unsigned int line_begin, unsigned int overflow) const;
+        void AddLine(unsigned int glyph_begin, unsigned int glyph_end);
+
+        std::vector<Glyph> glyphs;
+        std::vector<Line> lines;
+    };
+}
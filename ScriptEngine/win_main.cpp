@@ -5,7 +5,22 @@
 //!
 #include "dx_wrapper.h"
 #include "script_engine.h"
+#include "input_record.h"
+#include "frame_profiler.h"
+#include "script_profiler.h"
+#include "alloc_tracker.h"
+#include "perf_hud.h"
+#include "logger.h"
+#include "execution_trace.h"
+#include "metrics_exporter.h"
+#include "latency_tracker.h"
+#include "memory_footprint.h"
+#include "engine_clock.h"
 #include <windows.h>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <chrono>
 #ifdef _DEBUG
 #include <crtdbg.h>
 #endif
@@ -16,6 +31,162 @@ namespace {
     constexpr auto SCREEN_DEPTH = 32;
     constexpr auto SCRIPTS_JSON_PATH = _T("escape_from_amg.json");
     constexpr auto WINDOW_TITLE = _T("AMG ScriptEngine Sample");
+    constexpr auto LOG_PATH = "script_engine.log";
+    constexpr auto EXEC_TRACE_PATH = "execution_trace.bin";
+    constexpr auto METRICS_INTERVAL_MS = 10000U;
+    // 待ち中もウィンドウの状態を確認する間隔(EngineClock が 1 回で進める経過時間の上限を超えない)
+    constexpr auto IDLE_WAIT_MAX_MS = amg::EngineClock::MAX_DELTA_US / 1000U;
+
+    // コマンドライン引数
+    // -record ファイル : プレイ中の入力を記録してアプリ終了時に保存する
+    // -replay ファイル : 記録した入力を再生する(再生し終わったら通常の入力に戻る)
+    // -profile ファイル : 処理単位毎の処理時間を計測して F12 キーとアプリ終了時に trace event 形式で保存する
+    // -line-profile ファイル : スクリプトの行、コマンド、ラベルの区間毎の処理時間を計測してアプリ終了時に保存する
+    // -alloc-report ファイル : 処理単位毎のメモリ確保の集計を F12 キーとアプリ終了時に保存する(AMG_ALLOC_TRACKING を定義したビルドのみ)
+    // -hud : パフォーマンス表示(F11 キーで切り替え)を表示した状態で起動する
+    // -log ファイル : 診断用のログの出力先(省略時は LOG_PATH)
+    // -exec-trace ファイル : 実行した行と状態の遷移を F12 キーとクラッシュ時に保存する先(省略時は EXEC_TRACE_PATH)
+    // -metrics ファイル : 計測値を Prometheus のテキスト形式で METRICS_INTERVAL_MS 毎に保存する
+    // -latency ファイル : クリックしてから画面に反映されるまでの遅延を F12 キーとアプリ終了時に保存する
+    // -memory-report ファイル : 構造毎のメモリ使用量と最大値を F12 キーとアプリ終了時に保存する
+    // -full-redraw : 描画内容が変化していないフレームも毎フレーム描画し直す
+    // -no-idle-wait : 入力待ちと時間待ちの間もスレッドを止めずに毎フレーム Update() する
+    // -fixed-step : 経過時間を ScriptEngine::FRAME_US 毎の固定ステップで Update() する(-record と -replay では常に固定ステップ)
+    constexpr auto OPTION_RECORD = "-record";
+    constexpr auto OPTION_REPLAY = "-replay";
+    constexpr auto OPTION_PROFILE = "-profile";
+    constexpr auto OPTION_LINE_PROFILE = "-line-profile";
+    constexpr auto OPTION_ALLOC_REPORT = "-alloc-report";
+    constexpr auto OPTION_HUD = "-hud";
+    constexpr auto OPTION_LOG = "-log";
+    constexpr auto OPTION_EXEC_TRACE = "-exec-trace";
+    constexpr auto OPTION_METRICS = "-metrics";
+    constexpr auto OPTION_LATENCY = "-latency";
+    constexpr auto OPTION_MEMORY_REPORT = "-memory-report";
+    constexpr auto OPTION_FULL_REDRAW = "-full-redraw";
+    constexpr auto OPTION_NO_IDLE_WAIT = "-no-idle-wait";
+    constexpr auto OPTION_FIXED_STEP = "-fixed-step";
+
+    struct CommandLine
+    {
+        std::string record_path;
+        std::string replay_path;
+        std::string profile_path;
+        std::string line_profile_path;
+        std::string alloc_report_path;
+        std::string log_path;
+        std::string exec_trace_path;
+        std::string metrics_path;
+        std::string latency_path;
+        std::string memory_report_path;
+        bool is_hud_visible;
+        bool is_full_redraw;
+        bool is_idle_wait;
+        bool is_fixed_step;
+
+        CommandLine()
+        {
+            log_path = LOG_PATH;
+            exec_trace_path = EXEC_TRACE_PATH;
+            is_hud_visible = false;
+            is_full_redraw = false;
+            is_idle_wait = true;
+            is_fixed_step = false;
+        }
+    };
+
+    void ParseCommandLine(const LPSTR command_line, CommandLine& options)
+    {
+        std::istringstream iss(command_line);
+        std::string option;
+
+        while (iss >> option) {
+            if (option == OPTION_RECORD) {
+                iss >> options.record_path;
+            }
+            else if (option == OPTION_REPLAY) {
+                iss >> options.replay_path;
+            }
+            else if (option == OPTION_PROFILE) {
+                iss >> options.profile_path;
+            }
+            else if (option == OPTION_LINE_PROFILE) {
+                iss >> options.line_profile_path;
+            }
+            else if (option == OPTION_ALLOC_REPORT) {
+                iss >> options.alloc_report_path;
+            }
+            else if (option == OPTION_LOG) {
+                iss >> options.log_path;
+            }
+            else if (option == OPTION_EXEC_TRACE) {
+                iss >> options.exec_trace_path;
+            }
+            else if (option == OPTION_METRICS) {
+                iss >> options.metrics_path;
+            }
+            else if (option == OPTION_LATENCY) {
+                iss >> options.latency_path;
+            }
+            else if (option == OPTION_MEMORY_REPORT) {
+                iss >> options.memory_report_path;
+            }
+            else if (option == OPTION_HUD) {
+                options.is_hud_visible = true;
+            }
+            else if (option == OPTION_FULL_REDRAW) {
+                options.is_full_redraw = true;
+            }
+            else if (option == OPTION_NO_IDLE_WAIT) {
+                options.is_idle_wait = false;
+            }
+            else if (option == OPTION_FIXED_STEP) {
+                options.is_fixed_step = true;
+            }
+        }
+    }
+
+    // 入力(ウィンドウメッセージ)が届くか timeout_ms が経過するまでスレッドを止める
+    void WaitForInput(unsigned int timeout_ms)
+    {
+        MsgWaitForMultipleObjectsEx(0, nullptr, timeout_ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    }
+
+    // 描画中(ScreenFlip() など)に呼び出される場合があるので、通知を受けるだけにしてメインループの先頭で処理する
+    void OnGraphicsDeviceRestore(void* data)
+    {
+        *static_cast<bool*>(data) = true;
+    }
+
+    // クラッシュ時に保存する為(例外フィルターには引数を渡せない)
+    const amg::ExecutionTrace* crash_trace = nullptr;
+    std::string crash_trace_path;
+
+    // ヒープが壊れたクラッシュでも保存出来る様に、メモリ確保をする std::ofstream などは使用しない
+    LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* exception_info)
+    {
+        if (crash_trace == nullptr) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        size_t size = 0;
+        const auto* data = crash_trace->SerializeToReserved(size);
+
+        if (data == nullptr) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        const auto file = CreateFileA(crash_trace_path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (file != INVALID_HANDLE_VALUE) {
+            DWORD written = 0;
+
+            WriteFile(file, data, static_cast<DWORD>(size), &written, nullptr);
+            CloseHandle(file);
+        }
+
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
 }
 
 int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nCmdShow)
@@ -38,25 +209,294 @@ int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         return -1; // エラーが起きたら直ちに終了
     }
 
+    CommandLine options;
+
+    ParseCommandLine(lpCmdLine, options);
+
+    // ログを出力出来なくてもゲームは続行する
+    amg::Logger::Initialize(options.log_path);
+
+    if (!options.alloc_report_path.empty() && !amg::AllocTracker::IsEnabled()) {
+        AMG_LOG_WARNING(amg::Logger::NO_LINE, nullptr, "-alloc-report requires a build with AMG_ALLOC_TRACKING");
+    }
+
     amg::ScriptEngine script_engine;
+    amg::InputRecorder input_recorder;
+    amg::InputReplayer input_replayer;
+    std::unique_ptr<amg::FrameProfiler> profiler;
+    amg::ScriptProfiler script_profiler;
+    amg::PerfHud hud;
+    amg::ExecutionTrace execution_trace;
+    amg::MetricsExporter metrics;
+    amg::LatencyTracker latency_tracker;
+    amg::MemoryFootprint memory_footprint;
+
+    // 実行した行の記録は常に有効にしておく
+    script_engine.SetExecutionTrace(&execution_trace);
+    execution_trace.ReserveSaveBuffer();
+    crash_trace = &execution_trace;
+    crash_trace_path = options.exec_trace_path;
+    SetUnhandledExceptionFilter(OnUnhandledException);
+
+    if (!options.record_path.empty()) {
+        script_engine.SetInputRecorder(&input_recorder);
+    }
+
+    const auto is_replay = !options.replay_path.empty() && input_replayer.Load(options.replay_path);
+
+    if (is_replay) {
+        script_engine.SetInputReplayer(&input_replayer);
+    }
+
+    if (!options.latency_path.empty()) {
+        script_engine.SetLatencyTracker(&latency_tracker);
+    }
+
+    // パフォーマンス表示は処理時間の計測結果を使用する
+    if (!options.profile_path.empty() || options.is_hud_visible) {
+        profiler.reset(new amg::FrameProfiler());
+        script_engine.SetProfiler(profiler.get());
+    }
+
+    if (!options.line_profile_path.empty() && script_profiler.Initialize(SCRIPTS_JSON_PATH)) {
+        script_engine.SetListener(&script_profiler);
+    }
+
+    // 計測値を出力出来なくてもゲームは続行する
+    const auto is_metrics = !options.metrics_path.empty() && metrics.Start(options.metrics_path, METRICS_INTERVAL_MS);
+    const auto load_start = std::chrono::steady_clock::now();
 
     if (!script_engine.Initialize(SCRIPTS_JSON_PATH)) {
+        amg::Logger::Destroy();
         return -1;
     }
 
+    if (is_metrics) {
+        metrics.AddLoad(std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+    }
+
+    if (hud.Initialize()) {
+        hud.SetVisible(options.is_hud_visible);
+    }
+
     amg::DxWrapper::SetDrawScreen(amg::DxWrapper::DX_SCREEN_BACK);
 
+    // フルスクリーンでは Alt+Tab などでデバイスロストが起きる
+    auto is_device_restored = false;
+
+    amg::DxWrapper::SetGraphicsDeviceRestoreCallbackFunction(OnGraphicsDeviceRestore, &is_device_restored);
+
+    auto was_window_active = true;
+
+    auto is_save_key = false;
+    auto is_hud_key = false;
+
+    // 記録した入力はフレーム毎なので、記録と再生は固定ステップにして必ず同じ結果にする
+    const auto is_fixed_step = options.is_fixed_step || !options.record_path.empty() || is_replay;
+    amg::EngineClock clock;
+
+    clock.Start(amg::ScriptEngine::FRAME_US);
+
     // アプリのメインループ
     while ((amg::DxWrapper::ProcessMessage() != -1) && !script_engine.IsExit()) {
-        script_engine.Update();
+        auto* const frame_profiler = profiler.get();
+
+        if (is_device_restored) {
+            script_engine.OnDeviceRestore();
+            is_device_restored = false;
+        }
+
+        // 非アクティブや最小化の間に画面の内容が失われている場合があるので戻ったら全て描画し直す
+        const auto is_window_active = (amg::DxWrapper::GetWindowActiveFlag() != 0) && (amg::DxWrapper::GetWindowMinSizeFlag() == 0);
+
+        if (is_window_active && !was_window_active) {
+            script_engine.ForceRedraw();
+        }
+
+        was_window_active = is_window_active;
+
+        if (frame_profiler != nullptr) {
+            frame_profiler->BeginFrame();
+        }
 
-        amg::DxWrapper::ClearDrawScreen();
-        script_engine.Render();
-        amg::DxWrapper::ScreenFlip();
+        {
+            amg::FrameProfiler::Scope scope(frame_profiler, amg::FrameProfiler::Phase::UPDATE);
+
+            // 待ち時間と文字列の表示はリフレッシュレートに関係なく実時間で進める
+            const auto steps = clock.Advance();
+
+            if (is_fixed_step) {
+                for (auto i = 0U; i < steps && !script_engine.IsExit(); ++i) {
+                    script_engine.Update();
+                }
+            }
+            else {
+                script_engine.Update(clock.GetDeltaUs());
+            }
+        }
+
+        // 描画内容が変化していなければ前のフレームの画面をそのまま表示しておく
+        // (パフォーマンス表示は毎フレーム変化する)
+        const auto is_redraw = options.is_full_redraw || hud.IsVisible() || script_engine.IsRedrawNeeded();
+        auto draw_calls = 0U;
+
+        if (is_redraw) {
+            {
+                amg::FrameProfiler::Scope scope(frame_profiler, amg::FrameProfiler::Phase::CLEAR);
+
+                amg::DxWrapper::ClearDrawScreen();
+            }
+
+            {
+                amg::FrameProfiler::Scope scope(frame_profiler, amg::FrameProfiler::Phase::RENDER);
+
+                script_engine.Render();
+            }
+
+            // パフォーマンス表示自身の描画は含めない
+            draw_calls = amg::DxWrapper::GetDrawCallCount();
+
+            hud.Render();
+
+            {
+                amg::FrameProfiler::Scope scope(frame_profiler, amg::FrameProfiler::Phase::FLIP);
+
+                amg::DxWrapper::ScreenFlip();
+            }
+        }
+        else {
+            amg::FrameProfiler::Scope scope(frame_profiler, amg::FrameProfiler::Phase::FLIP);
+
+            // ScreenFlip() と同じく垂直同期を待ってフレームの間隔を保つ
+            amg::DxWrapper::WaitVSync(1);
+        }
+
+        if (!options.latency_path.empty()) {
+            latency_tracker.OnPresent(is_redraw);
+        }
+
+        if (frame_profiler != nullptr) {
+            frame_profiler->EndFrame();
+        }
+
+        amg::AllocTracker::EndFrame();
+
+        if (is_metrics) {
+            metrics.Update(script_engine);
+        }
+
+        if (!options.memory_report_path.empty()) {
+            memory_footprint.Update(script_engine);
+        }
+
+        if (frame_profiler != nullptr) {
+            hud.Update(script_engine, *frame_profiler, draw_calls);
+        }
+
+        // 押された瞬間のみ切り替える
+        const auto is_toggle_key = amg::DxWrapper::CheckHitKey(amg::DxWrapper::KEY_INPUT_F11) != 0;
+
+        if (is_toggle_key && !is_hud_key) {
+            hud.Toggle();
+
+            // 計測していなければ表示を始めた時から計測する
+            if (profiler == nullptr) {
+                profiler.reset(new amg::FrameProfiler());
+                script_engine.SetProfiler(profiler.get());
+            }
+        }
+
+        is_hud_key = is_toggle_key;
+
+        // 押された瞬間のみ保存する
+        const auto is_key = amg::DxWrapper::CheckHitKey(amg::DxWrapper::KEY_INPUT_F12) != 0;
+
+        if (is_key && !is_save_key) {
+            if (frame_profiler != nullptr && !options.profile_path.empty()) {
+                frame_profiler->SaveTrace(options.profile_path);
+            }
+
+            if (!options.alloc_report_path.empty()) {
+                amg::AllocTracker::SaveReport(options.alloc_report_path);
+            }
+
+            if (!options.latency_path.empty()) {
+                latency_tracker.SaveReport(options.latency_path);
+            }
+
+            if (!options.memory_report_path.empty()) {
+                memory_footprint.SaveReport(options.memory_report_path);
+            }
+
+            execution_trace.Save(options.exec_trace_path);
+        }
+
+        is_save_key = is_key;
+
+        // 次に Update() が必要になるまで(入力が届くか時間待ちが終わるまで)スレッドを止める
+        // (パフォーマンス表示は毎フレーム変化し、再生中は入力が届かないので止めない)
+        const auto is_replaying = is_replay && !input_replayer.IsFinished();
+
+        if (options.is_idle_wait && !options.is_full_redraw && !hud.IsVisible() && !is_replaying) {
+            auto wait_us = 0ULL;
+
+            switch (script_engine.GetWakeUp(wait_us)) {
+            case amg::ScriptEngine::WakeUp::IMMEDIATE:
+                break;
+
+            case amg::ScriptEngine::WakeUp::TIME: {
+                // 止まっていた時間は次のループの EngineClock::Advance() で Update() に渡るので
+                // 時間待ちの長さと記録した入力のフレーム番号は変わらない
+                const auto wait_ms = (wait_us < IDLE_WAIT_MAX_MS * 1000ULL) ? static_cast<unsigned int>(wait_us / 1000ULL) : IDLE_WAIT_MAX_MS;
+
+                if (wait_ms > 0U) {
+                    WaitForInput(wait_ms);
+                }
+                break;
+            }
+
+            case amg::ScriptEngine::WakeUp::INPUT:
+                WaitForInput(IDLE_WAIT_MAX_MS);
+                break;
+            }
+        }
+    }
+
+    // 解放されずに残っているサイズを確認する為に破棄する前に保存する
+    if (!options.alloc_report_path.empty()) {
+        amg::AllocTracker::SaveReport(options.alloc_report_path);
+    }
+
+    if (!options.memory_report_path.empty()) {
+        memory_footprint.SaveReport(options.memory_report_path);
     }
 
+    hud.Destroy();
+
     script_engine.Destroy();
 
+    if (profiler != nullptr && !options.profile_path.empty()) {
+        profiler->SaveTrace(options.profile_path);
+    }
+
+    if (!options.line_profile_path.empty()) {
+        script_profiler.SaveReport(options.line_profile_path);
+    }
+
+    if (!options.latency_path.empty()) {
+        latency_tracker.SaveReport(options.latency_path);
+    }
+
+    if (!options.record_path.empty()) {
+        input_recorder.Save(options.record_path);
+    }
+
+    amg::Logger::Destroy();
+
+    metrics.Stop();
+
+    crash_trace = nullptr;
+
     amg::DxWrapper::DxLib_End();
 
     return 0;
@@ -0,0 +1,559 @@
+﻿//!
+//! @file branch_explorer.cpp
+//!
+//! @brief スクリプトの全ての分岐を探索するクラス実装
+//!
+//! @details
+//! スクリプトを選択待ちで区切った区間を 1 つの状態として扱います。
+//! 選択肢を選んだ直後はメッセージと選択肢が消えるので
+//! 状態は「再開する行」と「表示中の画像('d' コマンドの行)」だけで決まり
+//! 同じ状態に合流した経路は 1 度だけ探索します。
+//!
+//! 区間の探索はワーカー毎の ScriptEngine で行い
+//! 探索で見つかった新しい状態は WorkStealingPool のタスクとして追加します。
+//! 全ての状態を探索した後に、状態のグラフから経路毎の統計を計算します。
+//! 探索中の祖先の状態に戻る選択肢('j, Start' でタイトルに戻るなど)は
+//! そこで終わる 1 つの経路として数えます。
+//!
+#include "branch_explorer.h"
+#include "work_stealing_pool.h"
+#include "script_engine.h"
+#include "script_engine_probe.h"
+#include "script_listener.h"
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <deque>
+
+namespace {
+    constexpr auto SHARD_NUM = 64U;
+    constexpr auto DEFAULT_MAX_STATES = 1000000U;
+
+    // 区間で処理する行数の上限(既定値は総行数の倍数)
+    constexpr auto SEGMENT_LIMIT_RATE = 4U;
+
+    constexpr auto COMMAND_J = _T('j');
+    constexpr auto COMMAND_C = _T('c');
+
+    constexpr unsigned char WHITE = 0;
+    constexpr unsigned char GRAY = 1;
+    constexpr unsigned char BLACK = 2;
+
+    using Clock = std::chrono::steady_clock;
+    using EndType = amg::BranchExplorer::EndType;
+
+    //!
+    //! @brief 選択待ちで区切った区間(探索の状態)
+    //!
+    struct Node
+    {
+        unsigned int index;
+        unsigned int line;
+        std::vector<unsigned int> draw_lines;
+        EndType end_type;
+        unsigned int end_line;
+        unsigned long long lines;
+        unsigned long long clicks;
+        unsigned long long wait_frames;
+        std::vector<Node*> children;
+
+        Node()
+        {
+            index = 0;
+            line = 0;
+            end_type = EndType::CHOICE;
+            end_line = 0;
+            lines = 0;
+            clicks = 0;
+            wait_frames = 0;
+        }
+    };
+
+    unsigned long long Hash(const unsigned int line, const std::vector<unsigned int>& draw_lines)
+    {
+        // FNV-1a
+        auto hash = 14695981039346656037ULL;
+        const auto update = [&hash](const unsigned int value) {
+            hash = (hash ^ value) * 1099511628211ULL;
+        };
+
+        update(line);
+
+        for (auto&& draw_line : draw_lines) {
+            update(draw_line);
+        }
+
+        return hash;
+    }
+
+    //!
+    //! @brief 探索済みの状態を管理するテーブル
+    //! @details 複数のワーカーから同時に使用するのでハッシュ値で分割してロックします。
+    //!
+    class NodeTable
+    {
+    public:
+        explicit NodeTable(const unsigned int max_states)
+        {
+            this->max_states = max_states;
+            node_num = 0;
+            is_truncated = false;
+        }
+
+        Node* Insert(const unsigned int line, const std::vector<unsigned int>& draw_lines, bool& is_new)
+        {
+            const auto hash = Hash(line, draw_lines);
+            auto& shard = shards[hash % SHARD_NUM];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            const auto range = shard.map.equal_range(hash);
+
+            is_new = false;
+
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second->line == line && it->second->draw_lines == draw_lines) {
+                    return it->second;
+                }
+            }
+
+            const auto index = node_num++;
+
+            if (index >= max_states) {
+                --node_num;
+                is_truncated = true;
+                return nullptr;
+            }
+
+            shard.nodes.emplace_back();
+
+            auto node = &shard.nodes.back();
+
+            node->index = index;
+            node->line = line;
+            node->draw_lines = draw_lines;
+            shard.map.emplace(hash, node);
+            is_new = true;
+
+            return node;
+        }
+
+        std::vector<Node*> GetNodes()
+        {
+            std::vector<Node*> nodes(node_num);
+
+            for (auto&& shard : shards) {
+                for (auto&& node : shard.nodes) {
+                    nodes[node.index] = &node;
+                }
+            }
+
+            return nodes;
+        }
+
+        inline bool IsTruncated() const { return is_truncated; }
+
+    private:
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_multimap<unsigned long long, Node*> map;
+            std::deque<Node> nodes;
+        };
+
+        Shard shards[SHARD_NUM];
+        std::atomic<unsigned int> node_num;
+        std::atomic<bool> is_truncated;
+        unsigned int max_states;
+    };
+
+    //!
+    //! @brief ワーカー毎のスクリプトエンジンと処理した行の記録
+    //!
+    class Worker final : public amg::ScriptListener
+    {
+    public:
+        Worker()
+        {
+            count = 0;
+        }
+
+        void OnParse(unsigned int line, TCHAR command) override
+        {
+            coverage[line] = 1;
+            ++count;
+        }
+
+        amg::ScriptEngine engine;
+        std::vector<unsigned char> coverage;
+        unsigned long long count;
+    };
+
+    //!
+    //! @brief 経路毎の値の最小値、最大値、合計
+    //!
+    struct Range
+    {
+        unsigned long long min;
+        unsigned long long max;
+        double sum;
+
+        Range()
+        {
+            min = 0;
+            max = 0;
+            sum = 0.0;
+        }
+
+        void Merge(const Range& other, const bool is_first)
+        {
+            min = is_first ? other.min : std::min(min, other.min);
+            max = is_first ? other.max : std::max(max, other.max);
+            sum += other.sum;
+        }
+
+        void Add(const unsigned long long value, const double routes)
+        {
+            min += value;
+            max += value;
+            sum += value * routes;
+        }
+
+        amg::BranchExplorer::RouteStatistics ToStatistics(const double routes) const
+        {
+            amg::BranchExplorer::RouteStatistics statistics;
+
+            statistics.min = min;
+            statistics.max = max;
+            statistics.mean = (routes > 0.0) ? sum / routes : 0.0;
+
+            return statistics;
+        }
+    };
+
+    //!
+    //! @brief ある状態から終端までの全経路の集計
+    //!
+    struct Aggregate
+    {
+        double routes;
+        double end_routes;
+        double cycle_routes;
+        unsigned int depth;
+        Range lines;
+        Range clicks;
+        Range wait_frames;
+
+        Aggregate()
+        {
+            routes = 0.0;
+            end_routes = 0.0;
+            cycle_routes = 0.0;
+            depth = 0;
+        }
+    };
+
+    //!
+    //! @brief 状態から次の選択待ち(又は終端)まで入力無しで処理する
+    //!
+    void ExploreSegment(Worker& worker, Node& node, const unsigned long long limit)
+    {
+        auto& engine = worker.engine;
+
+        amg::ScriptEngineProbe::Restore(engine, node.line, node.draw_lines);
+        worker.count = 0;
+
+        while (true) {
+            amg::ScriptEngineProbe::Parsing(engine);
+
+            const auto state = engine.GetState();
+
+            if (state == amg::ScriptEngine::ScriptState::END) {
+                node.end_type = EndType::END;
+                node.end_line = engine.GetNowLine() - 1;
+                break;
+            }
+
+            if (state == amg::ScriptEngine::ScriptState::CHOICE_WAIT) {
+                node.end_type = EndType::CHOICE;
+                node.end_line = engine.GetNowLine() - 1;
+                break;
+            }
+
+            if (engine.IsEnd()) {
+                node.end_type = EndType::FALL_OFF;
+                node.end_line = engine.GetMaxLine();
+                break;
+            }
+
+            if (worker.count > limit) {
+                node.end_type = EndType::LOOP;
+                node.end_line = engine.GetNowLine();
+                break;
+            }
+
+            if (state == amg::ScriptEngine::ScriptState::CLICK_WAIT) {
+                ++node.clicks;
+            }
+            else if (state == amg::ScriptEngine::ScriptState::TIME_WAIT) {
+                node.wait_frames += amg::ScriptEngineProbe::GetWaitCount(engine);
+            }
+
+            amg::ScriptEngineProbe::SkipWait(engine, 0);
+        }
+
+        node.lines = worker.count;
+    }
+
+    void Accumulate(const Node& node, const std::vector<unsigned char>& color, std::vector<Aggregate>& aggregates)
+    {
+        auto& aggregate = aggregates[node.index];
+
+        if (node.end_type != EndType::CHOICE) {
+            aggregate.routes = 1.0;
+            aggregate.end_routes = (node.end_type == EndType::END) ? 1.0 : 0.0;
+        }
+        else {
+            for (auto&& child : node.children) {
+                const auto is_first = (aggregate.routes <= 0.0);
+
+                // 探索中(祖先)への移動は最初からやり直す経路なので、そこで 1 経路とする
+                if (color[child->index] == GRAY) {
+                    const Range zero;
+
+                    aggregate.lines.Merge(zero, is_first);
+                    aggregate.clicks.Merge(zero, is_first);
+                    aggregate.wait_frames.Merge(zero, is_first);
+                    aggregate.routes += 1.0;
+                    aggregate.cycle_routes += 1.0;
+                    continue;
+                }
+
+                const auto& child_aggregate = aggregates[child->index];
+
+                if (child_aggregate.routes <= 0.0) {
+                    continue;
+                }
+
+                aggregate.lines.Merge(child_aggregate.lines, is_first);
+                aggregate.clicks.Merge(child_aggregate.clicks, is_first);
+                aggregate.wait_frames.Merge(child_aggregate.wait_frames, is_first);
+                aggregate.routes += child_aggregate.routes;
+                aggregate.end_routes += child_aggregate.end_routes;
+                aggregate.cycle_routes += child_aggregate.cycle_routes;
+                aggregate.depth = std::max(aggregate.depth, child_aggregate.depth + 1);
+            }
+        }
+
+        aggregate.lines.Add(node.lines, aggregate.routes);
+        aggregate.clicks.Add(node.clicks, aggregate.routes);
+        aggregate.wait_frames.Add(node.wait_frames, aggregate.routes);
+    }
+}
+
+namespace amg
+{
+    BranchExplorer::BranchExplorer()
+    {
+        worker_num = 1;
+        max_states = DEFAULT_MAX_STATES;
+        segment_limit = 0;
+    }
+
+    //!
+    //! @fn bool BranchExplorer::Explore(const TCHAR* path, Result& result) const
+    //! @brief スクリプトの全ての分岐を探索する
+    //! @param[in] path パス付のスクリプト用 Json ファイル名
+    //! @param[out] result 探索結果
+    //! @return 処理の成否(スクリプトの初期化に失敗した場合は false)
+    //! @details DxWrapper はヘッドレス用の実装をリンクしておく必要があります。
+    //!
+    bool BranchExplorer::Explore(const TCHAR* path, Result& result) const
+    {
+        const auto start = Clock::now();
+
+        result = Result();
+
+        WorkStealingPool pool(worker_num);
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        // DxWrapper を使用する初期化は 1 スレッドで行う
+        for (auto i = 0U; i < pool.GetWorkerNum(); ++i) {
+            std::unique_ptr<Worker> worker(new Worker());
+
+            if (!worker->engine.Initialize(path)) {
+                return false;
+            }
+
+            workers.emplace_back(std::move(worker));
+        }
+
+        const auto explore_start = Clock::now();
+        const auto max_line = workers[0]->engine.GetMaxLine();
+        const auto limit = (segment_limit > 0) ? segment_limit : max_line * SEGMENT_LIMIT_RATE;
+
+        for (auto&& worker : workers) {
+            worker->coverage.assign(max_line, 0);
+            worker->engine.SetListener(worker.get());
+            worker->engine.SetParsingLimit(limit);
+        }
+
+        NodeTable table((max_states > 0) ? max_states : DEFAULT_MAX_STATES);
+        std::atomic<unsigned long long> merged(0);
+        auto is_new = false;
+        auto root = table.Insert(0, std::vector<unsigned int>(), is_new);
+
+        std::function<void(unsigned int, Node*)> explore = [&](unsigned int index, Node* node) {
+            auto& worker = *workers[index];
+
+            ExploreSegment(worker, *node, limit);
+
+            if (node->end_type != EndType::CHOICE) {
+                return;
+            }
+
+            std::vector<unsigned int> choice_lines;
+            std::vector<unsigned int> draw_lines;
+
+            ScriptEngineProbe::GetChoiceLines(worker.engine, choice_lines);
+            ScriptEngineProbe::GetDrawLines(worker.engine, draw_lines);
+
+            for (auto&& choice_line : choice_lines) {
+                auto is_new_child = false;
+                auto child = table.Insert(choice_line, draw_lines, is_new_child);
+
+                if (child == nullptr) {
+                    continue;
+                }
+
+                node->children.emplace_back(child);
+
+                if (is_new_child) {
+                    pool.Submit(index, [&explore, child](unsigned int worker_index) { explore(worker_index, child); });
+                }
+                else {
+                    ++merged;
+                }
+            }
+        };
+
+        pool.Submit(0, [&explore, root](unsigned int worker_index) { explore(worker_index, root); });
+        pool.Run();
+
+        // 深さ優先で辿り、終端から経路の集計を積み上げる
+        const auto nodes = table.GetNodes();
+        std::vector<unsigned char> color(nodes.size(), WHITE);
+        std::vector<Aggregate> aggregates(nodes.size());
+        std::vector<const Node*> parents(nodes.size(), nullptr);
+        std::vector<unsigned int> parent_choices(nodes.size(), 0);
+        std::vector<std::pair<const Node*, size_t>> stack;
+
+        stack.emplace_back(root, 0);
+        color[root->index] = GRAY;
+
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            const auto node = top.first;
+
+            if (top.second < node->children.size()) {
+                const auto choice = static_cast<unsigned int>(top.second++);
+                const auto child = node->children[choice];
+
+                if (color[child->index] == GRAY) {
+                    ++result.cycles;
+                }
+                else if (color[child->index] == WHITE) {
+                    color[child->index] = GRAY;
+                    parents[child->index] = node;
+                    parent_choices[child->index] = choice;
+                    stack.emplace_back(child, 0);
+                }
+
+                continue;
+            }
+
+            Accumulate(*node, color, aggregates);
+            color[node->index] = BLACK;
+            stack.pop_back();
+        }
+
+        for (auto&& node : nodes) {
+            if (node->end_type != EndType::FALL_OFF && node->end_type != EndType::LOOP) {
+                continue;
+            }
+
+            DeadEnd dead_end;
+
+            dead_end.type = node->end_type;
+            dead_end.line = node->end_line;
+
+            for (const Node* child = node; parents[child->index] != nullptr; child = parents[child->index]) {
+                dead_end.choices.emplace_back(parent_choices[child->index]);
+            }
+
+            std::reverse(dead_end.choices.begin(), dead_end.choices.end());
+            result.dead_ends.emplace_back(std::move(dead_end));
+        }
+
+        std::sort(result.dead_ends.begin(), result.dead_ends.end(), [](const DeadEnd& lh, const DeadEnd& rh) {
+            return (lh.line != rh.line) ? lh.line < rh.line : lh.choices < rh.choices;
+        });
+
+        std::vector<unsigned char> coverage(max_line, 0);
+
+        for (auto&& worker : workers) {
+            for (auto i = 0U; i < max_line; ++i) {
+                coverage[i] |= worker->coverage[i];
+            }
+        }
+
+        for (auto i = 0U; i < max_line; ++i) {
+            if (coverage[i] == 0) {
+                result.unreachable_lines.emplace_back(i);
+            }
+        }
+
+        // 存在しないラベルへの移動と選択肢
+        const auto& engine = workers[0]->engine;
+
+        for (auto i = 0U; i < max_line; ++i) {
+            const auto script = ScriptEngineProbe::GetScript(engine, i);
+            auto line = 0U;
+
+            if (script.size() < 2 || script[0].empty() || (script[0][0] != COMMAND_J && script[0][0] != COMMAND_C)) {
+                continue;
+            }
+
+            if (!ScriptEngineProbe::GetLineNumber(engine, script[1], line)) {
+                Dangling dangling;
+
+                dangling.line = i;
+                dangling.label = script[1];
+                dangling.is_reached = (coverage[i] != 0);
+                result.danglings.emplace_back(std::move(dangling));
+            }
+        }
+
+        const auto& aggregate = aggregates[root->index];
+
+        result.states = static_cast<unsigned int>(nodes.size());
+        result.merged = merged;
+        result.routes = aggregate.routes;
+        result.end_routes = aggregate.end_routes;
+        result.cycle_routes = aggregate.cycle_routes;
+        result.dead_end_routes = aggregate.routes - aggregate.end_routes - aggregate.cycle_routes;
+        result.max_choice_depth = aggregate.depth;
+        result.lines = aggregate.lines.ToStatistics(aggregate.routes);
+        result.clicks = aggregate.clicks.ToStatistics(aggregate.routes);
+        result.wait_frames = aggregate.wait_frames.ToStatistics(aggregate.routes);
+        result.max_line = max_line;
+        result.workers = pool.GetWorkerNum();
+        result.steals = pool.GetStealNum();
+        result.is_truncated = table.IsTruncated();
+        result.initialize_ms = std::chrono::duration<double, std::milli>(explore_start - start).count();
+        result.explore_ms = std::chrono::duration<double, std::milli>(Clock::now() - explore_start).count();
+
+        return true;
+    }
+}
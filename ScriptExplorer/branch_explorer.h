@@ -0,0 +1,126 @@
+﻿//!
+//! @file branch_explorer.h
+//!
+//! @brief スクリプトの全ての分岐を探索するクラス定義
+//!
+#pragma once
+
+#include <tchar.h>
+#include <vector>
+#include <string>
+
+namespace amg
+{
+    class BranchExplorer
+    {
+    public:
+        enum class EndType {
+            CHOICE,     // 選択待ち(分岐する)
+            END,        // 'e' コマンドで終了
+            FALL_OFF,   // 'e' コマンドが無いまま最終行を超えた
+            LOOP        // 選択待ちの無いループ
+        };
+
+        struct DeadEnd
+        {
+            EndType type;
+            unsigned int line;
+            std::vector<unsigned int> choices;
+
+            DeadEnd()
+            {
+                type = EndType::FALL_OFF;
+                line = 0;
+            }
+        };
+
+        struct Dangling
+        {
+            unsigned int line;
+            std::string label;
+            bool is_reached;
+
+            Dangling()
+            {
+                line = 0;
+                is_reached = false;
+            }
+        };
+
+        struct RouteStatistics
+        {
+            unsigned long long min;
+            unsigned long long max;
+            double mean;
+
+            RouteStatistics()
+            {
+                min = 0;
+                max = 0;
+                mean = 0.0;
+            }
+        };
+
+        struct Result
+        {
+            unsigned int states;
+            unsigned long long merged;
+            unsigned int cycles;
+            double routes;
+            double end_routes;
+            double cycle_routes;
+            double dead_end_routes;
+            unsigned int max_choice_depth;
+            RouteStatistics lines;
+            RouteStatistics clicks;
+            RouteStatistics wait_frames;
+            std::vector<DeadEnd> dead_ends;
+            std::vector<Dangling> danglings;
+            std::vector<unsigned int> unreachable_lines;
+            unsigned int max_line;
+            unsigned int workers;
+            unsigned long long steals;
+            bool is_truncated;
+            double initialize_ms;
+            double explore_ms;
+
+            Result()
+            {
+                states = 0;
+                merged = 0;
+                cycles = 0;
+                routes = 0.0;
+                end_routes = 0.0;
+                cycle_routes = 0.0;
+                dead_end_routes = 0.0;
+                max_choice_depth = 0;
+                max_line = 0;
+                workers = 0;
+                steals = 0;
+                is_truncated = false;
+                initialize_ms = 0.0;
+                explore_ms = 0.0;
+            }
+        };
+
+        BranchExplorer();
+        BranchExplorer(const BranchExplorer&) = default;
+        BranchExplorer(BranchExplorer&&) noexcept = default;
+
+        virtual ~BranchExplorer() = default;
+
+        BranchExplorer& operator=(const BranchExplorer& right) = default;
+        BranchExplorer& operator=(BranchExplorer&& right) noexcept = default;
+
+        inline void SetWorkerNum(const unsigned int worker_num) { this->worker_num = worker_num; }
+        inline void SetMaxStates(const unsigned int max_states) { this->max_states = max_states; }
+        inline void SetSegmentLimit(const unsigned int segment_limit) { this->segment_limit = segment_limit; }
+
+        bool Explore(const TCHAR* path, Result& result) const;
+
+    private:
+        unsigned int worker_num;
+        unsigned int max_states;
+        unsigned int segment_limit;
+    };
+}
@@ -0,0 +1,231 @@
+﻿//!
+//! @file explorer_main.cpp
+//!
+//! @brief 分岐探索ツールのエントリーポイント
+//!
+//! @details
+//! 使い方: ScriptExplorer スクリプト.json [オプション]
+//!
+//! --threads 数        探索するスレッド数(既定値は論理コア数)
+//! --max-states 数     探索する状態数の上限
+//! --segment-limit 数  選択待ちまでに処理する行数の上限(超えたらループと判定する)
+//! --max-report 数     出力する行き止まりと未到達の行の数の上限
+//! --no-file-check     画像ファイルの存在を確認しない(自動生成したスクリプト用)
+//!
+//! 行き止まりの経路('e' コマンドに到達しない経路)や
+//! 到達する存在しないラベルへの移動が無ければ 0 を、それ以外は 1 を返します。
+//!
+#include "branch_explorer.h"
+#include "dx_wrapper.h"
+#include "dx_headless.h"
+#include "amg_string.h"
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+    constexpr auto DEFAULT_MAX_REPORT = 20;
+
+    struct Options
+    {
+        std::string scripts_path;
+        int threads;
+        int max_states;
+        int segment_limit;
+        int max_report;
+        bool is_file_check;
+
+        Options()
+        {
+            threads = 0;
+            max_states = 0;
+            segment_limit = 0;
+            max_report = DEFAULT_MAX_REPORT;
+            is_file_check = true;
+        }
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: ScriptExplorer <scripts.json> [--threads n] [--max-states n] [--segment-limit n] [--max-report n]"
+            << " [--no-file-check]"
+            << std::endl;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (auto i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            const auto has_value = (i + 1) < argc;
+
+            if (arg == "--threads" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.threads)) {
+                    return false;
+                }
+            }
+            else if (arg == "--max-states" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.max_states)) {
+                    return false;
+                }
+            }
+            else if (arg == "--segment-limit" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.segment_limit)) {
+                    return false;
+                }
+            }
+            else if (arg == "--max-report" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.max_report)) {
+                    return false;
+                }
+            }
+            else if (arg == "--no-file-check") {
+                options.is_file_check = false;
+            }
+            else if (options.scripts_path.empty() && arg[0] != '-') {
+                options.scripts_path = arg;
+            }
+            else {
+                return false;
+            }
+        }
+
+        return !options.scripts_path.empty() && options.threads >= 0 && options.max_states >= 0 &&
+            options.segment_limit >= 0 && options.max_report >= 0;
+    }
+
+    std::string GetDirectory(const std::string& path)
+    {
+        const auto position = path.find_last_of("/\\");
+
+        if (position == std::string::npos) {
+            return "";
+        }
+
+        return path.substr(0, position);
+    }
+
+    const char* ToString(const amg::BranchExplorer::EndType type)
+    {
+        switch (type) {
+        case amg::BranchExplorer::EndType::CHOICE: return "CHOICE";
+        case amg::BranchExplorer::EndType::END: return "END";
+        case amg::BranchExplorer::EndType::FALL_OFF: return "FALL_OFF";
+        case amg::BranchExplorer::EndType::LOOP: return "LOOP";
+        }
+
+        return "UNKNOWN";
+    }
+
+    void PrintStatistics(const char* name, const amg::BranchExplorer::RouteStatistics& statistics)
+    {
+        std::cout << name << ": min=" << statistics.min << " mean=" << statistics.mean
+            << " max=" << statistics.max << std::endl;
+    }
+
+    void PrintResult(const amg::BranchExplorer::Result& result, const unsigned int max_report)
+    {
+        std::cout << "workers: " << result.workers << std::endl;
+        std::cout << "states: " << result.states << std::endl;
+        std::cout << "merged: " << result.merged << std::endl;
+        std::cout << "steals: " << result.steals << std::endl;
+        std::cout << "truncated: " << (result.is_truncated ? "yes" : "no") << std::endl;
+        std::cout << "routes: " << result.routes << std::endl;
+        std::cout << "end_routes: " << result.end_routes << std::endl;
+        std::cout << "cycle_routes: " << result.cycle_routes << std::endl;
+        std::cout << "dead_end_routes: " << result.dead_end_routes << std::endl;
+        std::cout << "cycles: " << result.cycles << std::endl;
+        std::cout << "max_choice_depth: " << result.max_choice_depth << std::endl;
+
+        if (result.routes > 0.0) {
+            PrintStatistics("route_lines", result.lines);
+            PrintStatistics("route_clicks", result.clicks);
+            PrintStatistics("route_wait_frames", result.wait_frames);
+        }
+
+        auto count = 0U;
+
+        for (auto&& dead_end : result.dead_ends) {
+            if (count++ >= max_report) {
+                break;
+            }
+
+            std::cout << "dead_end: " << ToString(dead_end.type) << " line=" << dead_end.line << " choices=";
+
+            for (size_t i = 0; i < dead_end.choices.size(); ++i) {
+                std::cout << ((i > 0) ? "," : "") << dead_end.choices[i];
+            }
+
+            std::cout << std::endl;
+        }
+
+        for (auto&& dangling : result.danglings) {
+            std::cout << "dangling: line=" << dangling.line << " label=" << dangling.label
+                << " reached=" << (dangling.is_reached ? "yes" : "no") << std::endl;
+        }
+
+        // 連続する行はまとめて出力する
+        const auto& lines = result.unreachable_lines;
+
+        std::cout << "unreachable_lines: " << lines.size() << std::endl;
+        count = 0;
+
+        for (size_t i = 0; i < lines.size() && count < max_report; ++count) {
+            auto last = i;
+
+            while (last + 1 < lines.size() && lines[last + 1] == lines[last] + 1) {
+                ++last;
+            }
+
+            std::cout << "unreachable: " << lines[i];
+
+            if (last > i) {
+                std::cout << "-" << lines[last];
+            }
+
+            std::cout << std::endl;
+            i = last + 1;
+        }
+
+        std::cout << "initialize_ms: " << result.initialize_ms << std::endl;
+        std::cout << "explore_ms: " << result.explore_ms << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // スクリプト内の画像パスは Json ファイルからの相対パス
+    amg::DxHeadless::Reset();
+    amg::DxHeadless::SetBaseDirectory(GetDirectory(options.scripts_path));
+    amg::DxHeadless::SetFileCheck(options.is_file_check);
+    amg::DxWrapper::SetGraphMode(1280, 720, 32);
+
+    const auto threads = (options.threads > 0) ? static_cast<unsigned int>(options.threads) : std::thread::hardware_concurrency();
+    amg::BranchExplorer explorer;
+    amg::BranchExplorer::Result result;
+
+    explorer.SetWorkerNum((threads > 0) ? threads : 1);
+    explorer.SetMaxStates(static_cast<unsigned int>(options.max_states));
+    explorer.SetSegmentLimit(static_cast<unsigned int>(options.segment_limit));
+
+    if (!explorer.Explore(options.scripts_path.c_str(), result)) {
+        std::cerr << "initialize error: " << options.scripts_path << std::endl;
+        return 1;
+    }
+
+    PrintResult(result, static_cast<unsigned int>(options.max_report));
+
+    auto is_dangling_reached = false;
+
+    for (auto&& dangling : result.danglings) {
+        is_dangling_reached |= dangling.is_reached;
+    }
+
+    return (result.dead_end_routes > 0.0 || is_dangling_reached || result.is_truncated) ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+﻿//!
+//! @file work_stealing_pool.cpp
+//!
+//! @brief ワークスティーリング方式のスレッドプールクラス実装
+//!
+//! @details
+//! ワーカー毎にタスクのキューを持ち、自分のキューは後ろから(深さ優先)
+//! 他のワーカーのキューは前から(根に近い大きな仕事を)取り出します。
+//! タスクの中から Submit() したタスクも同じ Run() の中で処理され
+//! 全てのタスクが終わると Run() から戻ります。
+//!
+#include "work_stealing_pool.h"
+#include <thread>
+
+namespace amg
+{
+    WorkStealingPool::WorkStealingPool(unsigned int worker_num)
+    {
+        if (worker_num == 0) {
+            worker_num = 1;
+        }
+
+        for (auto i = 0U; i < worker_num; ++i) {
+            queues.emplace_back(new Queue());
+        }
+
+        pending_num = 0;
+        steal_num = 0;
+    }
+
+    //!
+    //! @fn void WorkStealingPool::Submit(unsigned int worker, Task task)
+    //! @brief タスクを追加する
+    //! @param[in] worker 追加するキューのワーカー番号(タスク内からは自分の番号)
+    //! @param[in] task タスク(引数は処理するワーカーの番号)
+    //!
+    void WorkStealingPool::Submit(unsigned int worker, Task task)
+    {
+        auto& queue = *queues[worker % queues.size()];
+
+        // 処理中のタスクが終わる前に数えるので、子タスクが有る間は 0 にならない
+        ++pending_num;
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        queue.tasks.emplace_back(std::move(task));
+    }
+
+    //!
+    //! @fn void WorkStealingPool::Run()
+    //! @brief 全てのタスクが終わるまで処理する
+    //! @details 呼び出したスレッドもワーカー 0 として処理します。
+    //!
+    void WorkStealingPool::Run()
+    {
+        std::vector<std::thread> threads;
+
+        for (auto i = 1U; i < queues.size(); ++i) {
+            threads.emplace_back(&WorkStealingPool::Work, this, i);
+        }
+
+        Work(0);
+
+        for (auto&& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void WorkStealingPool::Work(unsigned int worker)
+    {
+        Task task;
+
+        while (pending_num > 0) {
+            if (Pop(worker, task) || Steal(worker, task)) {
+                task(worker);
+                task = nullptr;
+                --pending_num;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool WorkStealingPool::Pop(unsigned int worker, Task& task)
+    {
+        auto& queue = *queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty()) {
+            return false;
+        }
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+
+        return true;
+    }
+
+    bool WorkStealingPool::Steal(unsigned int worker, Task& task)
+    {
+        const auto size = static_cast<unsigned int>(queues.size());
+
+        for (auto i = 1U; i < size; ++i) {
+            auto& queue = *queues[(worker + i) % size];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (queue.tasks.empty()) {
+                continue;
+            }
+
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            ++steal_num;
+
+            return true;
+        }
+
+        return false;
+    }
+}
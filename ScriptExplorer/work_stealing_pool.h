@@ -0,0 +1,52 @@
+﻿//!
+//! @file work_stealing_pool.h
+//!
+//! @brief ワークスティーリング方式のスレッドプールクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+namespace amg
+{
+    class WorkStealingPool
+    {
+    public:
+        using Task = std::function<void(unsigned int worker)>;
+
+        explicit WorkStealingPool(unsigned int worker_num);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool(WorkStealingPool&&) = delete;
+
+        virtual ~WorkStealingPool() = default;
+
+        WorkStealingPool& operator=(const WorkStealingPool& right) = delete;
+        WorkStealingPool& operator=(WorkStealingPool&& right) = delete;
+
+        void Submit(unsigned int worker, Task task);
+        void Run();
+
+        inline unsigned int GetWorkerNum() const { return static_cast<unsigned int>(queues.size()); }
+        inline unsigned long long GetStealNum() const { return steal_num; }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void Work(unsigned int worker);
+        bool Pop(unsigned int worker, Task& task);
+        bool Steal(unsigned int worker, Task& task);
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::atomic<unsigned long long> pending_num;
+        std::atomic<unsigned long long> steal_num;
+    };
+}
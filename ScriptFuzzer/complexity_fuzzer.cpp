@@ -0,0 +1,611 @@
+﻿//!
+//! @file complexity_fuzzer.cpp
+//!
+//! @brief 処理量が行数に対して線形に増えないスクリプトを探すクラス実装
+//!
+//! @details
+//! ScriptGenome の雛形を変異させながら以下を繰り返します。
+//!
+//! 1. 雛形を copies 個複製したスクリプトを読み込んで実行し、コマンドの遷移と
+//!    待ち状態毎のリストの大きさを特徴量として集める
+//! 2. 新しい特徴量が有るか、1 行あたりのメモリ確保回数が最大を更新した雛形をコーパスに加える
+//! 3. コーパスに加えた雛形は copies * scale 個複製したスクリプトでも計測し
+//!    処理時間とメモリ確保回数の増加率の指数(線形なら 1)が bound を超えたら検出する
+//! 4. 検出した雛形はコマンドを削れるだけ削って最小の再現例にする
+//!    (同じ種類で、既に検出した再現例のコマンドを全て含む雛形は報告しない)
+//!
+//! 処理時間は計測誤差が大きいので repeat 回計測した最小値で再確認します。
+//! 待ちの無いジャンプのループは SetParsingLimit() で 1 回の Parsing() を
+//! 総行数 + 1 行で打ち切り、打ち切られた場合に HANG として検出します。
+//! (待ちが無ければ同じ行を 2 回処理する事は無いので、超えたら必ず無限ループです)
+//!
+#include "complexity_fuzzer.h"
+#include "scenario_generator.h"
+#include "memory_counter.h"
+#include "script_engine_probe.h"
+#include "script_listener.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    constexpr auto DEFAULT_SEED = 1U;
+    constexpr auto DEFAULT_ITERATIONS = 2000U;
+    constexpr auto DEFAULT_COPIES = 8U;
+    constexpr auto DEFAULT_SCALE = 8U;
+    constexpr auto DEFAULT_REPEAT = 5U;
+    constexpr auto DEFAULT_MAX_FINDINGS = 16U;
+    constexpr auto DEFAULT_BOUND = 1.5;
+    constexpr auto DEFAULT_WORK_PATH = "fuzz_input.json";
+
+    // 選択肢の移動でループするスクリプトでも終わる様に打ち切る
+    constexpr auto RUN_STEP_RATE = 4U;
+
+    // 1 行あたりのメモリ確保回数がこの割合以上増えたらコーパスに加える
+    constexpr auto COST_GAIN = 0.05;
+
+    // これより短い処理時間は計測誤差が大きいので増加率を判定しない
+    constexpr auto TIME_FLOOR_NS = 200000.0;
+
+    constexpr auto COMMAND_KIND_NUM = 10U;
+    constexpr auto STATE_NUM = 5U;
+    constexpr auto BUCKET_NUM = 9U;
+    constexpr auto LIST_NUM = 8U;
+
+    constexpr auto EDGE_FEATURE = 1U;
+    constexpr auto STATE_FEATURE = 2U;
+
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int ToKind(const TCHAR command)
+    {
+        switch (command) {
+        case _T('@'): return 0;
+        case _T('m'): return 1;
+        case _T('w'): return 2;
+        case _T('j'): return 3;
+        case _T('l'): return 4;
+        case _T('c'): return 5;
+        case _T('i'): return 6;
+        case _T('d'): return 7;
+        case _T('e'): return 8;
+        default: return 9;
+        }
+    }
+
+    //!
+    //! @brief 回数を AFL と同じ区切りで分類する(1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128-)
+    //!
+    unsigned int Bucket(const unsigned long long count)
+    {
+        if (count < 4) {
+            return static_cast<unsigned int>(count);
+        }
+
+        if (count < 8) {
+            return 4;
+        }
+
+        if (count < 16) {
+            return 5;
+        }
+
+        if (count < 32) {
+            return 6;
+        }
+
+        return (count < 128) ? 7 : 8;
+    }
+
+    //!
+    //! @brief 特徴量を集めるリスナー
+    //! @details 計測中にメモリを確保しない様に固定長の配列に記録します。
+    //!
+    class FeatureListener final : public amg::ScriptListener
+    {
+    public:
+        FeatureListener()
+        {
+            std::fill(std::begin(edges), std::end(edges), 0ULL);
+            std::fill(&states[0][0][0][0], &states[0][0][0][0] + sizeof(states) / sizeof(bool), false);
+            previous = COMMAND_KIND_NUM - 1;
+            count = 0;
+        }
+
+        void OnParse(unsigned int line, TCHAR command) override
+        {
+            const auto kind = ToKind(command);
+
+            ++edges[previous * COMMAND_KIND_NUM + kind];
+            previous = kind;
+            ++count;
+        }
+
+        void Observe(const amg::ScriptEngine& engine)
+        {
+            const auto state = std::min(static_cast<unsigned int>(engine.GetState()), STATE_NUM - 1);
+            const auto draws = Bucket(amg::ScriptEngineProbe::GetDrawNum(engine));
+            const auto messages = std::min(amg::ScriptEngineProbe::GetMessageNum(engine), LIST_NUM - 1);
+            const auto choices = std::min(engine.GetChoiceNum(), LIST_NUM - 1);
+
+            states[state][draws][messages][choices] = true;
+        }
+
+        void Collect(std::set<unsigned int>& features) const
+        {
+            for (auto i = 0U; i < COMMAND_KIND_NUM * COMMAND_KIND_NUM; ++i) {
+                if (edges[i] > 0) {
+                    features.insert((EDGE_FEATURE << 24) | (i << 4) | Bucket(edges[i]));
+                }
+            }
+
+            for (auto state = 0U; state < STATE_NUM; ++state) {
+                for (auto draws = 0U; draws < BUCKET_NUM; ++draws) {
+                    for (auto messages = 0U; messages < LIST_NUM; ++messages) {
+                        for (auto choices = 0U; choices < LIST_NUM; ++choices) {
+                            if (states[state][draws][messages][choices]) {
+                                features.insert((STATE_FEATURE << 24) | (state << 12) | (draws << 8) | (messages << 4) | choices);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        inline unsigned long long GetCount() const { return count; }
+
+    private:
+        unsigned long long edges[COMMAND_KIND_NUM * COMMAND_KIND_NUM];
+        bool states[STATE_NUM][BUCKET_NUM][LIST_NUM][LIST_NUM];
+        unsigned int previous;
+        unsigned long long count;
+    };
+
+    bool IsTimeType(const amg::ComplexityFuzzer::FindingType type)
+    {
+        return type == amg::ComplexityFuzzer::FindingType::LOAD_TIME || type == amg::ComplexityFuzzer::FindingType::RUN_TIME;
+    }
+
+    //!
+    //! @brief 同じ種類で、コマンドの集合が部分集合になる検出結果が既に有るか
+    //! @details 大きな雛形は既に検出した小さな雛形と同じ原因である事が多いので報告しません。
+    //!
+    bool IsReported(const std::vector<std::pair<amg::ComplexityFuzzer::FindingType, std::string>>& reported,
+        const amg::ComplexityFuzzer::FindingType type, const std::string& signature)
+    {
+        for (auto&& element : reported) {
+            if (element.first == type && std::includes(signature.begin(), signature.end(), element.second.begin(), element.second.end())) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    double PerLine(const double cost, const unsigned long long lines)
+    {
+        return (lines > 0) ? cost / lines : 0.0;
+    }
+}
+
+namespace amg
+{
+    ComplexityFuzzer::ComplexityFuzzer()
+    {
+        work_path = DEFAULT_WORK_PATH;
+        seed = DEFAULT_SEED;
+        iterations = DEFAULT_ITERATIONS;
+        copies = DEFAULT_COPIES;
+        scale = DEFAULT_SCALE;
+        repeat = DEFAULT_REPEAT;
+        max_findings = DEFAULT_MAX_FINDINGS;
+        bound = DEFAULT_BOUND;
+    }
+
+    //!
+    //! @fn bool ComplexityFuzzer::Fuzz(Result& result) const
+    //! @brief ファジングを行う
+    //! @param[out] result 実行回数などの統計と検出結果
+    //! @return 処理の成否(作業用のスクリプトが保存出来ない場合などは false)
+    //!
+    bool ComplexityFuzzer::Fuzz(Result& result) const
+    {
+        const auto start = Clock::now();
+        std::mt19937 random(seed);
+        std::vector<ScriptGenome> corpus;
+        std::set<unsigned int> coverage;
+        std::vector<std::pair<FindingType, std::string>> reported;
+        auto best_load_allocs = 0.0;
+        auto best_run_allocs = 0.0;
+
+        result = Result();
+
+        // 最初の雛形はメッセージとクリック待ちのみ
+        ScriptGenome initial;
+        Cost initial_cost;
+
+        initial.SetGenes({ ScriptGenome::Gene(ScriptGenome::Command::MESSAGE, 4, 0), ScriptGenome::Gene(ScriptGenome::Command::CLICK, 0, 0) });
+
+        if (!Measure(initial, copies, initial_cost, &coverage)) {
+            return false;
+        }
+
+        corpus.emplace_back(initial);
+
+        for (auto iteration = 0U; iteration < iterations && result.findings.size() < max_findings; ++iteration) {
+            ++result.iterations;
+
+            auto child = corpus[random() % corpus.size()];
+            const auto& other = corpus[random() % corpus.size()];
+
+            child.Mutate(random, other);
+
+            Cost cost;
+            std::set<unsigned int> features;
+
+            if (!Measure(child, copies, cost, &features)) {
+                continue;
+            }
+
+            ++result.executions;
+
+            std::vector<FindingType> types;
+
+            if (cost.is_hang) {
+                types.emplace_back(FindingType::HANG);
+            }
+            else {
+                auto is_interesting = false;
+
+                for (auto&& feature : features) {
+                    is_interesting |= coverage.insert(feature).second;
+                }
+
+                const auto load_allocs = PerLine(cost.load_allocs, cost.lines);
+                const auto run_allocs = PerLine(cost.run_allocs, cost.parsed_lines);
+
+                if (load_allocs > best_load_allocs * (1.0 + COST_GAIN)) {
+                    best_load_allocs = load_allocs;
+                    is_interesting = true;
+                }
+
+                if (run_allocs > best_run_allocs * (1.0 + COST_GAIN)) {
+                    best_run_allocs = run_allocs;
+                    is_interesting = true;
+                }
+
+                if (!is_interesting) {
+                    continue;
+                }
+
+                corpus.emplace_back(child);
+
+                // 複製数を増やしても 1 行あたりの処理量が変わらないか確認する
+                Cost large;
+
+                if (!Measure(child, copies * scale, large, nullptr) || large.is_hang) {
+                    continue;
+                }
+
+                for (auto type : { FindingType::LOAD_ALLOC, FindingType::RUN_ALLOC, FindingType::LOAD_TIME, FindingType::RUN_TIME }) {
+                    if (Exponent(cost, large, type) > bound) {
+                        types.emplace_back(type);
+                    }
+                }
+            }
+
+            for (auto&& type : types) {
+                if (IsReported(reported, type, child.GetSignature()) || result.findings.size() >= max_findings) {
+                    continue;
+                }
+
+                Finding finding;
+
+                // 処理時間は計測し直して再現しなければ誤検出とする
+                if (!Reproduce(child, type, &finding)) {
+                    continue;
+                }
+
+                Minimize(finding);
+
+                const auto signature = finding.genome.GetSignature();
+
+                if (IsReported(reported, type, signature)) {
+                    continue;
+                }
+
+                reported.emplace_back(type, signature);
+                finding.iteration = iteration;
+                result.findings.emplace_back(std::move(finding));
+            }
+        }
+
+        result.corpus = static_cast<unsigned int>(corpus.size());
+        result.features = static_cast<unsigned int>(coverage.size());
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        return true;
+    }
+
+    //!
+    //! @fn bool ComplexityFuzzer::Measure(const ScriptGenome& genome, unsigned int copies, Cost& cost, std::set<unsigned int>* features) const
+    //! @brief 雛形を複製したスクリプトを読み込んで最後まで実行する
+    //! @param[in] genome 雛形
+    //! @param[in] copies 複製数
+    //! @param[out] cost 読み込みと実行の処理時間とメモリ確保回数
+    //! @param[out] features 特徴量の追加先(nullptr なら集めない)
+    //! @return 処理の成否
+    //! @details 待ち状態は入力無しで終わらせ、選択待ちでは実行した回数で選択肢を変えます。
+    //!
+    bool ComplexityFuzzer::Measure(const ScriptGenome& genome, unsigned int copies, Cost& cost, std::set<unsigned int>* features) const
+    {
+        std::vector<std::string> scripts;
+
+        genome.Render(copies, scripts);
+
+        if (!ScenarioGenerator::SaveJson(work_path, scripts)) {
+            return false;
+        }
+
+        cost = Cost();
+
+        ScriptEngine engine;
+        FeatureListener listener;
+
+        const auto load_allocs = MemoryCounter::GetAllocCount();
+        const auto load_start = Clock::now();
+        const auto is_initialized = engine.Initialize(work_path.c_str());
+        const auto load_end = Clock::now();
+
+        if (!is_initialized) {
+            return false;
+        }
+
+        cost.load_ns = std::chrono::duration<double, std::nano>(load_end - load_start).count();
+        cost.load_allocs = static_cast<double>(MemoryCounter::GetAllocCount() - load_allocs);
+        cost.lines = engine.GetMaxLine();
+
+        engine.SetListener(&listener);
+        engine.SetParsingLimit(engine.GetMaxLine() + 1);
+
+        const auto step_max = cost.lines * RUN_STEP_RATE;
+        const auto run_allocs = MemoryCounter::GetAllocCount();
+        const auto run_start = Clock::now();
+
+        for (auto step = 0ULL; step < step_max; ++step) {
+            ScriptEngineProbe::Parsing(engine);
+
+            const auto state = engine.GetState();
+
+            if (state == ScriptEngine::ScriptState::END) {
+                break;
+            }
+
+            if (state == ScriptEngine::ScriptState::PARSING) {
+                // 最終行を超えていないのに止まったなら Parsing() が打ち切られている
+                cost.is_hang = (engine.GetNowLine() < engine.GetMaxLine());
+                break;
+            }
+
+            listener.Observe(engine);
+            ScriptEngineProbe::SkipWait(engine, static_cast<unsigned int>(step));
+        }
+
+        const auto run_end = Clock::now();
+
+        cost.run_ns = std::chrono::duration<double, std::nano>(run_end - run_start).count();
+        cost.run_allocs = static_cast<double>(MemoryCounter::GetAllocCount() - run_allocs);
+        cost.parsed_lines = listener.GetCount();
+
+        if (features != nullptr) {
+            listener.Collect(*features);
+        }
+
+        return true;
+    }
+
+    const char* ComplexityFuzzer::GetName(FindingType type)
+    {
+        switch (type) {
+        case FindingType::HANG: return "hang";
+        case FindingType::LOAD_TIME: return "load_time";
+        case FindingType::LOAD_ALLOC: return "load_alloc";
+        case FindingType::RUN_TIME: return "run_time";
+        case FindingType::RUN_ALLOC: return "run_alloc";
+        }
+
+        return "unknown";
+    }
+
+    //!
+    //! @fn double ComplexityFuzzer::Exponent(const Cost& small, const Cost& large, FindingType type)
+    //! @brief 処理量が行数の何乗で増えているかを求める
+    //! @param[in] small 複製数が少ない場合の計測結果
+    //! @param[in] large 複製数が多い場合の計測結果
+    //! @param[in] type 対象の処理量
+    //! @return 指数(線形なら 1、判定出来ない場合は 0)
+    //! @details 読み込みはスクリプトの行数、実行は処理した行数に対しての指数です。
+    //!
+    double ComplexityFuzzer::Exponent(const Cost& small, const Cost& large, FindingType type)
+    {
+        auto small_cost = 0.0;
+        auto large_cost = 0.0;
+        auto small_lines = 0ULL;
+        auto large_lines = 0ULL;
+
+        switch (type) {
+        case FindingType::LOAD_TIME:
+            small_cost = small.load_ns;
+            large_cost = large.load_ns;
+            break;
+
+        case FindingType::LOAD_ALLOC:
+            small_cost = small.load_allocs;
+            large_cost = large.load_allocs;
+            break;
+
+        case FindingType::RUN_TIME:
+            small_cost = small.run_ns;
+            large_cost = large.run_ns;
+            break;
+
+        case FindingType::RUN_ALLOC:
+            small_cost = small.run_allocs;
+            large_cost = large.run_allocs;
+            break;
+
+        default:
+            return 0.0;
+        }
+
+        if (type == FindingType::LOAD_TIME || type == FindingType::LOAD_ALLOC) {
+            small_lines = small.lines;
+            large_lines = large.lines;
+        }
+        else {
+            small_lines = small.parsed_lines;
+            large_lines = large.parsed_lines;
+        }
+
+        if (small_cost <= 0.0 || large_cost <= 0.0 || small_lines == 0 || large_lines <= small_lines) {
+            return 0.0;
+        }
+
+        if (IsTimeType(type) && large_cost < TIME_FLOOR_NS) {
+            return 0.0;
+        }
+
+        return std::log(large_cost / small_cost) / std::log(static_cast<double>(large_lines) / small_lines);
+    }
+
+    //!
+    //! @fn bool ComplexityFuzzer::MeasureScale(const ScriptGenome& genome, unsigned int repeat, Cost& small, Cost& large) const
+    //! @brief 複製数が少ない場合と多い場合を交互に計測する
+    //! @param[in] genome 雛形
+    //! @param[in] repeat 計測回数(処理時間は最小値を使用する)
+    //! @param[out] small 複製数が少ない場合の計測結果
+    //! @param[out] large 複製数が多い場合の計測結果
+    //! @return 処理の成否
+    //!
+    bool ComplexityFuzzer::MeasureScale(const ScriptGenome& genome, unsigned int repeat, Cost& small, Cost& large) const
+    {
+        for (auto i = 0U; i < std::max(repeat, 1U); ++i) {
+            Cost small_cost;
+            Cost large_cost;
+
+            if (!Measure(genome, copies, small_cost, nullptr) || !Measure(genome, copies * scale, large_cost, nullptr)) {
+                return false;
+            }
+
+            if (i > 0) {
+                small_cost.load_ns = std::min(small_cost.load_ns, small.load_ns);
+                small_cost.run_ns = std::min(small_cost.run_ns, small.run_ns);
+                large_cost.load_ns = std::min(large_cost.load_ns, large.load_ns);
+                large_cost.run_ns = std::min(large_cost.run_ns, large.run_ns);
+            }
+
+            small = small_cost;
+            large = large_cost;
+        }
+
+        return true;
+    }
+
+    //!
+    //! @fn bool ComplexityFuzzer::Reproduce(const ScriptGenome& genome, FindingType type, Finding* finding) const
+    //! @brief 雛形が指定の種類の検出結果を再現するか確認する
+    //! @param[in] genome 雛形
+    //! @param[in] type 検出結果の種類
+    //! @param[out] finding 再現した場合の計測結果の格納先(nullptr なら格納しない)
+    //! @return 再現したか
+    //!
+    bool ComplexityFuzzer::Reproduce(const ScriptGenome& genome, FindingType type, Finding* finding) const
+    {
+        Cost small;
+        Cost large;
+        auto exponent = 0.0;
+
+        if (type == FindingType::HANG) {
+            if (!Measure(genome, copies, small, nullptr) || !small.is_hang) {
+                return false;
+            }
+        }
+        else {
+            if (!MeasureScale(genome, IsTimeType(type) ? repeat : 1, small, large) || small.is_hang || large.is_hang) {
+                return false;
+            }
+
+            exponent = Exponent(small, large, type);
+
+            if (exponent <= bound) {
+                return false;
+            }
+        }
+
+        if (finding != nullptr) {
+            finding->type = type;
+            finding->genome = genome;
+            finding->small = small;
+            finding->large = large;
+            finding->exponent = exponent;
+        }
+
+        return true;
+    }
+
+    //!
+    //! @fn void ComplexityFuzzer::Minimize(Finding& finding) const
+    //! @brief 検出結果を再現する最小の雛形にする
+    //! @param[in,out] finding 検出結果
+    //! @details 半分、1/4 … 1 コマンドと削る範囲を狭めながら、再現する限りコマンドを削ります。
+    //! 最後にメッセージの長さなどのパラメータも最小にします。
+    //!
+    void ComplexityFuzzer::Minimize(Finding& finding) const
+    {
+        auto genes = finding.genome.GetGenes();
+        ScriptGenome candidate;
+
+        for (auto length = std::max<size_t>(genes.size() / 2, 1); length > 0; length /= 2) {
+            for (size_t position = 0; position < genes.size() && genes.size() > 1;) {
+                auto reduced = genes;
+                const auto last = std::min(position + length, reduced.size());
+
+                reduced.erase(reduced.begin() + position, reduced.begin() + last);
+                candidate.SetGenes(reduced);
+
+                if (!reduced.empty() && Reproduce(candidate, finding.type, nullptr)) {
+                    genes = reduced;
+                }
+                else {
+                    position += length;
+                }
+            }
+        }
+
+        for (auto&& gene : genes) {
+            const auto original = gene;
+
+            if (gene.command == ScriptGenome::Command::MESSAGE || gene.command == ScriptGenome::Command::WAIT) {
+                gene.a = (gene.command == ScriptGenome::Command::MESSAGE) ? 1 : 0;
+            }
+            else if (gene.command == ScriptGenome::Command::CHOICE) {
+                gene.b = 1;
+            }
+            else {
+                continue;
+            }
+
+            candidate.SetGenes(genes);
+
+            if (!Reproduce(candidate, finding.type, nullptr)) {
+                gene = original;
+            }
+        }
+
+        candidate.SetGenes(genes);
+
+        // 最小化した雛形で計測し直す(再現しなければ元の計測結果のまま)
+        Reproduce(candidate, finding.type, &finding);
+    }
+}
@@ -0,0 +1,125 @@
+﻿//!
+//! @file complexity_fuzzer.h
+//!
+//! @brief 処理量が行数に対して線形に増えないスクリプトを探すクラス定義
+//!
+#pragma once
+
+#include "script_genome.h"
+#include <vector>
+#include <string>
+#include <set>
+
+namespace amg
+{
+    class ComplexityFuzzer
+    {
+    public:
+        enum class FindingType {
+            HANG,       // 待ちの無いジャンプのループ(1 フレームの処理が終わらない)
+            LOAD_TIME,  // 読み込みの処理時間
+            LOAD_ALLOC, // 読み込みのメモリ確保回数
+            RUN_TIME,   // 実行の処理時間
+            RUN_ALLOC   // 実行のメモリ確保回数
+        };
+
+        struct Cost
+        {
+            double load_ns;
+            double load_allocs;
+            double run_ns;
+            double run_allocs;
+            unsigned long long lines;
+            unsigned long long parsed_lines;
+            bool is_hang;
+
+            Cost()
+            {
+                load_ns = 0.0;
+                load_allocs = 0.0;
+                run_ns = 0.0;
+                run_allocs = 0.0;
+                lines = 0;
+                parsed_lines = 0;
+                is_hang = false;
+            }
+        };
+
+        struct Finding
+        {
+            FindingType type;
+            ScriptGenome genome;
+            Cost small;
+            Cost large;
+            double exponent;
+            unsigned int iteration;
+
+            Finding()
+            {
+                type = FindingType::HANG;
+                exponent = 0.0;
+                iteration = 0;
+            }
+        };
+
+        struct Result
+        {
+            unsigned int iterations;
+            unsigned int executions;
+            unsigned int corpus;
+            unsigned int features;
+            std::vector<Finding> findings;
+            double elapsed_ms;
+
+            Result()
+            {
+                iterations = 0;
+                executions = 0;
+                corpus = 0;
+                features = 0;
+                elapsed_ms = 0.0;
+            }
+        };
+
+        ComplexityFuzzer();
+        ComplexityFuzzer(const ComplexityFuzzer&) = default;
+        ComplexityFuzzer(ComplexityFuzzer&&) noexcept = default;
+
+        virtual ~ComplexityFuzzer() = default;
+
+        ComplexityFuzzer& operator=(const ComplexityFuzzer& right) = default;
+        ComplexityFuzzer& operator=(ComplexityFuzzer&& right) noexcept = default;
+
+        inline void SetSeed(const unsigned int seed) { this->seed = seed; }
+        inline void SetIterations(const unsigned int iterations) { this->iterations = iterations; }
+        inline void SetCopies(const unsigned int copies) { this->copies = copies; }
+        inline void SetScale(const unsigned int scale) { this->scale = scale; }
+        inline void SetBound(const double bound) { this->bound = bound; }
+        inline void SetRepeat(const unsigned int repeat) { this->repeat = repeat; }
+        inline void SetMaxFindings(const unsigned int max_findings) { this->max_findings = max_findings; }
+        inline void SetWorkPath(const std::string& work_path) { this->work_path = work_path; }
+
+        inline unsigned int GetCopies() const { return copies; }
+        inline unsigned int GetLargeCopies() const { return copies * scale; }
+
+        bool Fuzz(Result& result) const;
+        bool Measure(const ScriptGenome& genome, unsigned int copies, Cost& cost, std::set<unsigned int>* features) const;
+
+        static const char* GetName(FindingType type);
+        static double Exponent(const Cost& small, const Cost& large, FindingType type);
+
+    private:
+        bool MeasureScale(const ScriptGenome& genome, unsigned int repeat, Cost& small, Cost& large) const;
+        bool Reproduce(const ScriptGenome& genome, FindingType type, Finding* finding) const;
+        void Minimize(Finding& finding) const;
+
+        std::string work_path;
+        unsigned int seed;
+        unsigned int iterations;
+        unsigned int copies;
+        unsigned int scale;
+        unsigned int repeat;
+        unsigned int max_findings;
+        double bound;
+    };
+}
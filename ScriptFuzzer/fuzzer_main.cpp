@@ -0,0 +1,234 @@
+﻿//!
+//! @file fuzzer_main.cpp
+//!
+//! @brief 複雑度ファジングツールのエントリーポイント
+//!
+//! @details
+//! 使い方: ScriptFuzzer [オプション]
+//!
+//! --iterations 数    変異させる回数(既定値 2000)
+//! --seed 値          乱数の種(同じ値なら同じ順番で探索する)
+//! --copies 数        雛形の複製数(既定値 8)
+//! --scale 数         増加率を調べる時に複製数を何倍にするか(既定値 8)
+//! --bound 値         検出する増加率の指数(既定値 1.5、線形なら 1)
+//! --repeat 数        処理時間を再確認する計測回数(既定値 5)
+//! --max-findings 数  検出したら終了する数(既定値 16)
+//! --work ファイル     計測に使用する作業用のスクリプト(既定値 fuzz_input.json)
+//! --out 文字列        再現例を保存するファイル名の先頭(既定値 fuzz_finding_)
+//!
+//! 検出した再現例は複製数を増やした方のスクリプトで <out><番号>.json に保存します。
+//! 何か検出したら 1 を、それ以外は 0 を返します。
+//!
+#include "complexity_fuzzer.h"
+#include "scenario_generator.h"
+#include "dx_wrapper.h"
+#include "dx_headless.h"
+#include "amg_string.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr auto DEFAULT_OUT_PREFIX = "fuzz_finding_";
+
+    struct Options
+    {
+        std::string work_path;
+        std::string out_prefix;
+        int iterations;
+        int seed;
+        int copies;
+        int scale;
+        int repeat;
+        int max_findings;
+        double bound;
+
+        Options()
+        {
+            out_prefix = DEFAULT_OUT_PREFIX;
+            iterations = -1;
+            seed = -1;
+            copies = -1;
+            scale = -1;
+            repeat = -1;
+            max_findings = -1;
+            bound = 0.0;
+        }
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: ScriptFuzzer [--iterations n] [--seed n] [--copies n] [--scale n] [--bound r] [--repeat n]"
+            << " [--max-findings n] [--work file] [--out prefix]" << std::endl;
+    }
+
+    bool ToDouble(const std::string& str, double& value)
+    {
+        try {
+            value = std::stod(str);
+        }
+        catch (...) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (auto i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            const auto has_value = (i + 1) < argc;
+
+            if (arg == "--iterations" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.iterations)) {
+                    return false;
+                }
+            }
+            else if (arg == "--seed" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.seed)) {
+                    return false;
+                }
+            }
+            else if (arg == "--copies" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.copies) || options.copies <= 0) {
+                    return false;
+                }
+            }
+            else if (arg == "--scale" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.scale) || options.scale < 2) {
+                    return false;
+                }
+            }
+            else if (arg == "--bound" && has_value) {
+                if (!ToDouble(argv[++i], options.bound) || options.bound <= 0.0) {
+                    return false;
+                }
+            }
+            else if (arg == "--repeat" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.repeat) || options.repeat <= 0) {
+                    return false;
+                }
+            }
+            else if (arg == "--max-findings" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.max_findings) || options.max_findings <= 0) {
+                    return false;
+                }
+            }
+            else if (arg == "--work" && has_value) {
+                options.work_path = argv[++i];
+            }
+            else if (arg == "--out" && has_value) {
+                options.out_prefix = argv[++i];
+            }
+            else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void PrintCost(const char* name, const amg::ComplexityFuzzer::Cost& cost)
+    {
+        std::cout << "  " << name << ": lines=" << cost.lines << " parsed=" << cost.parsed_lines
+            << " load_us=" << cost.load_ns / 1000.0 << " load_allocs=" << cost.load_allocs
+            << " run_us=" << cost.run_ns / 1000.0 << " run_allocs=" << cost.run_allocs << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // 生成したスクリプトの画像ファイルは存在しないので確認しない
+    amg::DxHeadless::Reset();
+    amg::DxHeadless::SetFileCheck(false);
+    amg::DxWrapper::SetGraphMode(1280, 720, 32);
+
+    amg::ComplexityFuzzer fuzzer;
+    amg::ComplexityFuzzer::Result result;
+
+    if (options.iterations >= 0) {
+        fuzzer.SetIterations(static_cast<unsigned int>(options.iterations));
+    }
+
+    if (options.seed >= 0) {
+        fuzzer.SetSeed(static_cast<unsigned int>(options.seed));
+    }
+
+    if (options.copies > 0) {
+        fuzzer.SetCopies(static_cast<unsigned int>(options.copies));
+    }
+
+    if (options.scale > 0) {
+        fuzzer.SetScale(static_cast<unsigned int>(options.scale));
+    }
+
+    if (options.repeat > 0) {
+        fuzzer.SetRepeat(static_cast<unsigned int>(options.repeat));
+    }
+
+    if (options.max_findings > 0) {
+        fuzzer.SetMaxFindings(static_cast<unsigned int>(options.max_findings));
+    }
+
+    if (options.bound > 0.0) {
+        fuzzer.SetBound(options.bound);
+    }
+
+    if (!options.work_path.empty()) {
+        fuzzer.SetWorkPath(options.work_path);
+    }
+
+    if (!fuzzer.Fuzz(result)) {
+        std::cerr << "fuzz error: work file can not be written or loaded" << std::endl;
+        return 1;
+    }
+
+    std::cout << "iterations: " << result.iterations << std::endl;
+    std::cout << "executions: " << result.executions << std::endl;
+    std::cout << "corpus: " << result.corpus << std::endl;
+    std::cout << "features: " << result.features << std::endl;
+    std::cout << "findings: " << result.findings.size() << std::endl;
+
+    for (size_t i = 0; i < result.findings.size(); ++i) {
+        const auto& finding = result.findings[i];
+        const auto path = options.out_prefix + std::to_string(i) + ".json";
+        std::vector<std::string> scripts;
+
+        std::cout << "finding: " << amg::ComplexityFuzzer::GetName(finding.type) << " exponent=" << finding.exponent
+            << " commands=" << finding.genome.GetSignature() << " iteration=" << finding.iteration
+            << " reproducer=" << path << std::endl;
+
+        PrintCost("small", finding.small);
+
+        if (finding.type != amg::ComplexityFuzzer::FindingType::HANG) {
+            PrintCost("large", finding.large);
+        }
+
+        // 再現例の本体(1 つ目の複製)
+        finding.genome.RenderBody(0, scripts);
+
+        for (auto&& script : scripts) {
+            std::cout << "  | " << script << std::endl;
+        }
+
+        const auto copies = (finding.type == amg::ComplexityFuzzer::FindingType::HANG) ? fuzzer.GetCopies() : fuzzer.GetLargeCopies();
+
+        finding.genome.Render(copies, scripts);
+
+        if (!amg::ScenarioGenerator::SaveJson(path, scripts)) {
+            std::cerr << "save error: " << path << std::endl;
+        }
+    }
+
+    std::cout << "elapsed_ms: " << result.elapsed_ms << std::endl;
+
+    return result.findings.empty() ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+﻿//!
+//! @file script_genome.cpp
+//!
+//! @brief 複雑度ファジング用のスクリプトの雛形を表すクラス実装
+//!
+//! @details
+//! 雛形は数十行程度のコマンドの並び(本体)で、Render() で本体を指定数だけ複製して
+//! 1 つのスクリプトにします。複製毎にラベル名、画像ラベル名、描画インデックスを
+//! 別の値にするので、複製数を増やすとラベルや画像、描画リストの数も同じ割合で増えます。
+//! (複製数に対して処理時間が線形に増えない箇所を探す為)
+//!
+//! 生成する行は必ずコマンド毎の正しいパラメータ数になります。
+//! (パラメータの不足はエンジンの範囲外アクセスになるので複雑度の対象外とします)
+//!
+#include "script_genome.h"
+#include <algorithm>
+#include <set>
+
+namespace {
+    // 生成するスクリプトは UTF-8 なので日本語は u8 リテラルで記述する
+    constexpr auto CURSOR_IMAGE = u8"i, カーソル, png/arrow_cursor.png";
+    constexpr auto CLICK_WAIT_IMAGE = u8"i, クリック待ち, png/click_wait.png";
+    constexpr auto IMAGE_FILE = "png/amg502.png";
+    constexpr auto MESSAGE_WORD = u8"あ";
+
+    constexpr auto GENE_MAX = 32U;
+    constexpr auto SLOT_NUM = 4U;
+    constexpr auto DRAW_STRIDE = SLOT_NUM;
+    constexpr auto MESSAGE_WORD_MAX = 40U;
+    constexpr auto CHOICE_WORD_MAX = 24U;
+    constexpr auto WAIT_FRAME_MAX = 60U;
+    constexpr auto MUTATION_MAX = 4U;
+
+    enum class Mutation {
+        INSERT,
+        ERASE,
+        REPLACE,
+        TWEAK,
+        DUPLICATE,
+        SPLICE,
+        SWAP,
+        NUM
+    };
+
+    std::string MakeName(const char* prefix, const unsigned int slot, const unsigned int copy)
+    {
+        return prefix + std::to_string(slot) + "_" + std::to_string(copy);
+    }
+
+    std::string MakeMessage(const unsigned int length)
+    {
+        std::string message;
+
+        for (auto i = 0U; i < length; ++i) {
+            message += MESSAGE_WORD;
+        }
+
+        return message;
+    }
+
+    char ToChar(const amg::ScriptGenome::Command command)
+    {
+        switch (command) {
+        case amg::ScriptGenome::Command::LABEL: return 'l';
+        case amg::ScriptGenome::Command::JUMP: return 'j';
+        case amg::ScriptGenome::Command::IMAGE: return 'i';
+        case amg::ScriptGenome::Command::DRAW: return 'd';
+        case amg::ScriptGenome::Command::MESSAGE: return 'm';
+        case amg::ScriptGenome::Command::CHOICE: return 'c';
+        case amg::ScriptGenome::Command::CLICK: return '@';
+        case amg::ScriptGenome::Command::WAIT: return 'w';
+        }
+
+        return '?';
+    }
+}
+
+namespace amg
+{
+    //!
+    //! @fn void ScriptGenome::Mutate(std::mt19937& random, const ScriptGenome& other)
+    //! @brief 雛形を変異させる
+    //! @param[in,out] random 乱数生成器
+    //! @param[in] other 交叉に使用する別の雛形
+    //! @details 挿入、削除、置換、パラメータ変更、範囲の複製、交叉、入れ替えの中から
+    //! 1 ～ MUTATION_MAX 回を重ねて適用します。
+    //!
+    void ScriptGenome::Mutate(std::mt19937& random, const ScriptGenome& other)
+    {
+        const auto count = 1 + random() % MUTATION_MAX;
+
+        for (auto i = 0U; i < count; ++i) {
+            const auto size = static_cast<unsigned int>(genes.size());
+            const auto mutation = static_cast<Mutation>(random() % static_cast<unsigned int>(Mutation::NUM));
+
+            if (size == 0) {
+                genes.emplace_back(MakeGene(random));
+                continue;
+            }
+
+            const auto position = random() % size;
+
+            switch (mutation) {
+            case Mutation::INSERT:
+                if (size < GENE_MAX) {
+                    genes.insert(genes.begin() + random() % (size + 1), MakeGene(random));
+                }
+                break;
+
+            case Mutation::ERASE:
+                if (size > 1) {
+                    genes.erase(genes.begin() + position);
+                }
+                break;
+
+            case Mutation::REPLACE:
+                genes[position] = MakeGene(random);
+                break;
+
+            case Mutation::TWEAK:
+                // コマンドはそのままでパラメータのみ変える
+                genes[position] = MakeGene(random, genes[position].command);
+                break;
+
+            case Mutation::DUPLICATE: {
+                const auto length = 1 + random() % (size - position);
+
+                if (size + length <= GENE_MAX) {
+                    const std::vector<Gene> slice(genes.begin() + position, genes.begin() + position + length);
+
+                    genes.insert(genes.begin() + position, slice.begin(), slice.end());
+                }
+                break;
+            }
+
+            case Mutation::SPLICE:
+                if (!other.genes.empty()) {
+                    const auto other_position = random() % other.genes.size();
+
+                    genes.resize(position);
+                    genes.insert(genes.end(), other.genes.begin() + other_position, other.genes.end());
+
+                    if (genes.size() > GENE_MAX) {
+                        genes.resize(GENE_MAX);
+                    }
+
+                    if (genes.empty()) {
+                        genes.emplace_back(MakeGene(random));
+                    }
+                }
+                break;
+
+            case Mutation::SWAP:
+                std::swap(genes[position], genes[random() % size]);
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    //!
+    //! @fn void ScriptGenome::Render(unsigned int copies, std::vector<std::string>& scripts) const
+    //! @brief 本体を複製したスクリプトを生成する
+    //! @param[in] copies 本体の複製数
+    //! @param[out] scripts 生成したスクリプト(UTF-8)
+    //!
+    void ScriptGenome::Render(unsigned int copies, std::vector<std::string>& scripts) const
+    {
+        scripts.clear();
+        scripts.reserve(genes.size() * copies + 3);
+
+        scripts.emplace_back(CURSOR_IMAGE);
+        scripts.emplace_back(CLICK_WAIT_IMAGE);
+
+        for (auto copy = 0U; copy < copies; ++copy) {
+            RenderBody(copy, scripts);
+        }
+
+        scripts.emplace_back("e");
+    }
+
+    //!
+    //! @fn void ScriptGenome::RenderBody(unsigned int copy, std::vector<std::string>& scripts) const
+    //! @brief 本体を 1 つ分生成してスクリプトの末尾に追加する
+    //! @param[in] copy 何番目の複製か(ラベル名などに使用する)
+    //! @param[in,out] scripts 追加先のスクリプト(UTF-8)
+    //!
+    void ScriptGenome::RenderBody(unsigned int copy, std::vector<std::string>& scripts) const
+    {
+        for (auto&& gene : genes) {
+            switch (gene.command) {
+            case Command::LABEL:
+                scripts.emplace_back("l, " + MakeName("L", gene.a, copy));
+                break;
+
+            case Command::JUMP:
+                scripts.emplace_back("j, " + MakeName("L", gene.a, copy));
+                break;
+
+            case Command::IMAGE:
+                scripts.emplace_back("i, " + MakeName("I", gene.a, copy) + ", " + IMAGE_FILE);
+                break;
+
+            case Command::DRAW:
+                scripts.emplace_back("d, " + std::to_string(gene.a + copy * DRAW_STRIDE) + ", 0, 0, " + MakeName("I", gene.b, copy));
+                break;
+
+            case Command::MESSAGE:
+                scripts.emplace_back("m, " + MakeMessage(gene.a));
+                break;
+
+            case Command::CHOICE:
+                scripts.emplace_back("c, " + MakeName("L", gene.a, copy) + ", " + MakeMessage(gene.b));
+                break;
+
+            case Command::CLICK:
+                scripts.emplace_back("@");
+                break;
+
+            case Command::WAIT:
+                scripts.emplace_back("w, " + std::to_string(gene.a));
+                break;
+            }
+        }
+    }
+
+    //!
+    //! @fn std::string ScriptGenome::GetSignature() const
+    //! @brief 本体に含まれるコマンド文字の集合を取得する
+    //! @return コマンド文字を並べた文字列(同じ種類の検出結果をまとめる為に使用する)
+    //!
+    std::string ScriptGenome::GetSignature() const
+    {
+        std::set<char> commands;
+
+        for (auto&& gene : genes) {
+            commands.insert(ToChar(gene.command));
+        }
+
+        return std::string(commands.begin(), commands.end());
+    }
+
+    //!
+    //! @fn ScriptGenome::Gene ScriptGenome::MakeGene(std::mt19937& random)
+    //! @brief ランダムなコマンドを 1 つ生成する
+    //! @param[in,out] random 乱数生成器
+    //! @return 生成したコマンド
+    //!
+    ScriptGenome::Gene ScriptGenome::MakeGene(std::mt19937& random)
+    {
+        const auto command = static_cast<Command>(random() % (static_cast<unsigned int>(Command::WAIT) + 1));
+
+        return MakeGene(random, command);
+    }
+
+    //!
+    //! @fn ScriptGenome::Gene ScriptGenome::MakeGene(std::mt19937& random, Command command)
+    //! @brief 指定コマンドのランダムなパラメータを生成する
+    //! @param[in,out] random 乱数生成器
+    //! @param[in] command コマンド
+    //! @return 生成したコマンド
+    //!
+    ScriptGenome::Gene ScriptGenome::MakeGene(std::mt19937& random, Command command)
+    {
+        switch (command) {
+        case Command::MESSAGE:
+            return Gene(command, 1 + random() % MESSAGE_WORD_MAX, 0);
+
+        case Command::CHOICE:
+            return Gene(command, random() % SLOT_NUM, 1 + random() % CHOICE_WORD_MAX);
+
+        case Command::WAIT:
+            return Gene(command, random() % (WAIT_FRAME_MAX + 1), 0);
+
+        default:
+            return Gene(command, random() % SLOT_NUM, random() % SLOT_NUM);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+﻿//!
+//! @file script_genome.h
+//!
+//! @brief 複雑度ファジング用のスクリプトの雛形を表すクラス定義
+//!
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+
+namespace amg
+{
+    class ScriptGenome
+    {
+    public:
+        enum class Command {
+            LABEL,      // l, L<a>_<copy>
+            JUMP,       // j, L<a>_<copy>
+            IMAGE,      // i, I<a>_<copy>, <file>
+            DRAW,       // d, <a + copy * stride>, 0, 0, I<b>_<copy>
+            MESSAGE,    // m, <a 文字のメッセージ>
+            CHOICE,     // c, L<a>_<copy>, <b 文字のメッセージ>
+            CLICK,      // @
+            WAIT        // w, <a>
+        };
+
+        struct Gene
+        {
+            Command command;
+            unsigned int a;
+            unsigned int b;
+
+            Gene()
+            {
+                command = Command::CLICK;
+                a = 0;
+                b = 0;
+            }
+
+            Gene(Command command, unsigned int a, unsigned int b)
+            {
+                this->command = command;
+                this->a = a;
+                this->b = b;
+            }
+        };
+
+        ScriptGenome() = default;
+        ScriptGenome(const ScriptGenome&) = default;
+        ScriptGenome(ScriptGenome&&) noexcept = default;
+
+        virtual ~ScriptGenome() = default;
+
+        ScriptGenome& operator=(const ScriptGenome& right) = default;
+        ScriptGenome& operator=(ScriptGenome&& right) noexcept = default;
+
+        void Mutate(std::mt19937& random, const ScriptGenome& other);
+        void Render(unsigned int copies, std::vector<std::string>& scripts) const;
+        void RenderBody(unsigned int copy, std::vector<std::string>& scripts) const;
+        std::string GetSignature() const;
+
+        inline const std::vector<Gene>& GetGenes() const { return genes; }
+        inline void SetGenes(const std::vector<Gene>& genes) { this->genes = genes; }
+        inline bool IsEmpty() const { return genes.empty(); }
+
+        static Gene MakeGene(std::mt19937& random);
+        static Gene MakeGene(std::mt19937& random, Command command);
+
+    private:
+        std::vector<Gene> genes;
+    };
+}
@@ -0,0 +1,506 @@
+﻿//!
+//! @file runner_main.cpp
+//!
+//! @brief ヘッドレス実行ツールのエントリーポイント
+//!
+//! @details
+//! 使い方: ScriptRunner スクリプト.json [オプション]
+//!
+//! --input ファイル   入力スクリプト(input_script.cpp 参照)
+//! --record ファイル  実行中の入力を記録して保存する(input_record.cpp 参照)
+//! --replay ファイル  入力スクリプトの代わりに記録した入力を再生する
+//! --auto-click       入力スクリプトが尽きた後のクリック待ちを自動でクリックする
+//! --repeat 回数      同じ入力で繰り返し実行して処理時間を集計する
+//! --max-frames 数    打ち切るフレーム数
+//! --trace            処理したスクリプトの行を全て出力する
+//! --no-render        Render() を呼び出さない
+//! --full-redraw      描画内容が変化していないフレームも Render() を呼び出す
+//! --profile ファイル  処理単位毎の処理時間を計測して trace event 形式で保存する(frame_profiler.cpp 参照)
+//! --line-profile ファイル  スクリプトの行、コマンド、ラベルの区間毎の処理時間を保存する(script_profiler.cpp 参照)
+//! --alloc-report ファイル  処理単位毎のメモリ確保の集計を保存する(alloc_tracker.cpp 参照)
+//! --log ファイル     スクリプトの診断ログを保存する(logger.cpp 参照)
+//! --exec-trace ファイル  実行した行と状態の遷移を保存する(execution_trace.cpp 参照)
+//! --metrics ファイル  計測値を Prometheus のテキスト形式で定期的に保存する(metrics_exporter.cpp 参照)
+//! --metrics-interval ミリ秒  --metrics の保存間隔(既定 10000)
+//! --latency ファイル  クリックしてから画面に反映されるまでの遅延を保存する(latency_tracker.cpp 参照)
+//! --memory-report ファイル  構造毎のメモリ使用量と最大値を保存する(memory_footprint.cpp 参照)
+//!
+//! スクリプトの終端まで実行出来たら 0 を、それ以外は 1 を返します。
+//! 繰り返し実行した結果のダイジェストが一致しない場合も 1 を返します。
+//!
+#include "headless_runner.h"
+#include "dx_headless.h"
+#include "input_record.h"
+#include "frame_profiler.h"
+#include "script_profiler.h"
+#include "alloc_tracker.h"
+#include "logger.h"
+#include "execution_trace.h"
+#include "metrics_exporter.h"
+#include "latency_tracker.h"
+#include "memory_footprint.h"
+#include "amg_string.h"
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+namespace {
+    struct Options
+    {
+        std::string scripts_path;
+        std::string input_path;
+        std::string record_path;
+        std::string replay_path;
+        std::string profile_path;
+        std::string line_profile_path;
+        std::string alloc_report_path;
+        std::string log_path;
+        std::string exec_trace_path;
+        std::string metrics_path;
+        std::string latency_path;
+        std::string memory_report_path;
+        int metrics_interval;
+        int repeat;
+        int max_frames;
+        bool is_auto_click;
+        bool is_trace;
+        bool is_render;
+        bool is_full_redraw;
+
+        Options()
+        {
+            metrics_interval = 0;
+            repeat = 1;
+            max_frames = 0;
+            is_auto_click = false;
+            is_trace = false;
+            is_render = true;
+            is_full_redraw = false;
+        }
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: ScriptRunner <scripts.json> [--input file] [--record file] [--replay file] [--auto-click] [--repeat n]"
+            << " [--max-frames n] [--trace] [--no-render] [--full-redraw] [--profile file]"
+            << " [--line-profile file] [--alloc-report file] [--log file]"
+            << " [--exec-trace file] [--metrics file] [--metrics-interval ms] [--latency file] [--memory-report file]" << std::endl;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (auto i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            const auto has_value = (i + 1) < argc;
+
+            if (arg == "--input" && has_value) {
+                options.input_path = argv[++i];
+            }
+            else if (arg == "--record" && has_value) {
+                options.record_path = argv[++i];
+            }
+            else if (arg == "--replay" && has_value) {
+                options.replay_path = argv[++i];
+            }
+            else if (arg == "--profile" && has_value) {
+                options.profile_path = argv[++i];
+            }
+            else if (arg == "--line-profile" && has_value) {
+                options.line_profile_path = argv[++i];
+            }
+            else if (arg == "--alloc-report" && has_value) {
+                options.alloc_report_path = argv[++i];
+            }
+            else if (arg == "--log" && has_value) {
+                options.log_path = argv[++i];
+            }
+            else if (arg == "--exec-trace" && has_value) {
+                options.exec_trace_path = argv[++i];
+            }
+            else if (arg == "--metrics" && has_value) {
+                options.metrics_path = argv[++i];
+            }
+            else if (arg == "--latency" && has_value) {
+                options.latency_path = argv[++i];
+            }
+            else if (arg == "--memory-report" && has_value) {
+                options.memory_report_path = argv[++i];
+            }
+            else if (arg == "--metrics-interval" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.metrics_interval)) {
+                    return false;
+                }
+            }
+            else if (arg == "--repeat" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.repeat)) {
+                    return false;
+                }
+            }
+            else if (arg == "--max-frames" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.max_frames)) {
+                    return false;
+                }
+            }
+            else if (arg == "--auto-click") {
+                options.is_auto_click = true;
+            }
+            else if (arg == "--trace") {
+                options.is_trace = true;
+            }
+            else if (arg == "--no-render") {
+                options.is_render = false;
+            }
+            else if (arg == "--full-redraw") {
+                options.is_full_redraw = true;
+            }
+            else if (options.scripts_path.empty() && arg[0] != '-') {
+                options.scripts_path = arg;
+            }
+            else {
+                return false;
+            }
+        }
+
+        return !options.scripts_path.empty() && options.repeat > 0 && options.max_frames >= 0 && options.metrics_interval >= 0;
+    }
+
+    std::string GetDirectory(const std::string& path)
+    {
+        const auto position = path.find_last_of("/\\");
+
+        if (position == std::string::npos) {
+            return "";
+        }
+
+        return path.substr(0, position);
+    }
+
+    const char* ToString(const amg::HeadlessRunner::StopReason reason)
+    {
+        switch (reason) {
+        case amg::HeadlessRunner::StopReason::END: return "END";
+        case amg::HeadlessRunner::StopReason::EXIT: return "EXIT";
+        case amg::HeadlessRunner::StopReason::INPUT_EXHAUSTED: return "INPUT_EXHAUSTED";
+        case amg::HeadlessRunner::StopReason::FRAME_LIMIT: return "FRAME_LIMIT";
+        case amg::HeadlessRunner::StopReason::INPUT_ERROR: return "INPUT_ERROR";
+        case amg::HeadlessRunner::StopReason::INITIALIZE_ERROR: return "INITIALIZE_ERROR";
+        }
+
+        return "UNKNOWN";
+    }
+
+    const char* ToString(const amg::ScriptEngine::ScriptState state)
+    {
+        switch (state) {
+        case amg::ScriptEngine::ScriptState::PARSING: return "PARSING";
+        case amg::ScriptEngine::ScriptState::TIME_WAIT: return "TIME_WAIT";
+        case amg::ScriptEngine::ScriptState::CLICK_WAIT: return "CLICK_WAIT";
+        case amg::ScriptEngine::ScriptState::CHOICE_WAIT: return "CHOICE_WAIT";
+        case amg::ScriptEngine::ScriptState::END: return "END";
+        }
+
+        return "UNKNOWN";
+    }
+
+    void PrintResult(const amg::HeadlessRunner::Result& result)
+    {
+        std::cout << "reason: " << ToString(result.reason) << std::endl;
+        std::cout << "state: " << ToString(result.state) << std::endl;
+        std::cout << "line: " << result.line << std::endl;
+        std::cout << "frames: " << result.frames << std::endl;
+        std::cout << "clicks: " << result.clicks << std::endl;
+        std::cout << "choices: " << result.choices << std::endl;
+        std::cout << "executed_lines: " << result.executed_lines << std::endl;
+        std::cout << "redraw_frames: " << result.redraw_frames << std::endl;
+        std::cout << "draw_calls: " << result.draw_calls << std::endl;
+        std::cout << "state_changes: " << result.state_changes << std::endl;
+        std::cout << "text_cache: hits=" << result.text_cache_hits << " misses=" << result.text_cache_misses << std::endl;
+        std::cout << "digest: " << std::hex << result.digest << std::dec << std::endl;
+        std::cout << "initialize_ms: " << result.initialize_ms << std::endl;
+        std::cout << "run_ms: " << result.run_ms << std::endl;
+    }
+
+    void PrintProfile(const amg::FrameProfiler& profiler)
+    {
+        for (auto i = 0U; i < static_cast<unsigned int>(amg::FrameProfiler::Phase::NUM); ++i) {
+            const auto phase = static_cast<amg::FrameProfiler::Phase>(i);
+            amg::FrameProfiler::Stats stats;
+
+            if (!profiler.GetStats(phase, stats)) {
+                continue;
+            }
+
+            std::cout << "profile: " << amg::FrameProfiler::GetName(phase) << " p50_us=" << stats.p50_us
+                << " p99_us=" << stats.p99_us << " max_us=" << stats.max_us << " frames=" << stats.frames << std::endl;
+        }
+    }
+
+    void PrintAllocStats()
+    {
+        amg::AllocTracker::Stats stats;
+
+        for (auto i = 0U; i < static_cast<unsigned int>(amg::AllocTracker::Subsystem::NUM); ++i) {
+            const auto subsystem = static_cast<amg::AllocTracker::Subsystem>(i);
+
+            amg::AllocTracker::GetStats(subsystem, stats);
+
+            std::cout << "alloc: " << amg::AllocTracker::GetName(subsystem) << " count=" << stats.count
+                << " bytes=" << stats.bytes << " live_bytes=" << stats.live_bytes
+                << " peak_live_bytes=" << stats.peak_live_bytes << std::endl;
+        }
+
+        amg::AllocTracker::GetTotalStats(stats);
+
+        std::cout << "alloc: Total count=" << stats.count << " bytes=" << stats.bytes
+            << " live_bytes=" << stats.live_bytes << " peak_live_bytes=" << stats.peak_live_bytes << std::endl;
+    }
+
+    void PrintLatency(const amg::LatencyTracker& latency_tracker)
+    {
+        for (auto i = 0U; i < static_cast<unsigned int>(amg::LatencyTracker::Interaction::NUM); ++i) {
+            const auto interaction = static_cast<amg::LatencyTracker::Interaction>(i);
+            amg::LatencyTracker::Stats stats;
+
+            if (!latency_tracker.GetStats(interaction, stats)) {
+                continue;
+            }
+
+            std::cout << "latency: " << amg::LatencyTracker::GetName(interaction) << " count=" << stats.count
+                << " p50_ms=" << stats.p50_ms << " p90_ms=" << stats.p90_ms << " p99_ms=" << stats.p99_ms
+                << " max_ms=" << stats.max_ms << " max_frames=" << stats.max_frames << std::endl;
+        }
+
+        std::cout << "latency: Ignored count=" << latency_tracker.GetIgnoredCount() << std::endl;
+    }
+
+    void PrintMemoryFootprint(const amg::MemoryFootprint& memory_footprint)
+    {
+        amg::MemoryFootprint::Stats stats;
+
+        for (auto i = 0U; i < static_cast<unsigned int>(amg::MemoryFootprint::Part::NUM); ++i) {
+            const auto part = static_cast<amg::MemoryFootprint::Part>(i);
+
+            memory_footprint.GetStats(part, stats);
+
+            std::cout << "memory: " << amg::MemoryFootprint::GetName(part) << " count=" << stats.count
+                << " peak_count=" << stats.peak_count << " bytes=" << stats.bytes
+                << " peak_bytes=" << stats.peak_bytes << std::endl;
+        }
+
+        memory_footprint.GetTotalStats(stats);
+
+        std::cout << "memory: Total bytes=" << stats.bytes << " peak_bytes=" << stats.peak_bytes << std::endl;
+    }
+
+    void PrintTrace(const amg::HeadlessRunner::Result& result)
+    {
+        for (auto&& entry : result.trace) {
+            std::cout << "trace: frame=" << entry.frame << " line=" << entry.line
+                << " command=" << entry.command << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    amg::InputScript input;
+
+    if (!options.input_path.empty() && !input.Load(options.input_path)) {
+        std::cerr << "input script error: " << options.input_path << " line " << input.GetErrorLine() << std::endl;
+        return 1;
+    }
+
+    amg::InputRecorder recorder;
+    amg::InputReplayer replayer;
+
+    if (!options.replay_path.empty() && !replayer.Load(options.replay_path)) {
+        std::cerr << "replay load error: " << options.replay_path << std::endl;
+        return 1;
+    }
+
+    // スクリプト内の画像パスは Json ファイルからの相対パス
+    amg::DxHeadless::SetBaseDirectory(GetDirectory(options.scripts_path));
+
+    amg::HeadlessRunner runner;
+    amg::FrameProfiler profiler;
+    amg::ScriptProfiler script_profiler;
+    amg::ExecutionTrace execution_trace;
+    amg::MetricsExporter metrics;
+    amg::LatencyTracker latency_tracker;
+    amg::MemoryFootprint memory_footprint;
+
+    if (!options.record_path.empty()) {
+        runner.SetRecorder(&recorder);
+    }
+
+    if (!options.replay_path.empty()) {
+        runner.SetReplayer(&replayer);
+    }
+
+    if (!options.profile_path.empty()) {
+        runner.SetProfiler(&profiler);
+    }
+
+    // 繰り返し実行した場合、最大値は全ての実行の最大値になる
+    if (!options.memory_report_path.empty()) {
+        runner.SetMemoryFootprint(&memory_footprint);
+    }
+
+    // 繰り返し実行した場合は全ての実行の合計になる(フレーム数は毎回同じ)
+    if (!options.latency_path.empty()) {
+        runner.SetLatencyTracker(&latency_tracker);
+    }
+
+    // 繰り返し実行した場合は全ての実行を続けて記録する(古い記録から上書き)
+    if (!options.exec_trace_path.empty()) {
+        runner.SetExecutionTrace(&execution_trace);
+    }
+
+    // 繰り返し実行した場合は全ての実行の合計になる
+    if (!options.line_profile_path.empty()) {
+        if (!script_profiler.Initialize(options.scripts_path.c_str())) {
+            std::cerr << "line profile error: " << options.scripts_path << std::endl;
+            return 1;
+        }
+
+        runner.SetListener(&script_profiler);
+    }
+
+    runner.SetAutoClick(options.is_auto_click);
+    runner.SetRender(options.is_render);
+    runner.SetFullRedraw(options.is_full_redraw);
+    runner.SetTrace(options.is_trace);
+
+    if (options.max_frames > 0) {
+        runner.SetMaxFrames(static_cast<unsigned int>(options.max_frames));
+    }
+
+    if (!options.log_path.empty() && !amg::Logger::Initialize(options.log_path)) {
+        std::cerr << "log open error: " << options.log_path << std::endl;
+        return 1;
+    }
+
+    // 耐久テストの為に全ての繰り返しの合計を出力し続ける
+    if (!options.metrics_path.empty()) {
+        if (!metrics.Start(options.metrics_path, static_cast<unsigned int>(options.metrics_interval))) {
+            std::cerr << "metrics open error: " << options.metrics_path << std::endl;
+            return 1;
+        }
+
+        runner.SetMetrics(&metrics);
+    }
+
+    amg::HeadlessRunner::Result result;
+    auto is_end = false;
+    auto is_deterministic = true;
+    auto first_digest = 0ULL;
+    auto total_ms = 0.0;
+    auto min_ms = 0.0;
+    auto max_ms = 0.0;
+
+    for (auto i = 0; i < options.repeat; ++i) {
+        is_end = runner.Run(options.scripts_path.c_str(), input, result);
+
+        const auto run_ms = result.initialize_ms + result.run_ms;
+
+        total_ms += run_ms;
+        min_ms = (i == 0) ? run_ms : std::min(min_ms, run_ms);
+        max_ms = (i == 0) ? run_ms : std::max(max_ms, run_ms);
+
+        if (i == 0) {
+            first_digest = result.digest;
+        }
+        else if (result.digest != first_digest) {
+            is_deterministic = false;
+        }
+
+        // 初期化に失敗したら繰り返しても同じ
+        if (result.reason == amg::HeadlessRunner::StopReason::INITIALIZE_ERROR) {
+            break;
+        }
+    }
+
+    amg::Logger::Destroy();
+    metrics.Stop();
+
+    if (!options.record_path.empty() && !recorder.Save(options.record_path)) {
+        std::cerr << "record save error: " << options.record_path << std::endl;
+        return 1;
+    }
+
+    if (options.is_trace) {
+        PrintTrace(result);
+    }
+
+    PrintResult(result);
+
+    if (!options.profile_path.empty()) {
+        PrintProfile(profiler);
+
+        if (!profiler.SaveTrace(options.profile_path)) {
+            std::cerr << "profile save error: " << options.profile_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.exec_trace_path.empty() && !execution_trace.Save(options.exec_trace_path)) {
+        std::cerr << "exec trace save error: " << options.exec_trace_path << std::endl;
+        return 1;
+    }
+
+    if (!options.latency_path.empty()) {
+        PrintLatency(latency_tracker);
+
+        if (!latency_tracker.SaveReport(options.latency_path)) {
+            std::cerr << "latency save error: " << options.latency_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.memory_report_path.empty()) {
+        PrintMemoryFootprint(memory_footprint);
+
+        if (!memory_footprint.SaveReport(options.memory_report_path)) {
+            std::cerr << "memory report save error: " << options.memory_report_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.line_profile_path.empty() && !script_profiler.SaveReport(options.line_profile_path)) {
+        std::cerr << "line profile save error: " << options.line_profile_path << std::endl;
+        return 1;
+    }
+
+    if (!options.alloc_report_path.empty()) {
+        PrintAllocStats();
+
+        if (!amg::AllocTracker::SaveReport(options.alloc_report_path)) {
+            std::cerr << "alloc report save error: " << options.alloc_report_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.repeat > 1) {
+        const auto average_ms = total_ms / options.repeat;
+
+        std::cout << "repeat: " << options.repeat << std::endl;
+        std::cout << "total_ms: " << total_ms << std::endl;
+        std::cout << "min_ms: " << min_ms << std::endl;
+        std::cout << "average_ms: " << average_ms << std::endl;
+        std::cout << "max_ms: " << max_ms << std::endl;
+        std::cout << "deterministic: " << (is_deterministic ? "yes" : "no") << std::endl;
+
+        if (average_ms > 0.0) {
+            std::cout << "runs_per_minute: " << (60000.0 / average_ms) << std::endl;
+        }
+    }
+
+    return (is_end && is_deterministic) ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+﻿//!
+//! @file decoder_main.cpp
+//!
+//! @brief ExecutionTrace で保存したファイルをスクリプトと照らし合わせて表示するツールのエントリーポイント
+//!
+//! @details
+//! 使い方: TraceDecoder トレース.bin スクリプト.json [オプション]
+//!
+//! --last 件数        最後の指定件数のみ表示する
+//!
+//! 記録を古い順に 1 行ずつ、フレーム番号、行番号、処理中のラベル、スクリプトの内容で出力します。
+//! 状態の遷移は遷移後の状態を出力します。
+//! 最後にフレームの範囲と最後の状態を出力するので、クラッシュやカクつきの直前に何をしていたかを確認出来ます。
+//!
+//! 読み込めたら 0 を、それ以外は 1 を返します。
+//!
+#include "execution_trace.h"
+#include "scripts_data.h"
+#include "amg_string.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr auto COMMAND_LABEL = 'l';
+
+    struct Options
+    {
+        std::string trace_path;
+        std::string scripts_path;
+        int last;
+
+        Options()
+        {
+            last = 0;
+        }
+    };
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: TraceDecoder <trace.bin> <scripts.json> [--last n]" << std::endl;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (auto i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto has_value = (i + 1) < argc;
+
+            if (arg == "--last" && has_value) {
+                if (!amg::string::ToInt(argv[++i], options.last)) {
+                    return false;
+                }
+            }
+            else if (options.trace_path.empty() && arg[0] != '-') {
+                options.trace_path = arg;
+            }
+            else if (options.scripts_path.empty() && arg[0] != '-') {
+                options.scripts_path = arg;
+            }
+            else {
+                return false;
+            }
+        }
+
+        return !options.trace_path.empty() && !options.scripts_path.empty() && options.last >= 0;
+    }
+
+    const char* ToString(const amg::ScriptEngine::ScriptState state)
+    {
+        switch (state) {
+        case amg::ScriptEngine::ScriptState::PARSING: return "PARSING";
+        case amg::ScriptEngine::ScriptState::TIME_WAIT: return "TIME_WAIT";
+        case amg::ScriptEngine::ScriptState::CLICK_WAIT: return "CLICK_WAIT";
+        case amg::ScriptEngine::ScriptState::CHOICE_WAIT: return "CHOICE_WAIT";
+        case amg::ScriptEngine::ScriptState::END: return "END";
+        }
+
+        return "UNKNOWN";
+    }
+
+    //!
+    //! @brief スクリプトの行毎の表示用の文字列とラベルを作る
+    //!
+    void BuildLines(const amg::ScriptsData& scripts_data, std::vector<std::string>& lines, std::vector<std::string>& labels)
+    {
+        const auto script_num = scripts_data.GetScriptNum();
+        std::string label;
+
+        lines.clear();
+        labels.clear();
+
+        for (auto i = 0U; i < script_num; ++i) {
+            const auto script = scripts_data.GetScript(i);
+            std::string line;
+
+            for (auto&& column : script) {
+                line += line.empty() ? column : (", " + column);
+            }
+
+            if (!script.empty() && !script[0].empty() && script[0][0] == COMMAND_LABEL && script.size() > 1) {
+                label = script[1];
+            }
+
+            lines.emplace_back(line);
+            labels.emplace_back(label);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<amg::ExecutionTrace::Entry> entries;
+
+    if (!amg::ExecutionTrace::Load(options.trace_path, entries)) {
+        std::cerr << "trace load error: " << options.trace_path << std::endl;
+        return 1;
+    }
+
+    amg::ScriptsData scripts_data;
+
+    if (!scripts_data.LoadJson(options.scripts_path.c_str())) {
+        std::cerr << "scripts load error: " << options.scripts_path << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    std::vector<std::string> labels;
+
+    BuildLines(scripts_data, lines, labels);
+
+    const auto last = static_cast<size_t>(options.last);
+    const auto first = (last > 0 && entries.size() > last) ? (entries.size() - last) : 0;
+    auto state = amg::ScriptEngine::ScriptState::PARSING;
+
+    for (auto i = 0U; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        const auto is_valid_line = entry.line < lines.size();
+
+        // 表示しない記録も最後の状態の為に状態の遷移は追う
+        if (entry.kind == amg::ExecutionTrace::Kind::STATE) {
+            state = static_cast<amg::ScriptEngine::ScriptState>(entry.value);
+        }
+
+        if (i < first) {
+            continue;
+        }
+
+        std::cout << "frame " << entry.frame << "\tline " << entry.line << "\t["
+            << (is_valid_line ? labels[entry.line] : "") << "]\t";
+
+        if (entry.kind == amg::ExecutionTrace::Kind::STATE) {
+            std::cout << "-> " << ToString(state) << std::endl;
+        }
+        else if (is_valid_line) {
+            std::cout << lines[entry.line] << std::endl;
+        }
+        else {
+            std::cout << "(out of range) " << static_cast<char>(entry.value) << std::endl;
+        }
+    }
+
+    if (!entries.empty()) {
+        std::cout << "entries: " << (entries.size() - first) << " / " << entries.size() << std::endl;
+        std::cout << "frames: " << entries[first].frame << " - " << entries.back().frame << std::endl;
+        std::cout << "last_line: " << entries.back().line << std::endl;
+    }
+
+    std::cout << "last_state: " << ToString(state) << std::endl;
+
+    return 0;
+}